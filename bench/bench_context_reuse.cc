@@ -0,0 +1,133 @@
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory_resource>
+#include <vector>
+
+#include "rs274letter/Serializer.h"
+
+#include "tests/allocation_counter.h"
+
+// Back-to-back small programs, like a batch server runs them:
+//  - a new Serializer for each program, on the global heap
+//  - one Serializer reset with ResetMode::KEEP_CAPACITY, on the global heap
+//  - one Serializer reset with ResetMode::KEEP_CAPACITY, on a pool resource
+// The programs are parsed before, the time and the heap allocations of
+// reset + link + execute are measured.
+// usage: bench_context_reuse [program_count]
+
+static const char* s_program_list[] = {
+R"(
+    #1 = 10
+    #<feed> = 1200
+    G90 G01 X#1 Y[#1 * 2] F#<feed>
+    G00 Z5
+)",
+R"(
+    #<i> = 0
+    o1 while [#<i> LT 10]
+        G01 X[#<i> * 0.5] Y[sin[#<i> * 36]]
+        #<i> = [#<i> + 1]
+    o1 endwhile
+)",
+R"(
+    o<hole> sub
+        G00 X#1 Y#2
+        G01 Z-2 F300
+        G00 Z5
+    o<hole> endsub
+    o2 repeat [4]
+        o<hole> call [#<_value_returned> * 10] [5]
+    o2 endrepeat
+)",
+};
+
+struct Result {
+    double us_per_program = 0;
+    double allocations_per_program = 0;
+    std::size_t command_count = 0;
+};
+
+// the ASTs are moved into the Serializer, so each run gets its own copies
+static std::vector<rs274letter::AstObject> make_ast_list(
+    const std::vector<rs274letter::AstObject>& parsed_list, std::size_t program_count) {
+    std::vector<rs274letter::AstObject> ast_list;
+    ast_list.reserve(program_count);
+    for (std::size_t i = 0; i < program_count; ++i) {
+        ast_list.push_back(parsed_list[i % parsed_list.size()]);
+    }
+    return ast_list;
+}
+
+static Result run(std::vector<rs274letter::AstObject> ast_list,
+    const std::function<std::size_t(rs274letter::AstObject&&)>& run_one) {
+    Result result;
+
+    auto count_before = rs274letter::test::GetAllocationCount();
+    auto start = std::chrono::steady_clock::now();
+    for (auto& ast : ast_list) {
+        result.command_count += run_one(std::move(ast));
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    result.us_per_program = std::chrono::duration<double, std::micro>(end - start).count() / ast_list.size();
+    result.allocations_per_program = static_cast<double>(rs274letter::test::GetAllocationCount() - count_before) / ast_list.size();
+    return result;
+}
+
+static void print(const char* name, const Result& result) {
+    std::cout << name << ": " << result.us_per_program << " us/program, "
+              << result.allocations_per_program << " allocations/program, "
+              << result.command_count << " commands" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::size_t program_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 3000;
+    if (program_count == 0) program_count = 1;
+
+    using rs274letter::Serializer;
+
+    try {
+        std::vector<rs274letter::AstObject> parsed_list;
+        for (auto&& code : s_program_list) {
+            parsed_list.push_back(rs274letter::Parser::parse(code));
+        }
+
+        auto fresh = run(make_ast_list(parsed_list, program_count), [](rs274letter::AstObject&& ast) {
+            Serializer s(std::move(ast));
+            s.processProgram();
+            return s.getCommandList().size();
+        });
+
+        Serializer heap_serializer;
+        auto reused = run(make_ast_list(parsed_list, program_count), [&](rs274letter::AstObject&& ast) {
+            heap_serializer.reset(std::move(ast), Serializer::ResetMode::KEEP_CAPACITY);
+            heap_serializer.processProgram();
+            return heap_serializer.getCommandList().size();
+        });
+
+        std::pmr::unsynchronized_pool_resource pool;
+        Serializer pool_serializer(&pool);
+        auto pooled = run(make_ast_list(parsed_list, program_count), [&](rs274letter::AstObject&& ast) {
+            pool_serializer.reset(std::move(ast), Serializer::ResetMode::KEEP_CAPACITY);
+            pool_serializer.processProgram();
+            return pool_serializer.getCommandList().size();
+        });
+
+        std::cout << "programs: " << program_count << std::endl;
+        print("new Serializer each program", fresh);
+        print("reused Serializer, global heap", reused);
+        print("reused Serializer, pool resource", pooled);
+
+        if (fresh.command_count != reused.command_count || fresh.command_count != pooled.command_count) {
+            std::cout << "the command counts differ" << std::endl;
+            return 1;
+        }
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
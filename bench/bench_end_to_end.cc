@@ -0,0 +1,20 @@
+#include "bench_harness.h"
+
+#include "rs274letter/Serializer.h"
+
+// From the source to the commands: parse, link and execute each file
+// with a new Serializer, items are commands.
+
+int main(int argc, char** argv) {
+    try {
+        return rs274letter::bench::Run(argc, argv, "end_to_end", "commands",
+            [](const rs274letter::bench::CorpusFile& file) {
+                rs274letter::Serializer s(rs274letter::Parser::parse(file.code));
+                s.processProgram();
+                return s.getCommandList().size();
+            });
+    } catch (rs274letter::Exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,280 @@
+// bench_harness.h
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rs274letter/util.h"
+#include "tests/allocation_counter.h"
+
+/**
+ * The self-contained harness of the benchmarks in this directory.
+ * Each benchmark runs a function over each file of the corpus:
+ *  - `warmup` runs which are not measured, then `repetitions` measured runs
+ *  - the median, p99, min and mean of the run times
+ *  - bytes/s, lines/s and items/s (tokens, statements, commands...) from the median
+ *  - the heap allocations per line and the peak heap bytes of one more run,
+ *    which is not timed. The global operator new is replaced by
+ *    tests/allocation_counter.h, so include this harness in one source file.
+ *  - the extra metrics of a benchmark, set on the Result by the caller
+ * The results are printed as one JSON document to stdout. std::cout is
+ * discarded while measuring, the Tokenizer prints the comments to it.
+ * usage: bench_xxx [--warmup N] [--repetitions N] [--corpus DIR] [--output FILE]
+*/
+
+#ifndef RS274LETTER_BENCH_CORPUS_DIR
+#define RS274LETTER_BENCH_CORPUS_DIR "corpus"
+#endif
+
+namespace rs274letter { namespace bench
+{
+
+struct Options {
+    std::size_t warmup = 3;
+    std::size_t repetitions = 30;
+    std::string corpus_dir = RS274LETTER_BENCH_CORPUS_DIR;
+    std::string output_file; // stdout if empty
+};
+
+struct CorpusFile {
+    std::string name;
+    std::string code;
+    std::size_t lines = 0;
+};
+
+struct Result {
+    std::string input;
+    std::size_t bytes = 0;
+    std::size_t lines = 0;
+    std::size_t items = 0; // counted by the last run
+    std::size_t allocations = 0; // of one run
+    std::size_t peak_bytes = 0; // the heap bytes in use at the peak of one run, more than before it
+    std::vector<std::pair<std::string, double>> extra_metric_list; // printed after the others
+
+    double median_ns = 0;
+    double p99_ns = 0;
+    double min_ns = 0;
+    double mean_ns = 0;
+};
+
+inline Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--warmup" && has_value) {
+            options.warmup = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--repetitions" && has_value) {
+            options.repetitions = std::max<std::size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--corpus" && has_value) {
+            options.corpus_dir = argv[++i];
+        } else if (arg == "--output" && has_value) {
+            options.output_file = argv[++i];
+        } else {
+            std::cerr << "unknown argument: " << arg << "\n"
+                      << "usage: " << argv[0]
+                      << " [--warmup N] [--repetitions N] [--corpus DIR] [--output FILE]" << std::endl;
+            std::exit(2);
+        }
+    }
+    return options;
+}
+
+inline std::size_t CountLines(const std::string& code) {
+    auto lines = static_cast<std::size_t>(std::count(code.begin(), code.end(), '\n'));
+    if (!code.empty() && code.back() != '\n') ++lines;
+    return lines;
+}
+
+/**
+ * LoadCorpus()
+ * the *.ngc files of the directory, ordered by name
+*/
+inline std::vector<CorpusFile> LoadCorpus(const std::string& corpus_dir) {
+    std::vector<CorpusFile> corpus;
+
+    std::error_code ec;
+    for (auto&& entry : std::filesystem::directory_iterator(corpus_dir, ec)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".ngc") continue;
+
+        std::ifstream ifs(entry.path(), std::ios::binary);
+        std::stringstream ss;
+        ss << ifs.rdbuf();
+
+        CorpusFile file;
+        file.name = entry.path().filename().string();
+        file.code = ss.str();
+        file.lines = CountLines(file.code);
+        corpus.push_back(std::move(file));
+    }
+
+    if (ec || corpus.empty()) {
+        std::cerr << "no *.ngc file in the corpus directory: " << corpus_dir << std::endl;
+        std::exit(2);
+    }
+
+    std::sort(corpus.begin(), corpus.end(),
+        [](const CorpusFile& a, const CorpusFile& b) { return a.name < b.name; });
+    return corpus;
+}
+
+/**
+ * Measure()
+ * run `f` warmup + repetitions times, `f` returns the count of the items it handled
+*/
+template <typename F>
+Result Measure(const CorpusFile& file, const Options& options, F&& f) {
+    Result result;
+    result.input = file.name;
+    result.bytes = file.code.size();
+    result.lines = file.lines;
+
+    for (std::size_t i = 0; i < options.warmup; ++i) {
+        result.items = f();
+    }
+
+    std::vector<double> time_list;
+    time_list.reserve(options.repetitions);
+    for (std::size_t i = 0; i < options.repetitions; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        result.items = f();
+        auto end = std::chrono::steady_clock::now();
+        time_list.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+
+    // one more run, not timed, for the allocations and the peak of the heap
+    {
+        auto live_bytes = test::GetLiveBytes();
+        test::RestartPeakLiveBytes();
+        test::AllocationScope allocation_scope;
+        f();
+        result.allocations = allocation_scope.getCount();
+        result.peak_bytes = test::GetPeakLiveBytes() - live_bytes;
+    }
+
+    std::sort(time_list.begin(), time_list.end());
+    auto n = time_list.size();
+    result.median_ns = n % 2 ? time_list[n / 2] : (time_list[n / 2 - 1] + time_list[n / 2]) / 2;
+    // nearest rank
+    result.p99_ns = time_list[static_cast<std::size_t>(std::ceil(0.99 * n)) - 1];
+    result.min_ns = time_list.front();
+    double sum = 0;
+    for (auto t : time_list) sum += t;
+    result.mean_ns = sum / n;
+
+    return result;
+}
+
+inline std::string JsonString(const std::string& str) {
+    std::string out = "\"";
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            std::stringstream ss;
+            ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c);
+            out += ss.str();
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+inline void PrintJson(std::ostream& out, const std::string& benchmark, const std::string& item_name,
+    const Options& options, const std::vector<Result>& result_list) {
+    auto per_second = [](double count, double ns) { return ns > 0 ? count * 1e9 / ns : 0.0; };
+
+    out << std::setprecision(10);
+    out << "{\n"
+        << "  \"benchmark\": " << JsonString(benchmark) << ",\n"
+        << "  \"item\": " << JsonString(item_name) << ",\n"
+        << "  \"warmup\": " << options.warmup << ",\n"
+        << "  \"repetitions\": " << options.repetitions << ",\n"
+        << "  \"results\": [";
+
+    for (std::size_t i = 0; i < result_list.size(); ++i) {
+        auto&& r = result_list[i];
+        out << (i ? "," : "") << "\n    {"
+            << "\"input\": " << JsonString(r.input)
+            << ", \"bytes\": " << r.bytes
+            << ", \"lines\": " << r.lines
+            << ", \"items\": " << r.items
+            << ", \"median_ns\": " << r.median_ns
+            << ", \"p99_ns\": " << r.p99_ns
+            << ", \"min_ns\": " << r.min_ns
+            << ", \"mean_ns\": " << r.mean_ns
+            << ", \"bytes_per_second\": " << per_second(r.bytes, r.median_ns)
+            << ", \"lines_per_second\": " << per_second(r.lines, r.median_ns)
+            << ", \"items_per_second\": " << per_second(r.items, r.median_ns)
+            << ", \"allocations\": " << r.allocations
+            << ", \"allocations_per_line\": " << (r.lines ? static_cast<double>(r.allocations) / r.lines : 0.0)
+            << ", \"peak_bytes\": " << r.peak_bytes;
+        for (auto&& [name, value] : r.extra_metric_list) {
+            out << ", " << JsonString(name) << ": " << value;
+        }
+        out << "}";
+    }
+
+    out << "\n  ]\n}" << std::endl;
+}
+
+/**
+ * Output()
+ * print the JSON to the --output file, or to stdout
+*/
+inline int Output(const std::string& benchmark, const std::string& item_name,
+    const Options& options, const std::vector<Result>& result_list) {
+    if (options.output_file.empty()) {
+        PrintJson(std::cout, benchmark, item_name, options, result_list);
+    } else {
+        std::ofstream ofs(options.output_file);
+        if (!ofs.is_open()) {
+            std::cerr << "cannot open output file: " << options.output_file << std::endl;
+            return 2;
+        }
+        PrintJson(ofs, benchmark, item_name, options, result_list);
+    }
+    return 0;
+}
+
+/**
+ * Run()
+ * the main of a benchmark: measure `f(file)` over the corpus and print the JSON
+*/
+template <typename F>
+int Run(int argc, char** argv, const std::string& benchmark, const std::string& item_name, F&& f) {
+    auto options = ParseOptions(argc, argv);
+    auto corpus = LoadCorpus(options.corpus_dir);
+
+    std::vector<Result> result_list;
+    {
+        rs274letter::util::NullBuffer null_buffer;
+        auto* cout_buffer = std::cout.rdbuf(&null_buffer);
+        try {
+            for (auto&& file : corpus) {
+                result_list.push_back(Measure(file, options, [&]() { return f(file); }));
+            }
+        } catch (...) {
+            std::cout.rdbuf(cout_buffer);
+            throw;
+        }
+        std::cout.rdbuf(cout_buffer);
+    }
+
+    return Output(benchmark, item_name, options, result_list);
+}
+
+} // namespace bench
+} // namespace rs274letter
@@ -0,0 +1,18 @@
+#include "bench_harness.h"
+
+#include "rs274letter/Parser.h"
+
+// Parser::parse() of each file, tokenizing included, items are statements.
+
+int main(int argc, char** argv) {
+    try {
+        return rs274letter::bench::Run(argc, argv, "parser", "statements",
+            [](const rs274letter::bench::CorpusFile& file) {
+                auto ast = rs274letter::Parser::parse(file.code);
+                return ast["body"].as_array().size();
+            });
+    } catch (rs274letter::Exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,79 @@
+#include "bench_harness.h"
+
+#include "rs274letter/Serializer.h"
+
+// The latency of restartFromCommand() as the command index grows, without
+// checkpoints and with a checkpoint every K commands, over one program of
+// 100000 commands. Each input is "interval_K@index", items are the commands
+// skipped to reach the index. With checkpoints the latency should stay flat.
+// The checkpoints recorded and their bytes (MemoryFootprint::checkpoint_bytes)
+// are reported as "checkpoints" and "checkpoint_bytes", the memory cost of K.
+// The corpus directory is not read.
+
+static const char* s_program_code = R"(
+#<row> = 0
+o1 while [#<row> LT 200]
+    #<row> = [#<row> + 1]
+    #<col> = 0
+    #<odd> = 0
+    o2 while [#<col> LT 500]
+        #<col> = [#<col> + 1]
+        #<odd> = [1 - #<odd>]
+        o3 if [#<odd> EQ 0]
+            G01 X[#<col> * 0.1] Y[#<row> * 0.1] F[1000 + sin[#<col>]]
+        o3 else
+            G01 X[#<col> * 0.1] Y[#<row> * 0.1 + 0.05]
+        o3 endif
+    o2 endwhile
+o1 endwhile
+)";
+
+// 0 is no checkpoint
+static const std::size_t s_checkpoint_interval_list[] = { 0, 100, 1000 };
+
+// half of the interval after a checkpoint, for the intervals 100 and 1000
+static const std::size_t s_command_index_list[] = { 1550, 10550, 25550, 50550, 75550, 99550 };
+
+// without checkpoints the latency grows with the index, the first ones show it
+static const std::size_t s_no_checkpoint_max_command_index = 25550;
+
+int main(int argc, char** argv) {
+    auto options = rs274letter::bench::ParseOptions(argc, argv);
+
+    try {
+        auto program = rs274letter::Program::compile(rs274letter::Parser::parse(s_program_code));
+
+        rs274letter::bench::CorpusFile file;
+        file.code = s_program_code;
+        file.lines = rs274letter::bench::CountLines(file.code);
+
+        std::vector<rs274letter::bench::Result> result_list;
+        for (auto interval : s_checkpoint_interval_list) {
+            rs274letter::Serializer s(program);
+            s.setCommandSink(std::make_shared<rs274letter::CallbackCommandSink>(
+                [](const rs274letter::CommandStatement&) {}));
+            s.setCheckpointInterval(interval);
+            s.processProgram();
+
+            auto checkpoint_bytes = s.getMemoryFootprint().checkpoint_bytes;
+            for (auto command_index : s_command_index_list) {
+                if (!interval && command_index > s_no_checkpoint_max_command_index) continue;
+
+                file.name = (interval ? "interval_" + std::to_string(interval) : "no_checkpoint")
+                    + "@" + std::to_string(command_index);
+                auto result = rs274letter::bench::Measure(file, options, [&]() {
+                    s.restartFromCommand(command_index);
+                    return command_index;
+                });
+                result.extra_metric_list.emplace_back("checkpoints", static_cast<double>(s.getCheckpointCount()));
+                result.extra_metric_list.emplace_back("checkpoint_bytes", static_cast<double>(checkpoint_bytes));
+                result_list.push_back(std::move(result));
+            }
+        }
+
+        return rs274letter::bench::Output("restart", "commands skipped", options, result_list);
+    } catch (rs274letter::Exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,35 @@
+#include "bench_harness.h"
+
+#include <map>
+
+#include "rs274letter/Serializer.h"
+
+// The execution of each file: the Programs are compiled before, one
+// Serializer is reset and run on each repetition, items are commands.
+// The commands are counted by a CallbackCommandSink, not stored.
+
+int main(int argc, char** argv) {
+    try {
+        std::map<std::string, rs274letter::Program::ptr> program_map;
+        rs274letter::Serializer s;
+        std::size_t command_count = 0;
+        s.setCommandSink(std::make_shared<rs274letter::CallbackCommandSink>(
+            [&](const rs274letter::CommandStatement&) { ++command_count; }));
+
+        return rs274letter::bench::Run(argc, argv, "serializer", "commands",
+            [&](const rs274letter::bench::CorpusFile& file) {
+                auto& program = program_map[file.name];
+                if (!program) {
+                    program = rs274letter::Program::compile(rs274letter::Parser::parse(file.code));
+                }
+
+                command_count = 0;
+                s.reset(program, rs274letter::Serializer::ResetMode::KEEP_CAPACITY);
+                s.processProgram();
+                return command_count;
+            });
+    } catch (rs274letter::Exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,23 @@
+#include "bench_harness.h"
+
+#include "rs274letter/Exception.h"
+#include "rs274letter/Tokenizer.h"
+
+// The Tokenizer alone: all the tokens of each file, items are tokens.
+
+int main(int argc, char** argv) {
+    try {
+        return rs274letter::bench::Run(argc, argv, "tokenizer", "tokens",
+            [](const rs274letter::bench::CorpusFile& file) {
+                rs274letter::Tokenizer tokenizer(file.code.cbegin(), file.code.cend());
+                std::size_t token_count = 0;
+                while (!tokenizer.getNextToken().empty()) {
+                    ++token_count;
+                }
+                return token_count;
+            });
+    } catch (rs274letter::Exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
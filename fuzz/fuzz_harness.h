@@ -0,0 +1,254 @@
+// fuzz_harness.h
+#pragma once
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+#include "rs274letter/Parser.h"
+#include "rs274letter/Program.h"
+#include "rs274letter/Serializer.h"
+#include "rs274letter/util.h"
+
+/**
+ * The harness of the fuzz targets in this directory, and of
+ * tests/test_fuzz_regression.cc which runs the saved inputs again.
+ * Each input runs on its own thread, whose stack is painted with a pattern
+ * before, so the bytes of the stack used are measured after. An input
+ * fails, not only if it crashes, but if:
+ *  - its time is over `fixed_ns` + `ns_per_byte` for each byte of input,
+ *    the Serializer counts each statement executed as a byte too
+ *  - its stack is over `stack_bytes`
+ *  - it throws anything else than an rs274letter::Exception
+ * The budgets are read from the environment, for slower builds (sanitizers):
+ *  RS274LETTER_FUZZ_FIXED_NS, RS274LETTER_FUZZ_NS_PER_BYTE, RS274LETTER_FUZZ_STACK_BYTES
+ * POSIX only, the stack is given to pthread_create().
+*/
+
+namespace rs274letter { namespace fuzz
+{
+
+struct Budget {
+    std::uint64_t fixed_ns = 20'000'000;
+    std::uint64_t ns_per_byte = 20'000;
+    std::size_t stack_bytes = 512 * 1024;
+
+    static Budget FromEnvironment() {
+        Budget budget;
+        auto read = [](const char* name, auto& value) {
+            if (auto* str = std::getenv(name)) {
+                value = std::strtoull(str, nullptr, 10);
+            }
+        };
+        read("RS274LETTER_FUZZ_FIXED_NS", budget.fixed_ns);
+        read("RS274LETTER_FUZZ_NS_PER_BYTE", budget.ns_per_byte);
+        read("RS274LETTER_FUZZ_STACK_BYTES", budget.stack_bytes);
+        return budget;
+    }
+};
+
+struct Measurement {
+    std::size_t work = 0; // the bytes, and the statements executed
+    std::uint64_t duration_ns = 0;
+    std::size_t stack_bytes = 0;
+    std::string error; // not an rs274letter::Exception
+
+    bool isOverTime(const Budget& budget) const {
+        return duration_ns > budget.fixed_ns + budget.ns_per_byte * work;
+    }
+
+    bool isOverStack(const Budget& budget) const {
+        return stack_bytes > budget.stack_bytes;
+    }
+
+    bool isWithin(const Budget& budget) const {
+        return error.empty() && !isOverTime(budget) && !isOverStack(budget);
+    }
+
+    std::string toString(const Budget& budget) const {
+        std::stringstream ss;
+        ss << "work: " << work
+           << ", time: " << duration_ns << " ns (budget " << budget.fixed_ns + budget.ns_per_byte * work << " ns)"
+           << ", stack: " << stack_bytes << " bytes (budget " << budget.stack_bytes << " bytes)";
+        if (!error.empty()) ss << ", error: " << error;
+        return ss.str();
+    }
+};
+
+/**
+ * The targets: run the code, return the work done, swallow the
+ * rs274letter::Exception which any invalid code throws.
+*/
+inline std::size_t RunTokenizer(const std::string& code) {
+    try {
+        Tokenizer tokenizer(code.cbegin(), code.cend());
+        while (!tokenizer.getNextToken().empty()) {}
+    } catch (Exception&) {}
+    return code.size();
+}
+
+inline std::size_t RunParser(const std::string& code) {
+    try {
+        Parser::parse(code);
+    } catch (Exception&) {}
+    return code.size();
+}
+
+inline std::size_t RunSerializer(const std::string& code) {
+    // bounds the loops and the calls, a tiny program may run forever
+    ExecutionBudget execution_budget;
+    execution_budget.max_statements = 100'000;
+    execution_budget.max_commands = 100'000;
+    execution_budget.max_call_depth = 64;
+    execution_budget.max_duration = std::chrono::milliseconds(1000);
+
+    Serializer s;
+    try {
+        s.reset(Program::compile(Parser::parse(code)));
+        s.setCommandSink(std::make_shared<CallbackCommandSink>([](const CommandStatement&) {}));
+        s.setExecutionBudget(execution_budget);
+        s.processProgram();
+    } catch (Exception&) {}
+    return code.size() + s.getStats().statements;
+}
+
+/**
+ * MeasuredStack
+ * The stack of the measured thread: `kStackFactor` times the budget, so an
+ * input over the budget is still measured, and a guard page below it.
+*/
+class MeasuredStack {
+public:
+    static constexpr std::size_t kStackFactor = 4;
+    static constexpr unsigned char kPaint = 0xA5;
+
+    explicit MeasuredStack(std::size_t budget_bytes) {
+        _page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        auto size = std::max<std::size_t>(budget_bytes * kStackFactor, PTHREAD_STACK_MIN);
+        _stack_size = (size + _page_size - 1) / _page_size * _page_size;
+
+        void* memory = mmap(nullptr, _stack_size + _page_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        _memory = static_cast<unsigned char*>(memory);
+        mprotect(_memory, _page_size, PROT_NONE);
+    }
+
+    ~MeasuredStack() noexcept {
+        munmap(_memory, _stack_size + _page_size);
+    }
+
+    MeasuredStack(const MeasuredStack&) = delete;
+    MeasuredStack& operator=(const MeasuredStack&) = delete;
+
+    unsigned char* getBase() const { return _memory + _page_size; }
+    std::size_t getSize() const { return _stack_size; }
+
+    void paint() { std::memset(this->getBase(), kPaint, _stack_size); }
+
+    /**
+     * getUsedBytes()
+     * the stack grows down: the bytes above the lowest changed byte
+    */
+    std::size_t getUsedBytes() const {
+        auto* base = this->getBase();
+        std::size_t untouched = 0;
+        while (untouched < _stack_size && base[untouched] == kPaint) ++untouched;
+        return _stack_size - untouched;
+    }
+
+private:
+    unsigned char* _memory = nullptr;
+    std::size_t _page_size = 0;
+    std::size_t _stack_size = 0;
+};
+
+/**
+ * Measure()
+ * run `target(code)` on a thread with a measured stack, std::cout is
+ * discarded meanwhile, the Tokenizer prints the comments to it
+*/
+template <typename Target>
+Measurement Measure(const std::string& code, const Budget& budget, Target&& target) {
+    struct Job {
+        const std::string* code;
+        std::remove_reference_t<Target>* target;
+        Measurement measurement;
+    } job { &code, &target, {} };
+
+    static MeasuredStack s_stack(budget.stack_bytes);
+    s_stack.paint();
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, s_stack.getBase(), s_stack.getSize());
+
+    rs274letter::util::NullBuffer null_buffer;
+    auto* cout_buffer = std::cout.rdbuf(&null_buffer);
+
+    pthread_t thread;
+    int rc = pthread_create(&thread, &attr, [](void* arg) -> void* {
+        auto* job = static_cast<Job*>(arg);
+        auto start = std::chrono::steady_clock::now();
+        try {
+            job->measurement.work = (*job->target)(*job->code);
+        } catch (std::exception& e) {
+            job->measurement.error = e.what();
+        } catch (...) {
+            job->measurement.error = "unknown exception";
+        }
+        auto end = std::chrono::steady_clock::now();
+        job->measurement.duration_ns = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        return nullptr;
+    }, &job);
+    if (rc == 0) pthread_join(thread, nullptr);
+
+    std::cout.rdbuf(cout_buffer);
+    pthread_attr_destroy(&attr);
+
+    if (rc != 0) {
+        job.measurement.error = "pthread_create failed";
+        return job.measurement;
+    }
+    job.measurement.stack_bytes = s_stack.getUsedBytes();
+    return job.measurement;
+}
+
+/**
+ * TestOneInput()
+ * the body of LLVMFuzzerTestOneInput(): an input over the budget is
+ * reported and aborts, so the fuzzer saves it like a crash
+*/
+template <typename Target>
+int TestOneInput(const char* target_name, const std::uint8_t* data, std::size_t size, Target&& target) {
+    static const Budget s_budget = Budget::FromEnvironment();
+
+    std::string code(reinterpret_cast<const char*>(data), size);
+    auto measurement = Measure(code, s_budget, target);
+    if (!measurement.isWithin(s_budget)) {
+        std::cerr << "==" << target_name << "== input over the budget, "
+                  << measurement.toString(s_budget) << std::endl;
+        std::abort();
+    }
+    return 0;
+}
+
+} // namespace fuzz
+} // namespace rs274letter
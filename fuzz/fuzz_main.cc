@@ -0,0 +1,59 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// The main of the fuzz targets built without libFuzzer: runs each file
+// given, or each file in a directory given, through LLVMFuzzerTestOneInput,
+// stdin without an argument. AFL runs it with `@@` or with stdin.
+// usage: fuzz_xxx [FILE|DIR]...
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size);
+
+static void run_input(std::istream& is) {
+    std::string input((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    LLVMFuzzerTestOneInput(reinterpret_cast<const std::uint8_t*>(input.data()), input.size());
+}
+
+static bool run_file(const std::filesystem::path& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) {
+        std::cerr << "cannot open: " << path.string() << std::endl;
+        return false;
+    }
+    std::cerr << "running: " << path.string() << std::endl;
+    run_input(ifs);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        run_input(std::cin);
+        return 0;
+    }
+
+    bool opened = true;
+    for (int i = 1; i < argc; ++i) {
+        std::filesystem::path path = argv[i];
+        if (!std::filesystem::is_directory(path)) {
+            opened = run_file(path) && opened;
+            continue;
+        }
+
+        std::vector<std::filesystem::path> path_list;
+        for (auto&& entry : std::filesystem::directory_iterator(path)) {
+            if (entry.is_regular_file()) path_list.push_back(entry.path());
+        }
+        std::sort(path_list.begin(), path_list.end());
+        for (auto&& file : path_list) {
+            opened = run_file(file) && opened;
+        }
+    }
+
+    return opened ? 0 : 2;
+}
@@ -0,0 +1,7 @@
+#include "fuzz_harness.h"
+
+// The serializer over each input, see fuzz_harness.h
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+    return rs274letter::fuzz::TestOneInput("fuzz_serializer", data, size, rs274letter::fuzz::RunSerializer);
+}
@@ -0,0 +1,276 @@
+// AstValidator.cc
+#include "AstValidator.h"
+
+#include <set>
+#include <sstream>
+
+namespace rs274letter
+{
+
+// public static method for validating
+void AstValidator::validate(const AstObject &program,
+    const std::vector<std::shared_ptr<const NativeFunction>> &native_function_list)
+{
+    if (!program.contains("type") || !program.at("type").is_string()
+        || program.at("type").as_string() != "program") {
+        throwInvalid("The root node should be a program", program.to_string());
+    }
+
+    AstValidator validator(native_function_list);
+    validator.validateStatementList(member(program, "body"));
+}
+
+void AstValidator::validateStatementList(const AstValue &statement_list)
+{
+    if (!statement_list.is_array()) {
+        throwInvalid("Should be a statement list", statement_list.to_string());
+    }
+
+    for (const auto& statement : statement_list.as_array()) {
+        this->validateStatement(statement);
+    }
+}
+
+void AstValidator::validateStatement(const AstValue &statement)
+{
+    auto&& statement_type = typeOf(statement);
+    auto&& node = statement.as_object();
+
+    if (statement_type == "commandStatement") {
+        this->validateCommandStatement(node);
+    } else if (statement_type == "expressionStatement") {
+        this->validateExpression(member(node, "expression"));
+    } else if (statement_type == "oIfStatement") {
+        this->validateOIfStatement(node);
+    } else if (statement_type == "oWhileStatement") {
+        this->validateOWord(member(node, "whileOCommand"));
+        this->validateOWord(member(node, "endwhileOCommand"));
+        this->validateExpression(member(node, "test"));
+        this->validateStatementList(member(node, "body"));
+    } else if (statement_type == "oRepeatStatement") {
+        this->validateOWord(member(node, "repeatOCommand"));
+        this->validateOWord(member(node, "endrepeatOCommand"));
+        this->validateExpression(member(node, "times"));
+        this->validateStatementList(member(node, "body"));
+    } else if (statement_type == "oContinueStatement") {
+        this->validateOWord(member(node, "continueOCommand"));
+    } else if (statement_type == "oBreakStatement") {
+        this->validateOWord(member(node, "breakOCommand"));
+    } else if (statement_type == "oSubStatement") {
+        this->validateOWord(member(node, "subOCommand"));
+        this->validateOWord(member(node, "endsubOCommand"));
+        this->validateStatementList(member(node, "body"));
+        this->validateOptionalExpression(member(node, "endsubRtnExpr"));
+    } else if (statement_type == "oReturnStatement") {
+        this->validateOWord(member(node, "returnOCommand"));
+        this->validateOptionalExpression(member(node, "returnRtnExpr"));
+    } else if (statement_type == "oCallStatement") {
+        this->validateOWord(member(node, "callOCommand"));
+
+        auto&& param_list = member(node, "paramList");
+        if (!param_list.is_array()) {
+            throwInvalid("The paramList of oCallStatement should be an array", node.to_string());
+        }
+        for (const auto& param : param_list.as_array()) {
+            this->validateExpression(param);
+        }
+    } else {
+        throwInvalid("Unknown type of statement: " + statement_type, node.to_string());
+    }
+}
+
+void AstValidator::validateCommandStatement(const AstObject &command_statement)
+{
+    auto&& commands = member(command_statement, "commands");
+    if (!commands.is_array()) {
+        throwInvalid("The commands of commandStatement should be an array", command_statement.to_string());
+    }
+
+    for (const auto& command : commands.as_array()) {
+        if (typeOf(command) != "commandNumberGroup") {
+            throwInvalid("Should be a commandNumberGroup", command.to_string());
+        }
+
+        auto&& node = command.as_object();
+        auto&& letter = member(node, "letter");
+        if (!letter.is_string() || letter.as_string().size() != 1
+            || letter.as_string()[0] < 'a' || letter.as_string()[0] > 'z') {
+            throwInvalid("The letter of commandNumberGroup should be one lower case letter", node.to_string());
+        }
+
+        this->validateExpression(member(node, "number"));
+    }
+}
+
+void AstValidator::validateOIfStatement(const AstObject &o_if_statement)
+{
+    // an `elseif` is expanded as an oIfStatement in the `alternate`,
+    // the chain is walked in a loop, it may be long
+    const AstObject* if_statement = &o_if_statement;
+    while (true) {
+        this->validateOWord(member(*if_statement, "ifOCommand"));
+        this->validateExpression(member(*if_statement, "test"));
+        this->validateStatementList(member(*if_statement, "consequent"));
+
+        auto&& other_words_list = member(*if_statement, "otherWordsList");
+        if (!other_words_list.is_array()) {
+            throwInvalid("The otherWordsList of oIfStatement should be an array", if_statement->to_string());
+        }
+        for (const auto& o_word : other_words_list.as_array()) {
+            this->validateOWord(o_word);
+        }
+
+        auto&& alternate = member(*if_statement, "alternate");
+        if (!alternate.is_object()) {
+            this->validateStatementList(alternate);
+            return;
+        }
+        if (typeOf(alternate) != "oIfStatement") {
+            throwInvalid("The alternate of oIfStatement should be an oIfStatement or a statement list",
+                alternate.to_string());
+        }
+        if_statement = &alternate.as_object();
+    }
+}
+
+void AstValidator::validateOWord(const AstValue &o_word)
+{
+    auto&& o_word_type = typeOf(o_word);
+
+    if (o_word_type == "nameIndexOCommand") {
+        if (!member(o_word.as_object(), "index").is_string()) {
+            throwInvalid("The index of nameIndexOCommand should be a string", o_word.to_string());
+        }
+    } else if (o_word_type == "numberIndexOCommand") {
+        this->validateExpression(member(o_word.as_object(), "index"));
+    } else {
+        throwInvalid("Should be an o-word", o_word.to_string());
+    }
+}
+
+void AstValidator::validateExpression(const AstValue &expression)
+{
+    static const std::set<std::string> s_binary_operator_set = {
+        "+", "-", "*", "/", "**",
+        ">", "<", ">=", "<=", "==", "!=",
+        "gt", "lt", "ge", "le", "eq", "ne",
+        "and", "or", "xor"
+    };
+
+    auto&& expression_type = typeOf(expression);
+    auto&& node = expression.as_object();
+
+    if (expression_type == "doubleNumericLiteral" || expression_type == "integerNumericLiteral") {
+        if (!member(node, "value").is_number()) {
+            throwInvalid("The value of " + expression_type + " should be a number", node.to_string());
+        }
+    } else if (expression_type == "binaryExpression") {
+        auto&& op = member(node, "operator");
+        if (!op.is_string() || s_binary_operator_set.count(op.as_string()) == 0) {
+            throwInvalid("Unexpected operator of binaryExpression", node.to_string());
+        }
+        this->validateExpression(member(node, "left"));
+        this->validateExpression(member(node, "right"));
+    } else if (expression_type == "assignmentExpression") {
+        this->validateVariable(member(node, "left"));
+        this->validateExpression(member(node, "right"));
+    } else if (expression_type == "numberIndexVariable" || expression_type == "nameIndexVariable") {
+        this->validateVariable(expression);
+    } else if (expression_type == "insideFunctionExpression") {
+        this->validateInsideFunctionExpression(node);
+    } else {
+        throwInvalid("Unknown type of expression: " + expression_type, node.to_string());
+    }
+}
+
+void AstValidator::validateOptionalExpression(const AstValue &expression)
+{
+    if (expression.is_object() && expression.as_object().empty()) return;
+
+    this->validateExpression(expression);
+}
+
+void AstValidator::validateVariable(const AstValue &variable)
+{
+    auto&& variable_type = typeOf(variable);
+    auto&& node = variable.as_object();
+
+    if (variable_type == "nameIndexVariable") {
+        if (!member(node, "index").is_string()) {
+            throwInvalid("The index of nameIndexVariable should be a string", node.to_string());
+        }
+    } else if (variable_type == "numberIndexVariable") {
+        this->validateExpression(member(node, "index"));
+    } else {
+        throwInvalid("Should be a variable", node.to_string());
+    }
+}
+
+void AstValidator::validateInsideFunctionExpression(const AstObject &expression)
+{
+    auto&& function_id_value = member(expression, "functionId");
+    if (!function_id_value.is_number()) {
+        throwInvalid("The functionId of insideFunctionExpression should be a number", expression.to_string());
+    }
+
+    auto function_id_int = function_id_value.as_integer();
+    if (function_id_int < 0
+        || static_cast<std::size_t>(function_id_int) >= INSIDE_FUNCTION_COUNT + this->_native_function_list.size()) {
+        throwInvalid("Unknown functionId of insideFunctionExpression", expression.to_string());
+    }
+    auto function_id = static_cast<InsideFunctionId>(function_id_int);
+
+    auto&& param = member(expression, "param");
+
+    if (function_id == INSIDE_FUNCTION_ATAN) {
+        // atan[y]/[x]
+        if (!param.is_array() || param.as_array().size() != 2) {
+            throwInvalid("The param of atan should be an array of 2 expressions", expression.to_string());
+        }
+        for (const auto& p : param.as_array()) {
+            this->validateExpression(p);
+        }
+    } else if (function_id == INSIDE_FUNCTION_EXISTS) {
+        this->validateVariable(param);
+    } else if (IsNativeFunctionId(function_id)) {
+        auto&& native_function = this->_native_function_list[function_id - INSIDE_FUNCTION_COUNT];
+        if (!param.is_array() || param.as_array().size() != native_function->arity) {
+            std::stringstream ss;
+            ss << "The param of native function " << native_function->name
+               << " should be an array of " << native_function->arity << " expressions";
+            throwInvalid(ss.str(), expression.to_string());
+        }
+        for (const auto& p : param.as_array()) {
+            this->validateExpression(p);
+        }
+    } else {
+        this->validateExpression(param);
+    }
+}
+
+const AstValue &AstValidator::member(const AstObject &node, const std::string &key)
+{
+    if (!node.contains(key)) {
+        throwInvalid("Missing \"" + key + "\"", node.to_string());
+    }
+    return node.at(key);
+}
+
+std::string AstValidator::typeOf(const AstValue &node)
+{
+    if (!node.is_object() || !node.as_object().contains("type")
+        || !node.as_object().at("type").is_string()) {
+        throwInvalid("Should be a node with a string \"type\"", node.to_string());
+    }
+    return node.as_object().at("type").as_string();
+}
+
+void AstValidator::throwInvalid(const std::string &reason, const std::string &node_string)
+{
+    std::stringstream ss;
+    ss << "Invalid AST node, " << reason
+       << "\nnode:" << node_string;
+    throw AstValidateError(ss.str());
+}
+
+} // namespace rs274letter
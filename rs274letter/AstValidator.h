@@ -0,0 +1,96 @@
+// AstValidator.h
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+#include "Parser.h"
+#include "InsideFunction.h"
+#include "Exception.h"
+
+namespace rs274letter
+{
+
+class AstValidateError : public Exception {
+public:
+    AstValidateError(const std::string& str) : Exception(str) { }
+    virtual const char* what() const noexcept override {
+        _str
+            = "RS274Exception: AstValidateError:\n" + _str;
+        return _str.c_str();
+    }
+};
+
+/**
+ * AstValidator
+ * The shape check of a whole AST, done once by `Program::compile()` before
+ * `Linker::link()`. It checks every node the Linker and the Serializer visit:
+ *  - the "type" of each node, and that it is expected at its place
+ *  - the member keys and their json types, like "body" is an array of statements
+ *  - the letters of the commands, the operators of the binary expressions
+ *  - the inside function ids and their params, the native functions are
+ *    checked against the `native_function_list` bound by the Serializer
+ * A program from `Parser::parse()` always passes, the check catches the
+ * ASTs built or modified by hand, or loaded from elsewhere.
+ * After the check, the Serializer executes without asserting the node types,
+ * unless built with RS274LETTER_CHECKED_EXECUTION.
+ * @throw AstValidateError on the first invalid node
+*/
+class AstValidator {
+public:
+    ~AstValidator() noexcept = default;
+
+    static void validate(const AstObject& program,
+        const std::vector<std::shared_ptr<const NativeFunction>>& native_function_list);
+
+private:
+    AstValidator(const std::vector<std::shared_ptr<const NativeFunction>>& native_function_list)
+        : _native_function_list(native_function_list) {}
+
+    void validateStatementList(const AstValue& statement_list);
+    void validateStatement(const AstValue& statement);
+
+    void validateCommandStatement(const AstObject& command_statement);
+    void validateOIfStatement(const AstObject& o_if_statement);
+
+    /**
+     * validateOWord()
+     * a nameIndexOCommand or a numberIndexOCommand
+    */
+    void validateOWord(const AstValue& o_word);
+
+    void validateExpression(const AstValue& expression);
+
+    /**
+     * validateOptionalExpression()
+     * an empty object, or an expression, like the "returnRtnExpr"
+    */
+    void validateOptionalExpression(const AstValue& expression);
+
+    void validateVariable(const AstValue& variable);
+    void validateInsideFunctionExpression(const AstObject& expression);
+
+    /**
+     * member()
+     * the value at `key` of the node
+     * @throw AstValidateError if the key does not exist
+    */
+    static const AstValue& member(const AstObject& node, const std::string& key);
+
+    /**
+     * typeOf()
+     * the "type" of the node
+     * @throw AstValidateError if the value is not an object with a string "type"
+    */
+    static std::string typeOf(const AstValue& node);
+
+    [[noreturn]] static void throwInvalid(const std::string& reason, const std::string& node_string);
+
+private:
+    const std::vector<std::shared_ptr<const NativeFunction>>& _native_function_list;
+};
+
+} // namespace rs274letter
@@ -0,0 +1,264 @@
+// ColumnarCommandStore.cc
+#include "ColumnarCommandStore.h"
+
+#include "Exception.h"
+#include "macro.h"
+
+#include <cmath>
+#include <sstream>
+
+namespace rs274letter
+{
+
+ColumnarCommandStore::ColumnarCommandStore(double quantum /* = 1e-6*/)
+    : _quantum(quantum)
+{
+    if (!(quantum > 0.0) || !std::isfinite(quantum)) {
+        std::stringstream ss;
+        ss << "ColumnarCommandStore quantum should be a positive number, got: " << quantum;
+        throw Exception(ss.str());
+    }
+}
+
+void ColumnarCommandStore::append(const CommandStatement &command_statement)
+{
+    // quantize all the numbers first, so a throw leaves the store unchanged
+    Shape shape{};
+    std::array<std::int64_t, CommandStatement::kLetterCount + CommandStatement::kMaxOverflowNumbers> quantized;
+    std::size_t quantized_size = 0;
+
+    for (std::size_t s = 0; s < CommandStatement::kLetterCount; ++s) {
+        auto&& numbers = command_statement.getNumbersOfLetter(static_cast<char>('a' + s));
+        if (!numbers) continue;
+
+        shape[s] = static_cast<std::uint8_t>(numbers->size());
+        for (auto&& number : numbers.value()) {
+            quantized[quantized_size++] = this->quantize(number);
+        }
+    }
+
+    auto shape_id = this->getShapeId(shape);
+
+    auto row = this->size();
+    auto block = row / kBlockRows;
+
+    if (row % kBlockRows == 0) {
+        // a new block starts, record the checkpoints of the active columns
+        for (std::size_t s = 0; s < CommandStatement::kLetterCount; ++s) {
+            if (!(_active_column_mask & (1u << s))) continue;
+            auto& column = _column_list[s];
+            column.checkpoint_list.push_back({column.bytes.size(), column.last});
+        }
+    }
+
+    std::size_t quantized_index = 0;
+    for (std::size_t s = 0; s < CommandStatement::kLetterCount; ++s) {
+        if (shape[s] == 0) continue;
+
+        auto& column = _column_list[s];
+        if (!(_active_column_mask & (1u << s))) {
+            // first number of this column, nothing is before it in any block
+            _active_column_mask |= (1u << s);
+            column.checkpoint_list.assign(block + 1, Checkpoint{0, 0});
+        }
+
+        for (std::size_t i = 0; i < shape[s]; ++i) {
+            auto q = quantized[quantized_index++];
+            WriteVarint(column.bytes, ZigZagEncode(q - column.last));
+            column.last = q;
+        }
+    }
+
+    _row_shape_list.push_back(shape_id);
+}
+
+void ColumnarCommandStore::decode(std::size_t row, CommandStatement &out) const
+{
+    if (row >= this->size()) {
+        std::stringstream ss;
+        ss << "ColumnarCommandStore row out of range: " << row << ", size: " << this->size();
+        throw Exception(ss.str());
+    }
+
+    out.clear();
+
+    auto block = row / kBlockRows;
+    auto&& shape = _shape_list[_row_shape_list[row]];
+
+    // numbers of each column between the checkpoint and the row
+    std::array<std::size_t, CommandStatement::kLetterCount> skip{};
+    for (std::size_t r = block * kBlockRows; r < row; ++r) {
+        auto&& skipped_shape = _shape_list[_row_shape_list[r]];
+        for (std::size_t s = 0; s < CommandStatement::kLetterCount; ++s) {
+            skip[s] += skipped_shape[s];
+        }
+    }
+
+    for (std::size_t s = 0; s < CommandStatement::kLetterCount; ++s) {
+        if (shape[s] == 0) continue;
+
+        auto&& column = _column_list[s];
+        auto&& checkpoint = column.checkpoint_list[block];
+        std::size_t offset = checkpoint.byte_offset;
+        std::int64_t previous = checkpoint.previous;
+
+        for (std::size_t i = 0; i < skip[s]; ++i) {
+            previous += ZigZagDecode(ReadVarint(column.bytes, offset));
+        }
+
+        for (std::size_t i = 0; i < shape[s]; ++i) {
+            previous += ZigZagDecode(ReadVarint(column.bytes, offset));
+            out.pushBack({static_cast<char>('a' + s), previous * _quantum});
+        }
+    }
+}
+
+std::size_t ColumnarCommandStore::memoryUsage() const
+{
+    std::size_t bytes = sizeof(*this);
+
+    bytes += _shape_list.capacity() * sizeof(Shape);
+    // approximate a red-black tree node as 4 pointers plus the value
+    bytes += _shape_id_map.size() * (4 * sizeof(void*) + sizeof(Shape) + sizeof(std::uint16_t));
+    bytes += _row_shape_list.capacity() * sizeof(std::uint16_t);
+
+    for (auto&& column : _column_list) {
+        bytes += column.bytes.capacity();
+        bytes += column.checkpoint_list.capacity() * sizeof(Checkpoint);
+    }
+
+    return bytes;
+}
+
+void ColumnarCommandStore::clear()
+{
+    _shape_list.clear();
+    _shape_id_map.clear();
+    _row_shape_list.clear();
+
+    for (auto& column : _column_list) {
+        column.bytes.clear();
+        column.checkpoint_list.clear();
+        column.last = 0;
+    }
+    _active_column_mask = 0;
+}
+
+void ColumnarCommandStore::shrinkToFit()
+{
+    _shape_list.shrink_to_fit();
+    _row_shape_list.shrink_to_fit();
+
+    for (auto& column : _column_list) {
+        column.bytes.shrink_to_fit();
+        column.checkpoint_list.shrink_to_fit();
+    }
+}
+
+ColumnarCommandStore::Cursor::Cursor(const ColumnarCommandStore *store, std::size_t row)
+    : _store(store), _row(row)
+{
+    if (_row >= _store->size()) {
+        _row = _store->size();
+        return;
+    }
+
+    auto block = _row / kBlockRows;
+    for (std::size_t s = 0; s < CommandStatement::kLetterCount; ++s) {
+        if (!(_store->_active_column_mask & (1u << s))) continue;
+        auto&& checkpoint = _store->_column_list[s].checkpoint_list[block];
+        _byte_offset[s] = checkpoint.byte_offset;
+        _previous[s] = checkpoint.previous;
+    }
+
+    // walk from the checkpoint to the row
+    for (std::size_t r = block * kBlockRows; r < _row; ++r) {
+        auto&& shape = _store->_shape_list[_store->_row_shape_list[r]];
+        for (std::size_t s = 0; s < CommandStatement::kLetterCount; ++s) {
+            for (std::size_t i = 0; i < shape[s]; ++i) {
+                _previous[s] += ZigZagDecode(ReadVarint(_store->_column_list[s].bytes, _byte_offset[s]));
+            }
+        }
+    }
+}
+
+bool ColumnarCommandStore::Cursor::next(CommandStatement &out)
+{
+    if (_row >= _store->size()) return false;
+
+    out.clear();
+
+    auto&& shape = _store->_shape_list[_store->_row_shape_list[_row]];
+    for (std::size_t s = 0; s < CommandStatement::kLetterCount; ++s) {
+        for (std::size_t i = 0; i < shape[s]; ++i) {
+            _previous[s] += ZigZagDecode(ReadVarint(_store->_column_list[s].bytes, _byte_offset[s]));
+            out.pushBack({static_cast<char>('a' + s), _previous[s] * _store->_quantum});
+        }
+    }
+
+    ++_row;
+    return true;
+}
+
+std::uint16_t ColumnarCommandStore::getShapeId(const Shape &shape)
+{
+    // most rows have the same shape as the last row
+    if (!_row_shape_list.empty() && _shape_list[_row_shape_list.back()] == shape) {
+        return _row_shape_list.back();
+    }
+
+    auto it = _shape_id_map.find(shape);
+    if (it != _shape_id_map.end()) return it->second;
+
+    if (_shape_list.size() >= kMaxShapes) {
+        std::stringstream ss;
+        ss << "ColumnarCommandStore too many different command shapes, allowed: " << kMaxShapes;
+        throw Exception(ss.str());
+    }
+
+    auto id = static_cast<std::uint16_t>(_shape_list.size());
+    _shape_list.push_back(shape);
+    _shape_id_map.emplace(shape, id);
+    return id;
+}
+
+std::int64_t ColumnarCommandStore::quantize(double number) const
+{
+    double q = std::round(number / _quantum);
+
+    // keep the delta of two numbers inside int64 as well
+    static const double s_max_quantized = 4.0e18;
+    if (!std::isfinite(q) || std::abs(q) > s_max_quantized) {
+        std::stringstream ss;
+        ss << "ColumnarCommandStore cannot store number: " << number
+           << ", quantum: " << _quantum;
+        throw Exception(ss.str());
+    }
+
+    return static_cast<std::int64_t>(q);
+}
+
+void ColumnarCommandStore::WriteVarint(std::vector<std::uint8_t> &bytes, std::uint64_t v)
+{
+    while (v >= 0x80) {
+        bytes.push_back(static_cast<std::uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    bytes.push_back(static_cast<std::uint8_t>(v));
+}
+
+std::uint64_t ColumnarCommandStore::ReadVarint(const std::vector<std::uint8_t> &bytes, std::size_t &offset)
+{
+    std::uint64_t v = 0;
+    int shift = 0;
+    std::uint8_t byte;
+    do {
+        RS274LETTER_ASSERT(offset < bytes.size());
+        byte = bytes[offset++];
+        v |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return v;
+}
+
+} // namespace rs274letter
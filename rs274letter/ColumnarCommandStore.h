@@ -0,0 +1,152 @@
+// ColumnarCommandStore.h
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "CommandStatement.h"
+#include "CommandSink.h"
+
+namespace rs274letter
+{
+
+/**
+ * ColumnarCommandStore
+ * A compact in-memory store of a whole program output, used for preview
+ * and backplot of long programs. It is a CommandSink, set it to the Serializer
+ * with `setCommandSink()`.
+ *
+ * Layout:
+ *  - each row (command line) stores a 2-byte id of its `shape`, a shape is
+ *    the appear times of each letter in the row, shared by all rows alike
+ *  - each letter has a packed column, the numbers are quantized by `quantum`,
+ *    delta-encoded against the previous number in the same column,
+ *    and written as zigzag varint
+ *  - every `kBlockRows` rows, each column records a checkpoint (byte offset and
+ *    the previous number), so a random-access decode only walks inside one block
+ *
+ * Numbers are stored with the precision of `quantum`, a decoded number is
+ * within `quantum / 2` of the consumed one.
+ * @throw Exception if a number is not finite or too large for the quantum,
+ * or there are too many different shapes
+*/
+class ColumnarCommandStore : public CommandSink {
+public:
+    using ptr = std::shared_ptr<ColumnarCommandStore>;
+
+    static constexpr std::size_t kBlockRows = 128;
+    static constexpr std::size_t kMaxShapes = 65536;
+
+    explicit ColumnarCommandStore(double quantum = 1e-6);
+    virtual ~ColumnarCommandStore() noexcept = default;
+
+    virtual void consume(const CommandStatement& command_statement) override {
+        this->append(command_statement);
+    }
+
+    /**
+     * append()
+     * append a command line as the last row
+    */
+    void append(const CommandStatement& command_statement);
+
+    /**
+     * decode()
+     * random-access decode the row, `out` is cleared first
+    */
+    void decode(std::size_t row, CommandStatement& out) const;
+
+    CommandStatement at(std::size_t row) const {
+        CommandStatement cs;
+        this->decode(row, cs);
+        return cs;
+    }
+
+    inline std::size_t size() const { return _row_shape_list.size(); }
+    inline bool empty() const { return _row_shape_list.empty(); }
+    inline double quantum() const { return _quantum; }
+
+    /**
+     * memoryUsage()
+     * bytes held by the store (capacity of the internal buffers)
+    */
+    std::size_t memoryUsage() const;
+
+    void clear();
+    void shrinkToFit();
+
+    /**
+     * Cursor
+     * Fast sequential decoding, starting at any row.
+     * Only valid while the store is alive and not appended.
+     *
+     *  auto cursor = store.cursor();
+     *  CommandStatement cs;
+     *  while (cursor.next(cs)) { ... }
+    */
+    class Cursor {
+    public:
+        /**
+         * next()
+         * decode the current row into `out` and move to the next row
+         * @return false if there is no more row
+        */
+        bool next(CommandStatement& out);
+
+        inline std::size_t row() const { return _row; }
+
+    private:
+        friend class ColumnarCommandStore;
+        Cursor(const ColumnarCommandStore* store, std::size_t row);
+
+        const ColumnarCommandStore* _store;
+        std::size_t _row;
+        std::array<std::size_t, CommandStatement::kLetterCount> _byte_offset{};
+        std::array<std::int64_t, CommandStatement::kLetterCount> _previous{};
+    };
+
+    Cursor cursor(std::size_t start_row = 0) const { return Cursor(this, start_row); }
+
+private:
+    // appear times of each letter
+    using Shape = std::array<std::uint8_t, CommandStatement::kLetterCount>;
+
+    struct Checkpoint {
+        std::uint64_t byte_offset; // offset of the first number at or after the block
+        std::int64_t previous;     // quantized number before the block
+    };
+
+    struct Column {
+        std::vector<std::uint8_t> bytes;
+        std::vector<Checkpoint> checkpoint_list; // one per block, since the column is active
+        std::int64_t last = 0;
+    };
+
+    std::uint16_t getShapeId(const Shape& shape);
+    std::int64_t quantize(double number) const;
+
+    static void WriteVarint(std::vector<std::uint8_t>& bytes, std::uint64_t v);
+    static std::uint64_t ReadVarint(const std::vector<std::uint8_t>& bytes, std::size_t& offset);
+    static inline std::uint64_t ZigZagEncode(std::int64_t v) {
+        return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+    }
+    static inline std::int64_t ZigZagDecode(std::uint64_t v) {
+        return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+    }
+
+private:
+    double _quantum;
+
+    std::vector<Shape> _shape_list;
+    std::map<Shape, std::uint16_t> _shape_id_map;
+
+    std::vector<std::uint16_t> _row_shape_list;
+
+    std::array<Column, CommandStatement::kLetterCount> _column_list;
+    std::uint32_t _active_column_mask = 0;
+};
+
+} // namespace rs274letter
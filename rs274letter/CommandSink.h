@@ -0,0 +1,100 @@
+// CommandSink.h
+#pragma once
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+#include "CommandStatement.h"
+
+namespace rs274letter
+{
+
+/**
+ * CommandSink
+ * The consumer of the commands produced by the Serializer.
+ * `consume()` is called for each CommandStatement as soon as it is produced,
+ * in the program order, so a consumer can handle the commands in constant memory.
+*/
+class CommandSink {
+public:
+    using ptr = std::shared_ptr<CommandSink>;
+    virtual ~CommandSink() noexcept = default;
+
+    /**
+     * consume()
+     * The CommandStatement is only valid during the call, copy it if needed.
+    */
+    virtual void consume(const CommandStatement& command_statement) = 0;
+
+    /**
+     * flush()
+     * Called when the Serializer finishes processing a program.
+    */
+    virtual void flush() {}
+};
+
+/**
+ * CommandListSink
+ * Collects all the commands into a std::pmr::list, this is the default sink
+ * of the Serializer. The list nodes are allocated from the memory resource
+ * given on construction, the global heap by default.
+*/
+class CommandListSink : public CommandSink {
+public:
+    using ptr = std::shared_ptr<CommandListSink>;
+    using CommandList = std::pmr::list<CommandStatement>;
+
+    explicit CommandListSink(std::pmr::memory_resource* memory_resource = std::pmr::get_default_resource())
+        : _command_statement_list(memory_resource) {}
+
+    virtual void consume(const CommandStatement& command_statement) override {
+        _command_statement_list.push_back(command_statement);
+    }
+
+    inline const CommandList& getCommandList() const {
+        return _command_statement_list;
+    }
+
+    /**
+     * takeCommandList()
+     * move the collected commands out, the sink is empty after this call.
+     * The returned list still allocates from the memory resource of the sink.
+    */
+    inline CommandList takeCommandList() {
+        return std::exchange(_command_statement_list, CommandList(_command_statement_list.get_allocator()));
+    }
+
+    inline void clear() { _command_statement_list.clear(); }
+
+private:
+    CommandList _command_statement_list;
+};
+
+/**
+ * CallbackCommandSink
+ * Forwards every command to a callback.
+*/
+class CallbackCommandSink : public CommandSink {
+public:
+    using Callback = std::function<void(const CommandStatement&)>;
+
+    CallbackCommandSink(Callback callback, std::function<void()> flush_callback = nullptr)
+        : _callback(std::move(callback)), _flush_callback(std::move(flush_callback)) {}
+
+    virtual void consume(const CommandStatement& command_statement) override {
+        _callback(command_statement);
+    }
+
+    virtual void flush() override {
+        if (_flush_callback) _flush_callback();
+    }
+
+private:
+    Callback _callback;
+    std::function<void()> _flush_callback;
+};
+
+} // namespace rs274letter
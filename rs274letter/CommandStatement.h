@@ -0,0 +1,180 @@
+// CommandStatement.h
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+
+namespace rs274letter
+{
+
+using CommandNumberGroup = std::pair<char, double>;
+
+/**
+ * CommandStatement
+ * A serialized command line, like `G01 X1 Y2 F100`.
+ * It has a fixed layout and never allocates:
+ *  - 26 letter slots holding the first number of each letter (a-z),
+ *    with a bitmask telling which slots are present
+ *  - a small inline overflow area holding the repeated letters in order,
+ *    like the second `G` of `G90 G01 X1`
+*/
+class CommandStatement {
+public:
+    static constexpr std::size_t kLetterCount = 26;
+    static constexpr std::size_t kMaxOverflowNumbers = 8;
+
+    /**
+     * NumberView
+     * A view of all the numbers of one letter, in the order they appear.
+     * Only valid while the viewed CommandStatement is alive and unchanged.
+    */
+    class NumberView {
+    public:
+        class const_iterator {
+        public:
+            const_iterator(const CommandStatement* cs, std::size_t slot, int pos) noexcept
+                : _cs(cs), _slot(slot), _pos(pos) {}
+
+            inline double operator*() const {
+                return _pos < 0 ? _cs->_letter_numbers[_slot] : _cs->_overflow_numbers[_pos];
+            }
+
+            inline const_iterator& operator++() {
+                // find the next repeated number of the same letter
+                do {
+                    ++_pos;
+                } while (_pos < static_cast<int>(_cs->_overflow_size)
+                    && _cs->_overflow_slots[_pos] != _slot);
+                return *this;
+            }
+
+            inline bool operator==(const const_iterator& o) const { return _pos == o._pos; }
+            inline bool operator!=(const const_iterator& o) const { return _pos != o._pos; }
+
+        private:
+            const CommandStatement* _cs;
+            std::size_t _slot;
+            int _pos; // -1 is the letter slot, others are positions in the overflow area
+        };
+
+        NumberView(const CommandStatement* cs, std::size_t slot) noexcept
+            : _cs(cs), _slot(slot) {}
+
+        inline const_iterator begin() const { return const_iterator(_cs, _slot, -1); }
+        inline const_iterator end() const {
+            return const_iterator(_cs, _slot, static_cast<int>(_cs->_overflow_size));
+        }
+
+        inline std::size_t size() const { return _cs->_letter_times[_slot]; }
+        inline double front() const { return _cs->_letter_numbers[_slot]; }
+
+        inline double operator[](std::size_t i) const {
+            auto it = this->begin();
+            while (i--) ++it;
+            return *it;
+        }
+
+    private:
+        const CommandStatement* _cs;
+        std::size_t _slot;
+    };
+
+public:
+    CommandStatement() noexcept = default;
+    ~CommandStatement() noexcept = default;
+
+    /**
+     * @brief add a letter-number group
+     * @return false if the letter is not a-z/A-Z, or the inline overflow
+     * area is full of repeated letters
+    */
+    inline bool pushBack(const CommandNumberGroup& cng) noexcept {
+        auto&& slot = _letter_slot(cng.first);
+        if (!slot) return false;
+
+        auto s = slot.value();
+        if (!(_letter_mask & (1u << s))) {
+            _letter_mask |= (1u << s);
+            _letter_numbers[s] = cng.second;
+            _letter_times[s] = 1;
+            return true;
+        }
+
+        if (_overflow_size >= kMaxOverflowNumbers) return false;
+
+        _overflow_slots[_overflow_size] = static_cast<std::uint8_t>(s);
+        _overflow_numbers[_overflow_size] = cng.second;
+        ++_overflow_size;
+        ++_letter_times[s];
+        return true;
+    }
+
+    inline unsigned int appearTimesOfLetter(char letter) const {
+        auto&& slot = _letter_slot(letter);
+        if (!slot || !(_letter_mask & (1u << slot.value()))) return 0;
+        return _letter_times[slot.value()];
+    }
+
+    inline bool has_letter(char letter) const
+    { return this->appearTimesOfLetter(letter) != 0 ; }
+
+    inline std::optional<NumberView> getNumbersOfLetter(char letter) const {
+        auto&& slot = _letter_slot(letter);
+        if (!slot || !(_letter_mask & (1u << slot.value())))
+            return std::nullopt;
+        else
+            return NumberView(this, slot.value());
+    }
+
+    /**
+     * @brief bit `i` is set if the letter ('a' + i) appears
+    */
+    inline std::uint32_t letterMask() const { return _letter_mask; }
+
+    inline bool empty() const { return _letter_mask == 0; }
+
+    inline void clear() {
+        _letter_mask = 0;
+        _overflow_size = 0;
+    }
+
+    inline std::string toString() const {
+        std::stringstream ss;
+        for (std::size_t s = 0; s < kLetterCount; ++s) {
+            if (!(_letter_mask & (1u << s))) continue;
+            ss << static_cast<char>('a' + s) << ": ";
+            for (auto&& number : NumberView(this, s)) {
+                ss << number << ", ";
+            }
+            ss << "\n";
+        }
+        return ss.str();
+    }
+
+private:
+    static inline std::optional<std::size_t> _letter_slot(char letter) {
+        if (letter >= 'a' && letter <= 'z') return letter - 'a';
+        if (letter >= 'A' && letter <= 'Z') return letter - 'A';
+        return std::nullopt;
+    }
+
+private:
+    std::uint32_t _letter_mask = 0;
+    std::uint8_t _overflow_size = 0;
+    std::array<std::uint8_t, kLetterCount> _letter_times{};
+    std::array<double, kLetterCount> _letter_numbers{};
+
+    std::array<std::uint8_t, kMaxOverflowNumbers> _overflow_slots{};
+    std::array<double, kMaxOverflowNumbers> _overflow_numbers{};
+};
+
+inline std::ostream& operator<<(std::ostream& os, const CommandStatement& cs) {
+    os << cs.toString();
+    return os;
+}
+
+} // namespace rs274letter
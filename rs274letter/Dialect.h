@@ -0,0 +1,67 @@
+// Dialect.h
+#pragma once
+
+namespace rs274letter
+{
+
+/**
+ * Dialect
+ * The rules which differ between the RS274 dialects, given to `BasicParser`
+ * and `BasicSerializer` as a policy type. Each rule is a `static constexpr bool`,
+ * tested by `if constexpr`, so the checks of a dialect are compiled into its
+ * own instances and one process can hold the instances of several dialects.
+ *
+ * The rules, and the build flags they replace:
+ *  - kNoSingleNonAssignExpression (NO_SINGLE_NON_ASSIGN_EXPRESSION)
+ *      an expression line should be an assignment, `#1 + 2` alone is illegal
+ *  - kMustPrimaryRightHandsideOfAssign (MUST_PRIMARY_RIGHT_HANDSIDE_OF_ASSIGN)
+ *      the right hand side of `=` should be a primaryExpression,
+ *      `#1 = #2 + 1` is illegal, write `#1 = [#2 + 1]`
+ *  - kDoNotAllowMultipleAssign (DO_NOT_ALLOW_MULTIPLE_ASSIGN)
+ *      an assignment produces no value, `#1 = [#2 = 3]` is illegal
+ *  - kNumberIndexJustPrimaryExpression (NAMEINDEX_JUST_PRIMARYEXPRESSION)
+ *      the index after `#` is a primaryExpression, so it may have a sign or
+ *      be a double literal, which should be an integer within the tolerance
+ *  - kNumberIndexVariableUndefinedError (NUMBERINDEX_VARIABLE_UNDEFINED_ERROR)
+ *      reading an undefined `#1` throws, otherwise it is 0
+ *  - kNameIndexVariableUndefinedError (NAMEINDEX_VARIABLE_UNDEFINED_ERROR)
+ *      reading an undefined `#<name>` throws, otherwise it is 0
+ *  - kThrowIfInternalDeleteUndefinedVariable (THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE)
+ *      an internal delete of an undefined variable throws
+ *
+ * The ASTs of all the dialects have the same shape, a `Program` can be
+ * executed by the Serializer of any dialect.
+ * BasicParser and BasicSerializer are instantiated in Parser.cc and
+ * Serializer.cc for the dialects below, add an explicit instantiation
+ * there for a new dialect.
+*/
+
+/**
+ * StrictDialect
+ * All the rules on, the default dialect of `Parser` and `Serializer`.
+*/
+struct StrictDialect {
+    static constexpr bool kNoSingleNonAssignExpression = true;
+    static constexpr bool kMustPrimaryRightHandsideOfAssign = true;
+    static constexpr bool kDoNotAllowMultipleAssign = true;
+    static constexpr bool kNumberIndexJustPrimaryExpression = true;
+    static constexpr bool kNumberIndexVariableUndefinedError = true;
+    static constexpr bool kNameIndexVariableUndefinedError = true;
+    static constexpr bool kThrowIfInternalDeleteUndefinedVariable = true;
+};
+
+/**
+ * LenientDialect
+ * All the rules off.
+*/
+struct LenientDialect {
+    static constexpr bool kNoSingleNonAssignExpression = false;
+    static constexpr bool kMustPrimaryRightHandsideOfAssign = false;
+    static constexpr bool kDoNotAllowMultipleAssign = false;
+    static constexpr bool kNumberIndexJustPrimaryExpression = false;
+    static constexpr bool kNumberIndexVariableUndefinedError = false;
+    static constexpr bool kNameIndexVariableUndefinedError = false;
+    static constexpr bool kThrowIfInternalDeleteUndefinedVariable = false;
+};
+
+} // namespace rs274letter
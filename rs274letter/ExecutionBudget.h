@@ -0,0 +1,47 @@
+// ExecutionBudget.h
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace rs274letter
+{
+
+/**
+ * ExecutionBudget
+ * The limits of the Serializer executing a program, set with
+ * `Serializer::setExecutionBudget()`. A limit of 0 means unlimited.
+ *
+ * The counters and the duration start at the program start (or at
+ * `restartFromCommand()`) and are counted for the whole run. The duration
+ * is the time spent inside `restartFromCommand()` and the `step()` calls,
+ * so the pauses between the steps are not counted.
+ * The limits are checked at the loop back-edges and the o-calls only,
+ * a program without them can not run longer than its own size.
+ * The wall clock is read every `kClockCheckInterval` checks.
+ * @throw SerializerError naming the exhausted budget and the o-word where it happens
+*/
+struct ExecutionBudget {
+    static constexpr std::size_t kClockCheckInterval = 64;
+
+    // statements executed, including the statements inside loops and subs
+    std::size_t max_statements = 0;
+
+    // commands produced
+    std::size_t max_commands = 0;
+
+    // wall-clock time of the run, summed over its step() calls
+    std::chrono::milliseconds max_duration{0};
+
+    // nested o-calls, including recursive calls
+    std::size_t max_call_depth = 0;
+
+    // iterations of all the loops together
+    std::size_t max_loop_iterations = 0;
+
+    // iterations of one while loop, each time the loop is entered.
+    // a repeat loop runs a calculated count, so it is not limited by this
+    std::size_t max_single_loop_iterations = 1000;
+};
+
+} // namespace rs274letter
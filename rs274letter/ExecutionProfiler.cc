@@ -0,0 +1,190 @@
+// ExecutionProfiler.cc
+#include "ExecutionProfiler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+namespace rs274letter
+{
+
+void ExecutionProfiler::bind(const Program::ptr& program)
+{
+    if (program == this->_program) return;
+
+    this->_program = program;
+    this->_count_list.clear();
+    this->_time_ns_list.clear();
+    this->_sub_call_count_list.clear();
+
+    if (this->_program) {
+        auto&& link_result = this->_program->getLinkResult();
+        this->_count_list.resize(link_result.statement_line_list.size(), 0);
+        this->_time_ns_list.resize(link_result.statement_line_list.size(), 0);
+        this->_sub_call_count_list.resize(link_result.sub_list.size(), 0);
+    }
+}
+
+void ExecutionProfiler::clear()
+{
+    std::fill(this->_count_list.begin(), this->_count_list.end(), 0);
+    std::fill(this->_time_ns_list.begin(), this->_time_ns_list.end(), 0);
+    std::fill(this->_sub_call_count_list.begin(), this->_sub_call_count_list.end(), 0);
+    this->_sample_tick = 0;
+}
+
+std::vector<ExecutionProfiler::LineStat> ExecutionProfiler::getLineStatList() const
+{
+    if (!this->_program) return {};
+
+    // more than one statement may start at a line, like an `o... endif` and the
+    // statement after it are in different lists, but only one of them is executed
+    std::map<int, LineStat> line_stat_map;
+    auto&& statement_line_list = this->_program->getLinkResult().statement_line_list;
+    for (std::size_t id = 0; id < this->_count_list.size(); ++id) {
+        if (this->_count_list[id] == 0 && this->_time_ns_list[id] == 0) continue;
+
+        auto& line_stat = line_stat_map[statement_line_list[id]];
+        line_stat.line = statement_line_list[id];
+        line_stat.count += this->_count_list[id];
+        line_stat.time_ns += this->_time_ns_list[id];
+    }
+
+    std::vector<LineStat> line_stat_list;
+    line_stat_list.reserve(line_stat_map.size());
+    for (auto&& [line, line_stat] : line_stat_map) {
+        line_stat_list.push_back(line_stat);
+    }
+
+    std::stable_sort(line_stat_list.begin(), line_stat_list.end(), [](const LineStat& a, const LineStat& b) {
+        return a.time_ns != b.time_ns ? a.time_ns > b.time_ns : a.count > b.count;
+    });
+    return line_stat_list;
+}
+
+std::vector<ExecutionProfiler::SubStat> ExecutionProfiler::getSubStatList() const
+{
+    if (!this->_program) return {};
+
+    auto&& link_result = this->_program->getLinkResult();
+
+    std::vector<SubStat> sub_stat_list(link_result.sub_list.size());
+    for (std::size_t i = 0; i < link_result.sub_list.size(); ++i) {
+        auto&& substatement = *link_result.sub_list[i];
+        sub_stat_list[i].name = Linker::GetOWordShowString(substatement.at("subOCommand").as_object());
+        sub_stat_list[i].line = substatement.contains("line") ? substatement.at("line").as_integer() : 0;
+        sub_stat_list[i].calls = this->_sub_call_count_list[i];
+    }
+
+    for (std::size_t id = 0; id < this->_count_list.size(); ++id) {
+        auto sub_index = link_result.statement_sub_index_list[id];
+        if (sub_index < 0) continue;
+
+        sub_stat_list[sub_index].count += this->_count_list[id];
+        sub_stat_list[sub_index].time_ns += this->_time_ns_list[id];
+    }
+
+    return sub_stat_list;
+}
+
+std::uint64_t ExecutionProfiler::getTotalCount() const
+{
+    std::uint64_t total = 0;
+    for (auto count : this->_count_list) total += count;
+    return total;
+}
+
+std::uint64_t ExecutionProfiler::getTotalTimeNs() const
+{
+    std::uint64_t total = 0;
+    for (auto time_ns : this->_time_ns_list) total += time_ns;
+    return total;
+}
+
+// the lines of the source, line `n` is at [n - 1]
+static std::vector<std::string> _split_lines(const std::string& source)
+{
+    std::vector<std::string> line_list;
+    std::size_t pos = 0;
+    while (pos < source.size()) {
+        auto end = source.find('\n', pos);
+        if (end == std::string::npos) end = source.size();
+        line_list.emplace_back(source, pos, end - pos);
+        pos = end + 1;
+    }
+    return line_list;
+}
+
+static double _percent(std::uint64_t part, std::uint64_t total)
+{
+    return total ? 100.0 * static_cast<double>(part) / static_cast<double>(total) : 0.0;
+}
+
+std::string ExecutionProfiler::toHotLineReport(const std::string& source, std::size_t max_lines/* = 20*/) const
+{
+    auto line_list = _split_lines(source);
+    auto line_stat_list = this->getLineStatList();
+    auto total_time_ns = this->getTotalTimeNs();
+
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    ss << "statements: " << this->getTotalCount()
+       << ", time: " << total_time_ns / 1000.0 << " us"
+       << ", sample interval: " << this->_sample_interval << "\n";
+
+    ss << std::setw(6) << "line" << std::setw(12) << "count"
+       << std::setw(14) << "time(us)" << std::setw(8) << "time%" << "  source\n";
+    for (std::size_t i = 0; i < line_stat_list.size() && i < max_lines; ++i) {
+        auto&& line_stat = line_stat_list[i];
+        ss << std::setw(6) << line_stat.line << std::setw(12) << line_stat.count
+           << std::setw(14) << line_stat.time_ns / 1000.0
+           << std::setw(7) << _percent(line_stat.time_ns, total_time_ns) << "%  ";
+        if (line_stat.line > 0 && static_cast<std::size_t>(line_stat.line) <= line_list.size()) {
+            ss << line_list[line_stat.line - 1];
+        }
+        ss << "\n";
+    }
+
+    auto sub_stat_list = this->getSubStatList();
+    if (!sub_stat_list.empty()) {
+        ss << "\n" << std::setw(6) << "line" << std::setw(12) << "calls" << std::setw(12) << "statements"
+           << std::setw(14) << "time(us)" << std::setw(8) << "time%" << "  sub\n";
+        for (auto&& sub_stat : sub_stat_list) {
+            ss << std::setw(6) << sub_stat.line << std::setw(12) << sub_stat.calls
+               << std::setw(12) << sub_stat.count << std::setw(14) << sub_stat.time_ns / 1000.0
+               << std::setw(7) << _percent(sub_stat.time_ns, total_time_ns) << "%  "
+               << sub_stat.name << "\n";
+        }
+    }
+
+    return ss.str();
+}
+
+std::string ExecutionProfiler::toAnnotatedListing(const std::string& source) const
+{
+    auto line_list = _split_lines(source);
+    auto total_time_ns = this->getTotalTimeNs();
+
+    std::map<int, LineStat> line_stat_map;
+    for (auto&& line_stat : this->getLineStatList()) {
+        line_stat_map.emplace(line_stat.line, line_stat);
+    }
+
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    for (std::size_t i = 0; i < line_list.size(); ++i) {
+        auto it = line_stat_map.find(static_cast<int>(i + 1));
+        if (it == line_stat_map.end()) {
+            ss << std::setw(12) << "" << std::setw(14) << "" << std::setw(8) << "";
+        } else {
+            ss << std::setw(12) << it->second.count << std::setw(14) << it->second.time_ns / 1000.0
+               << std::setw(7) << _percent(it->second.time_ns, total_time_ns) << "%";
+        }
+        ss << " |" << std::setw(6) << i + 1 << " | " << line_list[i] << "\n";
+    }
+
+    return ss.str();
+}
+
+} // namespace rs274letter
@@ -0,0 +1,141 @@
+// ExecutionProfiler.h
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Program.h"
+
+namespace rs274letter
+{
+
+/**
+ * ExecutionProfiler
+ * Counts the executions and accumulates the time of each statement of a
+ * Program, set to a Serializer by `setProfiler()`. Without a profiler the
+ * Serializer only tests a null pointer for each step.
+ *  - The counters are vectors indexed by the "statementId" written by the
+ *    Linker, the source line of each statement is in the LinkResult.
+ *  - The executions are counted exactly. The time is measured for one of
+ *    each `sample_interval` statements and multiplied by the interval, so
+ *    with a large interval the clock is rarely read.
+ *  - The time of a statement is its own time: the body of a loop or of a
+ *    called sub is counted to the statements in the body. A loop statement
+ *    is also executed for each test of its loop, a call statement also gets
+ *    the time of the return at the end of the sub.
+ *  - A sub gets the count of its calls, and the executions and the time of
+ *    the statements in its body. The subs of a dynamic o-word, like
+ *    `o[#50] sub`, are not counted as subs.
+ * The counters of the runs of the same Program add up, a Serializer
+ * running another Program with this profiler clears them.
+*/
+class ExecutionProfiler {
+public:
+    using ptr = std::shared_ptr<ExecutionProfiler>;
+
+    struct LineStat {
+        int line = 0;
+        std::uint64_t count = 0;
+        std::uint64_t time_ns = 0;
+    };
+
+    struct SubStat {
+        std::string name; // like `o<name>` or `o100`
+        int line = 0; // of the `o... sub`
+        std::uint64_t calls = 0;
+        std::uint64_t count = 0; // statements executed in the sub body
+        std::uint64_t time_ns = 0;
+    };
+
+    /**
+     * @param sample_interval measure the time of one of each `sample_interval`
+     * statements, 1 measures all of them
+    */
+    explicit ExecutionProfiler(std::uint32_t sample_interval = 16) noexcept
+        : _sample_interval(sample_interval ? sample_interval : 1) {}
+
+    ~ExecutionProfiler() noexcept = default;
+
+    /**
+     * @brief prepare the counters for the program, called by the Serializer
+     * when it executes a program other than the bound one. Clears the counters
+     * if the program changes.
+    */
+    void bind(const Program::ptr& program);
+
+    /**
+     * @brief clear the counters, keep the bound program
+    */
+    void clear();
+
+    inline const Program::ptr& getProgram() const { return this->_program; }
+    inline std::uint32_t getSampleInterval() const { return this->_sample_interval; }
+
+    /*** called by the Serializer ***/
+
+    inline void count(std::size_t statement_id) {
+        ++this->_count_list[statement_id];
+    }
+
+    // true for one of each sample_interval calls
+    inline bool shouldSample() {
+        if (++this->_sample_tick < this->_sample_interval) return false;
+        this->_sample_tick = 0;
+        return true;
+    }
+
+    inline void addSample(std::size_t statement_id, std::chrono::steady_clock::duration time) {
+        this->_time_ns_list[statement_id] += static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(time).count()) * this->_sample_interval;
+    }
+
+    inline void countSubCall(std::size_t sub_index) {
+        ++this->_sub_call_count_list[sub_index];
+    }
+
+    /*** results ***/
+
+    /**
+     * @brief the executions and the time of each source line which is executed,
+     * the hottest first: ordered by time, then by count
+    */
+    std::vector<LineStat> getLineStatList() const;
+
+    /**
+     * @brief the subs in the order of their definitions
+    */
+    std::vector<SubStat> getSubStatList() const;
+
+    std::uint64_t getTotalCount() const;
+    std::uint64_t getTotalTimeNs() const;
+
+    /**
+     * @brief the `max_lines` hottest lines with their source, and the subs
+     * @param source the code the Program is parsed from, for the source of
+     * each line, may be empty
+    */
+    std::string toHotLineReport(const std::string& source, std::size_t max_lines = 20) const;
+
+    /**
+     * @brief the whole source, each line with its executions and time
+    */
+    std::string toAnnotatedListing(const std::string& source) const;
+
+private:
+    std::uint32_t _sample_interval;
+    std::uint32_t _sample_tick = 0;
+
+    Program::ptr _program;
+
+    // indexed by statementId
+    std::vector<std::uint64_t> _count_list;
+    std::vector<std::uint64_t> _time_ns_list;
+
+    // indexed by linkedSubIndex
+    std::vector<std::uint64_t> _sub_call_count_list;
+};
+
+} // namespace rs274letter
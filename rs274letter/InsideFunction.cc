@@ -1,6 +1,15 @@
 #include "InsideFunction.h"
 
-#include <unordered_set>
+#include "Exception.h"
+#include "Tokenizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <unordered_map>
 
 namespace rs274letter
 {
@@ -8,27 +17,436 @@ namespace rs274letter
 /**
  * @brief inside function names in the rs274 linuxcnc manual
 */
-static std::unordered_set<std::string> s_insidefunction_set = {
-    "atan",
-    "abs",
-    "acos",
-    "asin",
-    "cos",
-    "exp",
-    "fix",
-    "fup",
-    "round",
-    "ln",
-    "sin",
-    "sqrt",
-    "tan",
-    "exists"
+static const std::unordered_map<std::string, InsideFunctionId> s_insidefunction_id_map = {
+    {"atan", INSIDE_FUNCTION_ATAN},
+    {"abs", INSIDE_FUNCTION_ABS},
+    {"acos", INSIDE_FUNCTION_ACOS},
+    {"asin", INSIDE_FUNCTION_ASIN},
+    {"cos", INSIDE_FUNCTION_COS},
+    {"exp", INSIDE_FUNCTION_EXP},
+    {"fix", INSIDE_FUNCTION_FIX},
+    {"fup", INSIDE_FUNCTION_FUP},
+    {"round", INSIDE_FUNCTION_ROUND},
+    {"ln", INSIDE_FUNCTION_LN},
+    {"sin", INSIDE_FUNCTION_SIN},
+    {"sqrt", INSIDE_FUNCTION_SQRT},
+    {"tan", INSIDE_FUNCTION_TAN},
+    {"exists", INSIDE_FUNCTION_EXISTS}
+};
+
+/**
+ * @brief the one-param inside functions, indexed by InsideFunctionId
+*/
+static const UnaryInsideFunction s_unary_insidefunction_table[INSIDE_FUNCTION_COUNT] = {
+    nullptr, // atan
+    [](double v) { return std::abs(v); }, // abs
+    AcosDegree, // acos
+    AsinDegree, // asin
+    CosDegree, // cos
+    [](double v) { return std::exp(v); }, // exp
+    [](double v) { return std::floor(v); }, // fix, round down to integer
+    [](double v) { return std::ceil(v); }, // fup, round up to integer
+    [](double v) { return std::round(v); }, // round, round to nearest integer
+    [](double v) { return std::log(v); }, // ln
+    SinDegree, // sin
+    [](double v) { return std::sqrt(v); }, // sqrt
+    TanDegree, // tan
+    nullptr // exists
 };
 
+/**
+ * @brief the registered native functions, ids from INSIDE_FUNCTION_COUNT
+*/
+static std::shared_mutex s_native_function_mutex;
+static std::vector<std::shared_ptr<const NativeFunction>> s_native_function_list;
+static std::unordered_map<std::string, InsideFunctionId> s_native_function_id_map;
+
 bool IsInsideFunction(const std::string & function_name)
 {
-    return s_insidefunction_set.find(function_name) != s_insidefunction_set.end();
+    return GetInsideFunctionId(function_name).has_value();
+}
+
+std::optional<InsideFunctionId> GetInsideFunctionId(const std::string &function_name)
+{
+    auto it = s_insidefunction_id_map.find(function_name);
+    if (it != s_insidefunction_id_map.end()) return it->second;
+
+    std::shared_lock<std::shared_mutex> lock(s_native_function_mutex);
+    auto native_it = s_native_function_id_map.find(function_name);
+    if (native_it != s_native_function_id_map.end()) return native_it->second;
+
+    return std::nullopt;
+}
+
+InsideFunctionId RegisterNativeFunction(const std::string &name, std::size_t arity,
+    NativeFunctionCallback callback)
+{
+    std::string function_name = name;
+    std::transform(function_name.begin(), function_name.end(), function_name.begin(), [](int x) -> int {
+        return std::tolower(x);
+    });
+
+    std::stringstream ss;
+
+    // the name should be read by the Tokenizer as a whole IDENTIFIER
+    bool is_valid_name = false;
+    try {
+        Tokenizer tokenizer(function_name.cbegin(), function_name.cend());
+        auto&& token = tokenizer.getNextToken();
+        is_valid_name = !token.empty()
+            && Tokenizer::GetTokenType(token) == "IDENTIFIER"
+            && token.at("value").as_string() == function_name
+            && !tokenizer.hasMoreTokens();
+    } catch (const Exception&) {
+        // not a token at all
+    }
+
+    if (!is_valid_name) {
+        ss << "Invalid native function name: " << name;
+        throw Exception(ss.str());
+    }
+
+    if (arity < 1 || arity > NativeFunction::kMaxArity) {
+        ss << "Invalid native function arity: " << arity 
+           << ", should be in [1, " << NativeFunction::kMaxArity << "], name: " << name;
+        throw Exception(ss.str());
+    }
+
+    if (!callback) {
+        ss << "Empty native function callback, name: " << name;
+        throw Exception(ss.str());
+    }
+
+    std::unique_lock<std::shared_mutex> lock(s_native_function_mutex);
+
+    if (s_insidefunction_id_map.count(function_name) != 0 
+        || s_native_function_id_map.count(function_name) != 0) {
+        ss << "Inside function already exists: " << name;
+        throw Exception(ss.str());
+    }
+
+    auto function_id = static_cast<InsideFunctionId>(INSIDE_FUNCTION_COUNT + s_native_function_list.size());
+    s_native_function_list.push_back(std::make_shared<const NativeFunction>(
+        NativeFunction{function_name, arity, std::move(callback)}));
+    s_native_function_id_map.emplace(function_name, function_id);
+
+    return function_id;
+}
+
+std::shared_ptr<const NativeFunction> GetNativeFunction(InsideFunctionId function_id)
+{
+    if (!IsNativeFunctionId(function_id)) return nullptr;
+
+    std::shared_lock<std::shared_mutex> lock(s_native_function_mutex);
+    std::size_t index = function_id - INSIDE_FUNCTION_COUNT;
+    if (index >= s_native_function_list.size()) return nullptr;
+    return s_native_function_list[index];
+}
+
+std::vector<std::shared_ptr<const NativeFunction>> GetNativeFunctionList()
+{
+    std::shared_lock<std::shared_mutex> lock(s_native_function_mutex);
+    return s_native_function_list;
+}
+
+UnaryInsideFunction GetUnaryInsideFunction(InsideFunctionId function_id)
+{
+    if (function_id < 0 || function_id >= INSIDE_FUNCTION_COUNT) return nullptr;
+    return s_unary_insidefunction_table[function_id];
+}
+
+/******************************/
+/***  degree-domain kernels ***/
+/******************************/
+
+/**
+ * The kernels below are branch-free (only selections), so the loops calling
+ * them can be vectorized. They are exact at the special angles because:
+ *  - the angle is reduced by a multiple of 90 degrees, which is exact
+ *  - the results at 0/30/45 degrees in [-45, 45] are selected from constants
+*/
+
+// (x + magic) - magic rounds x to the nearest integer, for |x| < 2^51
+static constexpr double kRoundMagic = 6755399441055744.0; // 1.5 * 2^52
+
+// the kernels reduce angles up to this, larger angles are reduced by fmod first
+static constexpr double kMaxReducibleDegree = 1e15;
+
+static constexpr double kDegToRad = 0.017453292519943295769; // pi / 180
+static constexpr double kRadToDeg = 57.295779513082320877; // 180 / pi
+static constexpr double kSqrtHalf = 0.70710678118654752440; // sin[45], cos[45]
+static constexpr double kSqrt3Half = 0.86602540378443864676; // cos[30]
+static constexpr double kTan30 = 0.57735026918962576451;
+static constexpr double kSqrt3 = 1.7320508075688772935; // tan[60]
+static constexpr double kTan22_5 = 0.41421356237309504880;
+
+static inline double _round_to_integer(double x) {
+    return (x + kRoundMagic) - kRoundMagic;
+}
+
+/**
+ * @brief sin and cos of a degree, |degree| <= kMaxReducibleDegree
+ * @param quadrant output the multiple of 90 degrees reduced (mod 4, in -2..2)
+ * @param reduced output the reduced degree in [-45, 45]
+*/
+static inline void _sin_cos_degree_kernel(double degree, double& sin_value, double& cos_value,
+    double& quadrant, double& reduced)
+{
+    double n = _round_to_integer(degree * (1.0 / 90.0));
+    double d = degree - 90.0 * n; // exact
+
+    // taylor series, |x| <= pi/4, the error of the truncation is far below an ulp
+    double x = d * kDegToRad;
+    double x2 = x * x;
+    double s = x + x * x2 * (-1.0 / 6 + x2 * (1.0 / 120 + x2 * (-1.0 / 5040 + x2 * (1.0 / 362880
+        + x2 * (-1.0 / 39916800 + x2 * (1.0 / 6227020800 + x2 * (-1.0 / 1307674368000
+        + x2 * (1.0 / 355687428096000))))))));
+    double c = 1.0 + x2 * (-1.0 / 2 + x2 * (1.0 / 24 + x2 * (-1.0 / 720 + x2 * (1.0 / 40320
+        + x2 * (-1.0 / 3628800 + x2 * (1.0 / 479001600 + x2 * (-1.0 / 87178291200
+        + x2 * (1.0 / 20922789888000 + x2 * (-1.0 / 6402373705728000)))))))));
+
+    // exact special angles, 0 is already exact
+    double ad = std::abs(d);
+    s = ad == 30.0 ? std::copysign(0.5, d) : s;
+    c = ad == 30.0 ? kSqrt3Half : c;
+    s = ad == 45.0 ? std::copysign(kSqrtHalf, d) : s;
+    c = ad == 45.0 ? kSqrtHalf : c;
+
+    // n mod 4, in -2..2
+    double q = n - 4.0 * _round_to_integer(n * 0.25);
+
+    // sin(d + 90) = cos(d), sin(d - 90) = -cos(d), sin(d +- 180) = -sin(d)
+    sin_value = q == 0.0 ? s : (q == 1.0 ? c : (q == -1.0 ? -c : -s));
+    cos_value = q == 0.0 ? c : (q == 1.0 ? -s : (q == -1.0 ? s : -c));
+
+    // no negative zero
+    sin_value += 0.0;
+    cos_value += 0.0;
+
+    quadrant = q;
+    reduced = d;
+}
+
+static inline double _sin_degree_kernel(double degree) {
+    double s, c, q, d;
+    _sin_cos_degree_kernel(degree, s, c, q, d);
+    return s;
+}
+
+static inline double _cos_degree_kernel(double degree) {
+    double s, c, q, d;
+    _sin_cos_degree_kernel(degree, s, c, q, d);
+    return c;
+}
+
+static inline double _tan_degree_kernel(double degree) {
+    double s, c, q, d;
+    _sin_cos_degree_kernel(degree, s, c, q, d);
+
+    // tan(d) for even quadrants, -1/tan(d) for odd quadrants
+    bool is_odd = (q == 1.0 || q == -1.0);
+    double t = s / c;
+    double ad = std::abs(d);
+    t = ad == 30.0 ? (is_odd ? std::copysign(kSqrt3, -d) : std::copysign(kTan30, d)) : t;
+    t = (is_odd && d == 0.0) ? HUGE_VAL : t;
+    return t + 0.0;
+}
+
+/**
+ * @brief atan of t in [0, 1], in degrees
+*/
+static inline double _atan_unit_degree_kernel(double t)
+{
+    // atan(t) = 45 + atan((t - 1) / (t + 1)), which is in [-22.5, 0]
+    bool is_large = t > kTan22_5;
+    double u = is_large ? (t - 1.0) / (t + 1.0) : t;
+
+    // taylor series, |u| <= tan(pi/8), up to u^41
+    double u2 = u * u;
+    double p = 1.0 + u2 * (-1.0 / 3 + u2 * (1.0 / 5 + u2 * (-1.0 / 7 + u2 * (1.0 / 9
+        + u2 * (-1.0 / 11 + u2 * (1.0 / 13 + u2 * (-1.0 / 15 + u2 * (1.0 / 17 + u2 * (-1.0 / 19
+        + u2 * (1.0 / 21 + u2 * (-1.0 / 23 + u2 * (1.0 / 25 + u2 * (-1.0 / 27 + u2 * (1.0 / 29
+        + u2 * (-1.0 / 31 + u2 * (1.0 / 33 + u2 * (-1.0 / 35 + u2 * (1.0 / 37 + u2 * (-1.0 / 39
+        + u2 * (1.0 / 41))))))))))))))))))));
+    double a = u * p * kRadToDeg;
+
+    return is_large ? 45.0 + a : a;
+}
+
+static inline double _atan2_degree_kernel(double y, double x)
+{
+    double ay = std::abs(y);
+    double ax = std::abs(x);
+    bool is_swapped = ay > ax;
+    double num = is_swapped ? ax : ay;
+    double den = is_swapped ? ay : ax;
+    double t = den == 0.0 ? 0.0 : num / den;
+
+    double a = _atan_unit_degree_kernel(t);
+    a = is_swapped ? 90.0 - a : a;
+    a = std::copysign(1.0, x) < 0.0 ? 180.0 - a : a; // signbit, also for -0
+    return std::copysign(a, y);
+}
+
+static inline bool _is_reducible_degree(double degree) {
+    return std::abs(degree) <= kMaxReducibleDegree; // false for nan
+}
+
+double SinDegree(double degree)
+{
+    if (!_is_reducible_degree(degree)) degree = std::fmod(degree, 360.0);
+    return _sin_degree_kernel(degree);
+}
+
+double CosDegree(double degree)
+{
+    if (!_is_reducible_degree(degree)) degree = std::fmod(degree, 360.0);
+    return _cos_degree_kernel(degree);
+}
+
+double TanDegree(double degree)
+{
+    if (!_is_reducible_degree(degree)) degree = std::fmod(degree, 360.0);
+    return _tan_degree_kernel(degree);
+}
+
+double AsinDegree(double value)
+{
+    if (value == 0.0) return 0.0;
+    if (std::abs(value) == 0.5) return std::copysign(30.0, value);
+    if (std::abs(value) == 1.0) return std::copysign(90.0, value);
+    return std::asin(value) * kRadToDeg;
+}
+
+double AcosDegree(double value)
+{
+    if (value == 0.0) return 90.0;
+    if (value == 0.5) return 60.0;
+    if (value == -0.5) return 120.0;
+    if (value == 1.0) return 0.0;
+    if (value == -1.0) return 180.0;
+    return std::acos(value) * kRadToDeg;
+}
+
+double Atan2Degree(double y, double x)
+{
+    if (std::abs(y) <= DBL_MAX && std::abs(x) <= DBL_MAX) {
+        return _atan2_degree_kernel(y, x);
+    }
+    // inf or nan
+    return std::atan2(y, x) * kRadToDeg;
+}
+
+/****************************/
+/***   batch evaluation   ***/
+/****************************/
+
+// the block checked for the params that the kernels can not handle
+static constexpr std::size_t kBatchBlockSize = 256;
+
+template <typename Kernel>
+static void _batch_degree(const double* degree, double* result, std::size_t size,
+    Kernel kernel, UnaryInsideFunction scalar_function)
+{
+    for (std::size_t begin = 0; begin < size; begin += kBatchBlockSize) {
+        std::size_t end = std::min(begin + kBatchBlockSize, size);
+
+        std::size_t unreducible_count = 0;
+        for (std::size_t i = begin; i < end; ++i) {
+            unreducible_count += !_is_reducible_degree(degree[i]);
+        }
+
+        if (unreducible_count == 0) {
+            for (std::size_t i = begin; i < end; ++i) {
+                result[i] = kernel(degree[i]);
+            }
+        } else {
+            for (std::size_t i = begin; i < end; ++i) {
+                result[i] = scalar_function(degree[i]);
+            }
+        }
+    }
+}
+
+void BatchSinDegree(const double *degree, double *result, std::size_t size)
+{
+    _batch_degree(degree, result, size, [](double d) { return _sin_degree_kernel(d); }, SinDegree);
+}
+
+void BatchCosDegree(const double *degree, double *result, std::size_t size)
+{
+    _batch_degree(degree, result, size, [](double d) { return _cos_degree_kernel(d); }, CosDegree);
+}
+
+void BatchTanDegree(const double *degree, double *result, std::size_t size)
+{
+    _batch_degree(degree, result, size, [](double d) { return _tan_degree_kernel(d); }, TanDegree);
+}
+
+void BatchAtan2Degree(const double *y, const double *x, double *result, std::size_t size)
+{
+    for (std::size_t begin = 0; begin < size; begin += kBatchBlockSize) {
+        std::size_t end = std::min(begin + kBatchBlockSize, size);
+
+        std::size_t infinite_count = 0;
+        for (std::size_t i = begin; i < end; ++i) {
+            infinite_count += !(std::abs(y[i]) <= DBL_MAX && std::abs(x[i]) <= DBL_MAX);
+        }
+
+        if (infinite_count == 0) {
+            for (std::size_t i = begin; i < end; ++i) {
+                result[i] = _atan2_degree_kernel(y[i], x[i]);
+            }
+        } else {
+            for (std::size_t i = begin; i < end; ++i) {
+                result[i] = Atan2Degree(y[i], x[i]);
+            }
+        }
+    }
+}
+
+void BatchSqrt(const double *value, double *result, std::size_t size)
+{
+    for (std::size_t i = 0; i < size; ++i) {
+        result[i] = std::sqrt(value[i]);
+    }
+}
+
+void EvaluateInsideFunctionBatch(InsideFunctionId function_id,
+    const double *param, double *result, std::size_t size, const double *param2 /* = nullptr*/)
+{
+    switch (function_id) {
+    case INSIDE_FUNCTION_SIN:
+        BatchSinDegree(param, result, size);
+        return;
+    case INSIDE_FUNCTION_COS:
+        BatchCosDegree(param, result, size);
+        return;
+    case INSIDE_FUNCTION_TAN:
+        BatchTanDegree(param, result, size);
+        return;
+    case INSIDE_FUNCTION_SQRT:
+        BatchSqrt(param, result, size);
+        return;
+    case INSIDE_FUNCTION_ATAN:
+        if (param2 == nullptr) {
+            throw Exception("Batch evaluation of atan needs the second params");
+        }
+        BatchAtan2Degree(param, param2, result, size);
+        return;
+    default:
+        break;
+    }
+
+    auto function = GetUnaryInsideFunction(function_id);
+    if (function == nullptr) {
+        throw Exception("Batch evaluation is not supported by the inside function, id: "
+            + std::to_string(static_cast<int>(function_id)));
+    }
+
+    for (std::size_t i = 0; i < size; ++i) {
+        result[i] = function(param[i]);
+    }
 }
 
-    
 } // namespace rs274letter
@@ -1,10 +1,138 @@
 #pragma once
 
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace rs274letter
 {
 
-bool IsInsideFunction(const std::string& function_name); 
+/**
+ * InsideFunctionId
+ * The id of an inside function. The Parser binds it into the "functionId" of
+ * an insideFunctionExpression, so the Serializer dispatches through a table
+ * instead of comparing the function names.
+ * The ids from INSIDE_FUNCTION_COUNT on are the registered native functions.
+*/
+enum InsideFunctionId : int {
+    INSIDE_FUNCTION_ATAN = 0,
+    INSIDE_FUNCTION_ABS,
+    INSIDE_FUNCTION_ACOS,
+    INSIDE_FUNCTION_ASIN,
+    INSIDE_FUNCTION_COS,
+    INSIDE_FUNCTION_EXP,
+    INSIDE_FUNCTION_FIX,
+    INSIDE_FUNCTION_FUP,
+    INSIDE_FUNCTION_ROUND,
+    INSIDE_FUNCTION_LN,
+    INSIDE_FUNCTION_SIN,
+    INSIDE_FUNCTION_SQRT,
+    INSIDE_FUNCTION_TAN,
+    INSIDE_FUNCTION_EXISTS,
+
+    INSIDE_FUNCTION_COUNT
+};
+
+/**
+ * @brief returns true if the name (lower case) is a built-in or registered native function
+*/
+bool IsInsideFunction(const std::string& function_name);
+
+/**
+ * @brief get the id of a built-in or registered native function name (lower case)
+ * @return std::nullopt if it is not an inside function
+*/
+std::optional<InsideFunctionId> GetInsideFunctionId(const std::string& function_name);
+
+/**
+ * NativeFunction
+ * A C++ function registered to be called in the expressions like a built-in
+ * inside function, with `arity` params: `name[param1][param2]...`
+ * The callback gets the `arity` calculated params, it may throw an Exception
+ * to stop the Serializer.
+*/
+using NativeFunctionCallback = std::function<double(const double* params)>;
+
+struct NativeFunction {
+    static constexpr std::size_t kMaxArity = 8;
+
+    std::string name;
+    std::size_t arity;
+    NativeFunctionCallback callback;
+};
+
+/**
+ * @brief register a native function, the name is converted to lower case.
+ * Register before parsing the programs which call it. `Program::compile()`
+ * binds the registered functions, the calls then go through the id
+ * without any lookup of the name.
+ * It is thread-safe, but should usually be done at the start up.
+ * @return the id of the function
+ * @throw Exception if the name is not a valid identifier (at least 2 chars, no keyword
+ * or operator prefix like `ne`/`or`), is already a built-in or registered function,
+ * or the arity is not in [1, NativeFunction::kMaxArity], or the callback is empty
+*/
+InsideFunctionId RegisterNativeFunction(const std::string& name, std::size_t arity,
+    NativeFunctionCallback callback);
+
+inline bool IsNativeFunctionId(InsideFunctionId function_id) {
+    return function_id >= INSIDE_FUNCTION_COUNT;
+}
+
+/**
+ * @brief get a registered native function
+ * @return nullptr if the id is not registered
+*/
+std::shared_ptr<const NativeFunction> GetNativeFunction(InsideFunctionId function_id);
+
+/**
+ * @brief a snapshot of the registered native functions,
+ * indexed by `function_id - INSIDE_FUNCTION_COUNT`
+*/
+std::vector<std::shared_ptr<const NativeFunction>> GetNativeFunctionList();
+
+using UnaryInsideFunction = double (*)(double);
+
+/**
+ * @brief get the function calculating a one-param inside function,
+ * the angles are in degrees
+ * @return nullptr for atan (two params) and exists (not a value function)
+*/
+UnaryInsideFunction GetUnaryInsideFunction(InsideFunctionId function_id);
+
+/**
+ * Degree-domain trigonometric functions
+ * The angle is reduced to [-45, 45] degrees exactly before converting to
+ * radians, so the results at the multiples of 30 and 45 degrees are exact,
+ * like sin[30] == 0.5, cos[90] == 0, tan[45] == 1, atan[1]/[1] == 45.
+ * tan at the odd multiples of 90 degrees is +inf.
+*/
+double SinDegree(double degree);
+double CosDegree(double degree);
+double TanDegree(double degree);
+double AsinDegree(double value);
+double AcosDegree(double value);
+double Atan2Degree(double y, double x);
+
+/**
+ * Batch evaluation
+ * Evaluate an inside function over arrays of params, the results are the same
+ * as the scalar functions above. sin/cos/tan/atan/sqrt run branch-free kernels
+ * which are vectorized by the compiler, the others loop over the scalar function.
+ * `result` may be the same array as `param`.
+ * @param param2 the second params of atan, not used by the other functions
+ * @throw Exception for exists, or atan without param2
+*/
+void EvaluateInsideFunctionBatch(InsideFunctionId function_id,
+    const double* param, double* result, std::size_t size, const double* param2 = nullptr);
+
+void BatchSinDegree(const double* degree, double* result, std::size_t size);
+void BatchCosDegree(const double* degree, double* result, std::size_t size);
+void BatchTanDegree(const double* degree, double* result, std::size_t size);
+void BatchAtan2Degree(const double* y, const double* x, double* result, std::size_t size);
+void BatchSqrt(const double* value, double* result, std::size_t size);
 
 } // namespace rs274letter
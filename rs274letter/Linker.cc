@@ -0,0 +1,303 @@
+// Linker.cc
+#include "Linker.h"
+
+#include "macro.h"
+
+#include <cmath>
+#include <sstream>
+
+namespace rs274letter
+{
+
+// keep the same as Serializer::_s_double_to_integer_tolerance
+static const double s_double_to_integer_tolerance = 1e-6;
+
+// public static method for linking
+LinkResult Linker::link(AstObject& program)
+{
+    RS274LETTER_ASSERT(program.at("type").as_string() == "program");
+
+    Linker linker;
+    linker.linkStatementList(program["body"].as_array());
+    linker.bindOCallStatements();
+
+    return std::move(linker._result);
+}
+
+void Linker::linkStatementList(AstArray &statement_list)
+{
+    for (auto& statement : statement_list) {
+        auto& statement_object = statement.as_object();
+
+        auto statement_id = this->_result.statement_line_list.size();
+        this->_result.statement_line_list.push_back(
+            statement_object.contains("line") ? statement_object.at("line").as_integer() : 0);
+        this->_result.statement_sub_index_list.push_back(this->_sub_index);
+        statement_object["statementId"] = static_cast<int>(statement_id);
+
+        this->linkStatement(statement_object);
+    }
+}
+
+void Linker::linkStatement(AstObject &statement)
+{
+    auto&& statement_type = statement.at("type").as_string();
+
+    std::stringstream ss;
+
+    if (statement_type == "oIfStatement") {
+        this->linkOIfStatement(statement);
+    } else if (statement_type == "oWhileStatement") {
+        this->linkOWhileStatement(statement);
+    } else if (statement_type == "oRepeatStatement") {
+        this->linkORepeatStatement(statement);
+    } else if (statement_type == "oSubStatement") {
+        this->linkOSubStatement(statement);
+    } else if (statement_type == "oCallStatement") {
+        this->_o_call_statement_list.push_back(&statement);
+    } else if (statement_type == "oContinueStatement" || statement_type == "oBreakStatement") {
+        // the parser makes sure that we are in a loop
+        if (this->_loop_o_word_stack.empty()) {
+            ss << "Internal Error, " << statement_type << " is not in a loop";
+            throw LinkError(ss.str());
+        }
+
+        auto&& o_word = statement_type == "oContinueStatement"
+            ? statement.at("continueOCommand").as_object()
+            : statement.at("breakOCommand").as_object();
+
+        // only break/continue the nearest loop
+        this->examineOWordMatch(o_word, *this->_loop_o_word_stack.back(), statement_type);
+    } else if (statement_type == "oReturnStatement") {
+        // the parser makes sure that we are in a sub
+        if (this->_sub_o_word == nullptr) {
+            ss << "Internal Error, " << statement_type << " is not in a sub";
+            throw LinkError(ss.str());
+        }
+
+        this->examineOWordMatch(statement.at("returnOCommand").as_object(),
+            *this->_sub_o_word, statement_type);
+    }
+
+    // commandStatement, expressionStatement have nothing to link
+}
+
+void Linker::linkOIfStatement(AstObject &o_if_statement)
+{
+    // the expanded `elseif` is the `alternate`, whose ifOCommand is the o-word
+    // in front of `elseif`, which has been examined in the otherWordsList of
+    // the oIfStatement before it, the chain is walked in a loop, it may be long
+    AstObject* if_statement = &o_if_statement;
+    while (true) {
+        auto&& if_o_word = if_statement->at("ifOCommand").as_object();
+
+        // o-words in front of elseif/else/endif
+        for (const auto& o_word : if_statement->at("otherWordsList").as_array()) {
+            this->examineOWordMatch(o_word.as_object(), if_o_word, "oIfStatement");
+        }
+
+        this->linkStatementList((*if_statement)["consequent"].as_array());
+
+        auto& alternate = (*if_statement)["alternate"];
+        if (!alternate.is_object()) {
+            this->linkStatementList(alternate.as_array());
+            return;
+        }
+        if_statement = &alternate.as_object();
+    }
+}
+
+void Linker::linkOWhileStatement(AstObject &o_while_statement)
+{
+    auto&& while_o_word = o_while_statement.at("whileOCommand").as_object();
+    this->examineOWordMatch(o_while_statement.at("endwhileOCommand").as_object(),
+        while_o_word, "oWhileStatement");
+
+    this->_loop_o_word_stack.push_back(&while_o_word);
+    this->linkStatementList(o_while_statement["body"].as_array());
+    this->_loop_o_word_stack.pop_back();
+}
+
+void Linker::linkORepeatStatement(AstObject &o_repeat_statement)
+{
+    auto&& repeat_o_word = o_repeat_statement.at("repeatOCommand").as_object();
+    this->examineOWordMatch(o_repeat_statement.at("endrepeatOCommand").as_object(),
+        repeat_o_word, "oRepeatStatement");
+
+    this->_loop_o_word_stack.push_back(&repeat_o_word);
+    this->linkStatementList(o_repeat_statement["body"].as_array());
+    this->_loop_o_word_stack.pop_back();
+}
+
+void Linker::linkOSubStatement(AstObject &o_sub_statement)
+{
+    std::stringstream ss;
+
+    auto&& sub_o_word = o_sub_statement.at("subOCommand").as_object();
+    this->examineOWordMatch(o_sub_statement.at("endsubOCommand").as_object(),
+        sub_o_word, "oSubStatement");
+
+    // register the sub
+    if (auto&& sub_o_word_value = calcOWord(sub_o_word)) {
+        auto sub_index = this->_result.sub_list.size();
+
+        bool inserted = false;
+        if (std::holds_alternative<int>(sub_o_word_value.value())) {
+            inserted = this->_numberindex_sub_index_map.emplace(
+                std::get<int>(sub_o_word_value.value()), sub_index).second;
+        } else {
+            inserted = this->_nameindex_sub_index_map.emplace(
+                std::get<std::string>(sub_o_word_value.value()), sub_index).second;
+        }
+
+        if (!inserted) {
+            ss << "Duplicate o-sub definition: " << GetOWordShowString(sub_o_word);
+            throw LinkError(ss.str());
+        }
+
+        this->_result.sub_list.push_back(&o_sub_statement);
+        o_sub_statement["linkedSubIndex"] = static_cast<int>(sub_index);
+        this->_sub_index = static_cast<int>(sub_index);
+    } else {
+        // registered when the runtime reaches this sub
+        this->_result.has_dynamic_sub = true;
+    }
+
+    // the parser does not allow nested o-sub
+    RS274LETTER_ASSERT(this->_sub_o_word == nullptr);
+
+    // loops outside the sub can not be broken inside the sub
+    auto loop_o_word_stack_outside = std::move(this->_loop_o_word_stack);
+    this->_loop_o_word_stack.clear();
+    this->_sub_o_word = &sub_o_word;
+
+    this->linkStatementList(o_sub_statement["body"].as_array());
+
+    this->_sub_o_word = nullptr;
+    this->_sub_index = -1;
+    this->_loop_o_word_stack = std::move(loop_o_word_stack_outside);
+}
+
+void Linker::bindOCallStatements()
+{
+    for (auto&& o_call_statement : this->_o_call_statement_list) {
+        auto&& call_o_word = o_call_statement->at("callOCommand").as_object();
+        auto&& call_o_word_value = calcOWord(call_o_word);
+
+        if (!call_o_word_value) {
+            // looked up at runtime
+            continue;
+        }
+
+        std::optional<std::size_t> sub_index;
+        if (std::holds_alternative<int>(call_o_word_value.value())) {
+            auto it = this->_numberindex_sub_index_map.find(std::get<int>(call_o_word_value.value()));
+            if (it != this->_numberindex_sub_index_map.end()) sub_index = it->second;
+        } else {
+            auto it = this->_nameindex_sub_index_map.find(std::get<std::string>(call_o_word_value.value()));
+            if (it != this->_nameindex_sub_index_map.end()) sub_index = it->second;
+        }
+
+        if (sub_index) {
+            (*o_call_statement)["linkedSubIndex"] = static_cast<int>(sub_index.value());
+        } else if (!this->_result.has_dynamic_sub) {
+            // no sub could be registered at runtime, the call can never succeed
+            std::stringstream ss;
+            ss << "Undefined o-call subject: " << GetOWordShowString(call_o_word);
+            throw LinkError(ss.str());
+        }
+    }
+}
+
+void Linker::examineOWordMatch(const AstObject &o_word, const AstObject &expected_o_word,
+    const std::string &statement_type) const
+{
+    auto&& value = calcOWord(o_word);
+    auto&& expected_value = calcOWord(expected_o_word);
+
+    // can not be calculated statically, skip
+    if (!value || !expected_value) return;
+
+    if (value.value() != expected_value.value()) {
+        std::stringstream ss;
+        ss << "o-word does not match in " << statement_type
+           << "\nexpected: " << GetOWordShowString(expected_o_word)
+           << "\ngot: " << GetOWordShowString(o_word);
+        throw LinkError(ss.str());
+    }
+}
+
+std::optional<Linker::OWordValue> Linker::calcOWord(const AstObject &o_word)
+{
+    auto&& o_word_type = o_word.at("type").as_string();
+
+    if (o_word_type == "nameIndexOCommand") {
+        return o_word.at("index").as_string();
+    }
+
+    RS274LETTER_ASSERT(o_word_type == "numberIndexOCommand");
+
+    auto&& index = calcConstantExpression(o_word.at("index").as_object());
+    if (!index) return std::nullopt;
+
+    auto&& d = index.value();
+    if (d < 0.0 || std::abs(d - std::round(d)) > s_double_to_integer_tolerance) {
+        std::stringstream ss;
+        ss << "Invalid o-word number index larger than tolerance or is negetive:"
+           << "\ntolerance:" << s_double_to_integer_tolerance
+           << "\no-word:" << o_word.to_string();
+        throw LinkError(ss.str());
+    }
+
+    return static_cast<int>(std::round(d));
+}
+
+std::optional<double> Linker::calcConstantExpression(const AstObject &expression)
+{
+    auto&& expression_type = expression.at("type").as_string();
+
+    if (expression_type == "doubleNumericLiteral" || expression_type == "integerNumericLiteral") {
+        return expression.at("value").as_double();
+    }
+
+    if (expression_type != "binaryExpression") {
+        // variables, inside functions, assignments: calculated at runtime
+        return std::nullopt;
+    }
+
+    auto&& left = calcConstantExpression(expression.at("left").as_object());
+    if (!left) return std::nullopt;
+    auto&& right = calcConstantExpression(expression.at("right").as_object());
+    if (!right) return std::nullopt;
+
+    auto&& op = expression.at("operator").as_string();
+    if (op == "+") {
+        return left.value() + right.value();
+    } else if (op == "-") {
+        return left.value() - right.value();
+    } else if (op == "*") {
+        return left.value() * right.value();
+    } else if (op == "/") {
+        return left.value() / right.value();
+    } else if (op == "**") {
+        return std::pow(left.value(), right.value());
+    }
+
+    // relational and logical operators are not expected in an o-word
+    return std::nullopt;
+}
+
+std::string Linker::GetOWordShowString(const AstObject &o_word)
+{
+    std::stringstream ss;
+    if (o_word.at("type").as_string() == "nameIndexOCommand") {
+        ss << "o<" << o_word.at("index").as_string() << ">";
+    } else if (auto&& index = calcConstantExpression(o_word.at("index").as_object())) {
+        ss << "o" << index.value();
+    } else {
+        ss << "o" << o_word.at("index").to_string();
+    }
+    return ss.str();
+}
+
+} // namespace rs274letter
@@ -0,0 +1,134 @@
+// Linker.h
+#pragma once
+
+#include <string>
+#include <optional>
+#include <variant>
+#include <vector>
+#include <unordered_map>
+
+#include "json.hpp"
+
+#include "Parser.h"
+#include "Exception.h"
+
+namespace rs274letter
+{
+
+class LinkError : public Exception {
+public:
+    LinkError(const std::string& str) : Exception(str) { }
+    virtual const char* what() const noexcept override {
+        _str
+            = "RS274Exception: LinkError:\n" + _str;
+        return _str.c_str();
+    }
+};
+
+/**
+ * LinkResult
+ * The sub table built by `Linker::link()`.
+ * The subs are referred by pointers into the linked AstObject, so the linked
+ * AstObject should outlive the LinkResult, and should not be modified after linking.
+*/
+struct LinkResult {
+    // indexed by the "linkedSubIndex" written into oSubStatement and oCallStatement
+    std::vector<const AstObject*> sub_list;
+
+    // true if any o-sub's o-word can only be calculated at runtime (like `o[#50] sub`),
+    // in this case an unbound o-call is looked up at runtime instead of rejected
+    bool has_dynamic_sub = false;
+
+    // indexed by the "statementId" written into each statement of the statement lists:
+    // the source line of the statement (0 if unknown), and the linkedSubIndex of
+    // the sub it is in (-1 if not in a sub, or in a sub of a dynamic o-word)
+    std::vector<int> statement_line_list;
+    std::vector<int> statement_sub_index_list;
+};
+
+/**
+ * Linker
+ * The link pass between `Parser::parse()` and `Serializer::processProgram()`.
+ *  - builds the sub table, so a sub can be called before its definition
+ *  - binds every `o... call` to its target sub by writing a "linkedSubIndex"
+ *  - numbers the statements by writing a "statementId", for the per-statement
+ *    counters like the ExecutionProfiler
+ *  - examines the o-words of if/while/repeat/sub blocks and of the
+ *    break/continue/return statements
+ * An o-word is examined only if it can be calculated without variables,
+ * the o-words like `o[#50]` are left to the runtime.
+ * @throw LinkError if any examine fails
+*/
+class Linker {
+public:
+    ~Linker() noexcept = default;
+
+    /**
+     * link()
+     * link the parsed program in place, and return the sub table
+    */
+    static LinkResult link(AstObject& program);
+
+    /**
+     * GetOWordShowString()
+     * the o-word as it is shown in the error messages, like `o<name>` or `o100`
+    */
+    static std::string GetOWordShowString(const AstObject& o_word);
+
+private:
+    Linker() = default;
+
+    // a calculated o-word: int for numberIndexOCommand, std::string for nameIndexOCommand
+    using OWordValue = std::variant<int, std::string>;
+
+    void linkStatementList(AstArray& statement_list);
+    void linkStatement(AstObject& statement);
+
+    void linkOIfStatement(AstObject& o_if_statement);
+    void linkOWhileStatement(AstObject& o_while_statement);
+    void linkORepeatStatement(AstObject& o_repeat_statement);
+    void linkOSubStatement(AstObject& o_sub_statement);
+
+    /**
+     * bindOCallStatements()
+     * called after all the subs are collected, bind each collected o-call
+    */
+    void bindOCallStatements();
+
+    /**
+     * examineOWordMatch()
+     * throw if both o-words could be calculated, but they are not the same
+    */
+    void examineOWordMatch(const AstObject& o_word, const AstObject& expected_o_word,
+        const std::string& statement_type) const;
+
+    /**
+     * calcOWord()
+     * @return std::nullopt if the o-word can only be calculated at runtime
+    */
+    static std::optional<OWordValue> calcOWord(const AstObject& o_word);
+
+    /**
+     * calcConstantExpression()
+     * calc an expression which does not refer to any variable
+     * @return std::nullopt if the expression is not a constant expression
+    */
+    static std::optional<double> calcConstantExpression(const AstObject& expression);
+
+private:
+    LinkResult _result;
+
+    // the statically calculated sub o-word to the index of _result.sub_list
+    std::unordered_map<int, std::size_t> _numberindex_sub_index_map;
+    std::unordered_map<std::string, std::size_t> _nameindex_sub_index_map;
+
+    // collected o-calls, bound after all subs are collected
+    std::vector<AstObject*> _o_call_statement_list;
+
+    // the o-word of the nearest loop, and of the sub being linked
+    std::vector<const AstObject*> _loop_o_word_stack;
+    const AstObject* _sub_o_word = nullptr;
+    int _sub_index = -1;
+};
+
+} // namespace rs274letter
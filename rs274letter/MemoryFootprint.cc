@@ -0,0 +1,105 @@
+// MemoryFootprint.cc
+#include "MemoryFootprint.h"
+
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+namespace rs274letter
+{
+
+// the pointers and the color of a tree node of an object member
+static constexpr std::size_t kObjectMemberNodeOverhead = 4 * sizeof(void*);
+
+static void _measure_object(const AstObject& object, AstFootprint& footprint);
+
+// the heap held by the value, the value itself is counted by its container
+static void _measure_value_heap(const AstValue& value, AstFootprint& footprint)
+{
+    if (value.is_object()) {
+        footprint.bytes += sizeof(AstObject);
+        _measure_object(value.as_object(), footprint);
+    } else if (value.is_array()) {
+        auto&& array = value.as_array();
+        footprint.bytes += sizeof(AstArray) + array.size() * sizeof(AstValue);
+        for (auto&& element : array) {
+            _measure_value_heap(element, footprint);
+        }
+    } else if (value.is_string()) {
+        footprint.bytes += MemoryFootprint::StringBytes(value.as_string());
+    } else if (value.is_number()) {
+        // kept as the raw string by meojson
+        footprint.bytes += MemoryFootprint::StringBytes(value.to_string());
+    }
+}
+
+static void _measure_object(const AstObject& object, AstFootprint& footprint)
+{
+    for (auto&& [key, member] : object) {
+        footprint.bytes += sizeof(std::pair<const std::string, AstValue>) + kObjectMemberNodeOverhead
+            + MemoryFootprint::StringBytes(key);
+        _measure_value_heap(member, footprint);
+    }
+
+    if (object.contains("type") && object.at("type").is_string()) {
+        ++footprint.node_count;
+        ++footprint.node_type_count_map[object.at("type").as_string()];
+    }
+}
+
+AstFootprint AstFootprint::Measure(const AstObject& ast)
+{
+    AstFootprint footprint;
+    footprint.bytes += sizeof(AstObject);
+    _measure_object(ast, footprint);
+    return footprint;
+}
+
+std::string MemoryFootprint::toString() const
+{
+    std::stringstream ss;
+    auto line = [&ss](const char* name, std::size_t bytes) {
+        ss << std::setw(16) << name << ": " << std::setw(12) << bytes << " bytes\n";
+    };
+
+    line("program", this->program_bytes);
+    line("variables", this->variable_bytes);
+    line("subs", this->sub_bytes);
+    line("frame stack", this->frame_stack_bytes);
+    line("checkpoints", this->checkpoint_bytes);
+    line("command output", this->command_output_bytes);
+    line("total", this->getTotalBytes());
+
+    ss << std::setw(16) << "ast nodes" << ": " << std::setw(12) << this->ast.node_count << "\n";
+    for (auto&& [type, count] : this->ast.node_type_count_map) {
+        ss << std::setw(32) << type << ": " << std::setw(12) << count << "\n";
+    }
+
+    return ss.str();
+}
+
+void* CountingMemoryResource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    auto p = this->_upstream->allocate(bytes, alignment);
+
+    this->_bytes += bytes;
+    ++this->_allocation_count;
+    if (this->_bytes > this->_peak_bytes) {
+        this->_peak_bytes = this->_bytes;
+    }
+
+    return p;
+}
+
+void CountingMemoryResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+{
+    this->_upstream->deallocate(p, bytes, alignment);
+    this->_bytes -= bytes;
+}
+
+bool CountingMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+} // namespace rs274letter
@@ -0,0 +1,130 @@
+// MemoryFootprint.h
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory_resource>
+#include <string>
+
+#include "Parser.h"
+
+namespace rs274letter
+{
+
+/**
+ * AstFootprint
+ * The estimated heap bytes of an AST, and the count of its nodes per "type".
+ * meojson does not show its layout, so each value, object member and array
+ * element is counted by the size of its type, with a node overhead for each
+ * object member and the heap of the long strings. Good to compare programs
+ * and to set limits with a margin, not exact to the byte.
+*/
+struct AstFootprint {
+    std::size_t bytes = 0;
+    std::size_t node_count = 0; // the objects with a "type"
+    std::map<std::string, std::size_t> node_type_count_map;
+
+    /**
+     * Measure()
+     * walk the whole AST, O(size of the AST)
+    */
+    static AstFootprint Measure(const AstObject& ast);
+};
+
+/**
+ * MemoryFootprint
+ * The bytes held by a Serializer per component, see
+ * `Serializer::getMemoryFootprint()`. The bytes of the containers are
+ * estimated from their sizes and capacities, like the AstFootprint.
+*/
+struct MemoryFootprint {
+    std::size_t program_bytes = 0; // the AST and the link result, shared by the Serializers of a Program
+    std::size_t variable_bytes = 0; // the variable maps, the initial variables and the call params
+    std::size_t sub_bytes = 0; // the o-word sets and the sub maps
+    std::size_t frame_stack_bytes = 0; // with the caller variables saved by the o-calls
+    std::size_t checkpoint_bytes = 0;
+    std::size_t command_output_bytes = 0; // the commands kept by the default CommandListSink
+
+    AstFootprint ast;
+
+    inline std::size_t getTotalBytes() const {
+        return this->program_bytes + this->variable_bytes + this->sub_bytes
+            + this->frame_stack_bytes + this->checkpoint_bytes + this->command_output_bytes;
+    }
+
+    /**
+     * toString()
+     * the bytes of each component, and the node count of each node type
+    */
+    std::string toString() const;
+
+    /*** estimation helpers for the components ***/
+
+    // the heap of a string, 0 if it fits in the small string buffer
+    static inline std::size_t StringBytes(const std::string& str) {
+        return str.capacity() > std::string().capacity() ? str.capacity() + 1 : 0;
+    }
+
+    // a vector with its capacity, without the heap of the elements
+    template <typename Vector>
+    static inline std::size_t VectorBytes(const Vector& vector) {
+        return vector.capacity() * sizeof(typename Vector::value_type);
+    }
+
+    // the nodes of an unordered container, each with the next pointer and the
+    // cached hash, and the bucket array, without the heap of the elements
+    template <typename HashContainer>
+    static inline std::size_t HashContainerBytes(const HashContainer& container) {
+        return container.size() * (sizeof(typename HashContainer::value_type) + 2 * sizeof(void*))
+            + container.bucket_count() * sizeof(void*);
+    }
+
+    // a list with the two pointers of each node
+    template <typename List>
+    static inline std::size_t ListBytes(const List& list) {
+        return list.size() * (sizeof(typename List::value_type) + 2 * sizeof(void*));
+    }
+};
+
+/**
+ * CountingMemoryResource
+ * Forwards to the upstream resource and counts the bytes allocated now, at
+ * the peak, and the allocations. Construct a Serializer with it to get the
+ * peak bytes of its runtime state and of its commands during processProgram():
+ *  CountingMemoryResource counting_resource;
+ *  Serializer s(&counting_resource);
+ *  s.reset(program);
+ *  s.processProgram();
+ *  counting_resource.getPeakBytes();
+ * The keys of the name-indexed maps are std::string on the global heap, they
+ * are not counted here but in the MemoryFootprint.
+ * Not thread-safe, like the Serializer using it.
+*/
+class CountingMemoryResource : public std::pmr::memory_resource {
+public:
+    explicit CountingMemoryResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) noexcept
+        : _upstream(upstream) {}
+
+    inline std::size_t getBytes() const { return this->_bytes; }
+    inline std::size_t getPeakBytes() const { return this->_peak_bytes; }
+    inline std::size_t getAllocationCount() const { return this->_allocation_count; }
+
+    // start a new peak from the current bytes
+    inline void resetPeak() { this->_peak_bytes = this->_bytes; }
+
+    inline std::pmr::memory_resource* getUpstream() const { return this->_upstream; }
+
+protected:
+    virtual void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    virtual void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+    virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+    std::pmr::memory_resource* _upstream;
+
+    std::size_t _bytes = 0;
+    std::size_t _peak_bytes = 0;
+    std::size_t _allocation_count = 0;
+};
+
+} // namespace rs274letter
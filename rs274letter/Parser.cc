@@ -8,10 +8,61 @@
 
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 namespace rs274letter
 {
 
+static void _emplace_members(AstObject&) {}
+
+template <typename Value, typename... Rest>
+static void _emplace_members(AstObject& object, const char* key, Value&& value, Rest&&... rest) {
+    object.emplace(key, std::forward<Value>(value));
+    _emplace_members(object, std::forward<Rest>(rest)...);
+}
+
+/**
+ * _make_ast_object()
+ * Build an AstObject from the key-value pairs: _make_ast_object("type", "xx", "left", std::move(left))
+ * `AstObject{ {"left", left} }` goes through an std::initializer_list, which can only
+ * be copied from, so each node built like that copies all its subtrees once more.
+ * Here the values are forwarded, pass the subtrees with std::move().
+*/
+template <typename... Members>
+static AstObject _make_ast_object(Members&&... members) {
+    AstObject object;
+    _emplace_members(object, std::forward<Members>(members)...);
+    return object;
+}
+
+/**
+ * NestingScope
+ * Entered by the rules which recurse: statementList, once for each o-block
+ * body, primaryExpression, once for each bracket, sign or `#`, and
+ * numberIndex when it does not go through primaryExpression. Each loop of
+ * the recursion passes one of them.
+*/
+template <typename Dialect>
+class BasicParser<Dialect>::NestingScope {
+public:
+    NestingScope(BasicParser* parser) : _parser(parser) {
+        if (_parser->_nesting_depth >= kMaxNestingDepth) {
+            std::stringstream ss;
+            ss << "Nesting deeper than " << kMaxNestingDepth << " levels\n"
+               << _parser->_tokenizer->getLineColumnShowString();
+            throw SyntaxError(ss.str());
+        }
+        ++_parser->_nesting_depth;
+    }
+
+    ~NestingScope() noexcept {
+        --_parser->_nesting_depth;
+    }
+
+private:
+    BasicParser* _parser;
+};
+
 // class _BackupParserState {
 //     friend class Parser;
 // public:
@@ -40,32 +91,55 @@ namespace rs274letter
 // };
 
 // public static method for parsing 
-AstObject Parser::parse(const std::string& string) {
-    return Parser(string.cbegin(), string.cend()).parse();
+template <typename Dialect>
+AstObject BasicParser<Dialect>::parse(const std::string& string) {
+    ParserStats stats;
+    return BasicParser::parse(string, stats);
+}
+
+template <typename Dialect>
+AstObject BasicParser<Dialect>::parse(const std::string& string, ParserStats& stats) {
+    util::TraceScope trace_scope("parse");
+    BasicParser parser(string.cbegin(), string.cend());
+    auto program = parser.parse();
+
+    auto tokenizer_stats = parser._tokenizer->getStats();
+    stats.programs = 1;
+    stats.statements = parser._statement_count;
+    stats.tokens = tokenizer_stats.tokens;
+    stats.lines = tokenizer_stats.lines;
+    stats.bytes = tokenizer_stats.bytes;
+    GlobalStats::Add(stats);
+
+    return program;
 }
 
 // construtor
-Parser::Parser(const std::string::const_iterator& cbegin, const std::string::const_iterator& cend)
+template <typename Dialect>
+BasicParser<Dialect>::BasicParser(const std::string::const_iterator& cbegin, const std::string::const_iterator& cend)
     : _tokenizer(std::make_unique<Tokenizer>(cbegin, cend)) {
     // get the first token as lookahead
+    util::TraceScope trace_scope("tokenize", util::Trace::TOKEN);
     this->_lookahead = this->_tokenizer->getNextToken();
 }
 
 // private member method
-AstObject Parser::parse()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::parse()
 {
     return this->program();
 }
 
-AstObject Parser::program()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::program()
 {
-    return AstObject{
-        {"type", "program"},
-        {"body", this->statementList()}
-    };
+    return _make_ast_object(
+        "type", "program",
+        "body", this->statementList()
+    );
 }
 
-static bool _is_lookahead_stoptokentypes(const Token& lookahead, std::vector<TokenType> vec) {
+static bool _is_lookahead_stoptokentypes(const Token& lookahead, const std::vector<TokenType>& vec) {
     auto && next_type = Tokenizer::GetTokenType(lookahead);
 
     for (auto&& type : vec) {
@@ -76,17 +150,25 @@ static bool _is_lookahead_stoptokentypes(const Token& lookahead, std::vector<Tok
     return false;
 }
 
-AstArray Parser::statementList(const std::optional<std::vector<TokenType>>& stop_lookahead_tokentypes_after_o /*= std::nullopt*/) {
+template <typename Dialect>
+AstArray BasicParser<Dialect>::statementList(const std::optional<std::vector<TokenType>>& stop_lookahead_tokentypes_after_o /*= std::nullopt*/) {
+    NestingScope nesting_scope(this);
     AstArray statement_list;
 
     while(!this->_lookahead.empty()) {
+        // the lookahead is the first token of the statement, not a "RTN",
+        // so the current line of the tokenizer is the line of the statement
+        auto line = static_cast<int>(this->_tokenizer->getCurLine());
+
         if (Tokenizer::GetTokenType(this->_lookahead) != "O") {
             // Not a statement(line) start with 'O'
-            auto&& statement = this->statement();
+            auto statement = this->statement();
 
             // may return an emptyStatement which is an empty AstObject()
             if (!statement.empty()) {
-                statement_list.emplace_back(statement);
+                statement.emplace("line", line);
+                statement_list.emplace_back(std::move(statement));
+                ++this->_statement_count;
             }
 
             continue; // next statement
@@ -95,11 +177,11 @@ AstArray Parser::statementList(const std::optional<std::vector<TokenType>>& stop
         // encounter a statement which starts with an O
 
         // get the o-word
-        auto&& o_word = this->oCommand();
+        auto o_word = this->oCommand();
 
         if (stop_lookahead_tokentypes_after_o 
             && _is_lookahead_stoptokentypes(this->_lookahead, 
-            stop_lookahead_tokentypes_after_o.value_or(std::vector<TokenType>()))) {
+            stop_lookahead_tokentypes_after_o.value())) {
             // meet the tokentype specified in `stop_lookahead_tokentypes_after_o`
 
             // record the eaten o-word here
@@ -112,14 +194,18 @@ AstArray Parser::statementList(const std::optional<std::vector<TokenType>>& stop
             // or haven't met the stop generating flags specified
             
             // emplace back a oCommandStatement with the given pre-o-word(which is eaten)
-            statement_list.emplace_back(this->oCommandStatement(o_word));
+            auto statement = this->oCommandStatement(std::move(o_word));
+            statement.emplace("line", line);
+            statement_list.emplace_back(std::move(statement));
+            ++this->_statement_count;
         }
     }
 
     return statement_list;
 }
 
-AstObject Parser::statement()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::statement()
 {
     auto&& lookahead_type = Tokenizer::GetTokenType(this->_lookahead);
     // auto curline = this->_tokenizer->getCurLine();
@@ -149,38 +235,37 @@ AstObject Parser::statement()
 //     };
 // }
 
-AstObject Parser::commandStatement()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::commandStatement()
 {
-    auto&& command_number_group_list = this->commandNumberGroupList();
+    auto command_number_group_list = this->commandNumberGroupList();
     
     if (!this->_lookahead.empty()) this->eat("RTN");
 
-    return AstObject{
-        {"type", "commandStatement"},
-        {"commands", command_number_group_list} // body is an array
-    };
+    return _make_ast_object(
+        "type", "commandStatement",
+        "commands", std::move(command_number_group_list) // body is an array
+    );
 }
 
-AstObject Parser::expressionStatement()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::expressionStatement()
 {
-#ifdef NO_SINGLE_NON_ASSIGN_EXPRESSION
-    auto&& expression = this->expression(true); // must be assignment
-#else // NOT NO_SINGLE_NON_ASSIGN_EXPRESSION
-    auto&& expression = this->expression(); // must be assignment
-#endif // NO_SINGLE_NON_ASSIGN_EXPRESSION
+    auto expression = this->expression(Dialect::kNoSingleNonAssignExpression); // if must be assignment
     
     if (!this->_lookahead.empty()) this->eat("RTN");
 
-    return AstObject{
-        {"type", "expressionStatement"},
-        {"expression", expression}
-    };
+    return _make_ast_object(
+        "type", "expressionStatement",
+        "expression", std::move(expression)
+    );
 }
 
-AstObject Parser::oCommandStatement(const std::optional<AstObject> pre_o_word/* = std::nullopt*/)
+template <typename Dialect>
+AstObject BasicParser<Dialect>::oCommandStatement(std::optional<AstObject> pre_o_word/* = std::nullopt*/)
 {
     // given the pre_o_word or not ?
-    auto&& o_command_start = pre_o_word ? pre_o_word.value() : this->oCommand();
+    auto o_command_start = pre_o_word ? std::move(pre_o_word.value()) : this->oCommand();
     RS274LETTER_ASSERT(
         o_command_start.at("type").as_string() == "nameIndexOCommand" || 
         o_command_start.at("type").as_string() == "numberIndexOCommand");
@@ -188,44 +273,45 @@ AstObject Parser::oCommandStatement(const std::optional<AstObject> pre_o_word/*
     auto&& next_type_after_o = Tokenizer::GetTokenType(this->_lookahead);
 
     if (next_type_after_o == "call") {
-        return this->oCallStatement(o_command_start);
+        return this->oCallStatement(std::move(o_command_start));
     } else if (next_type_after_o == "if") {
-        return this->oIfStatement(o_command_start);
+        return this->oIfStatement(std::move(o_command_start));
     } else if (next_type_after_o == "sub") {
-        return this->oSubStatement(o_command_start);
+        return this->oSubStatement(std::move(o_command_start));
     } else if (next_type_after_o == "return") {
-        return this->oReturnStatement(o_command_start);
+        return this->oReturnStatement(std::move(o_command_start));
     } else if (next_type_after_o == "while") {
-        return this->oWhileStatement(o_command_start);
+        return this->oWhileStatement(std::move(o_command_start));
     } else if (next_type_after_o == "continue") {
-        return this->oContinueStatement(o_command_start);
+        return this->oContinueStatement(std::move(o_command_start));
     } else if (next_type_after_o == "break") {
-        return this->oBreakStatement(o_command_start);
+        return this->oBreakStatement(std::move(o_command_start));
     } else if (next_type_after_o == "repeat") {
-        return this->oRepeatStatement(o_command_start);
+        return this->oRepeatStatement(std::move(o_command_start));
     } else {
         std::cout << util::BacktraceToString(100) << std::endl;
         throw SyntaxError("Unexpected token type after oCommand: " + next_type_after_o);
     }
 }
 
-AstObject Parser::oCallStatement(const AstObject &o_command_start)
+template <typename Dialect>
+AstObject BasicParser<Dialect>::oCallStatement(AstObject o_command_start)
 {
     this->eat("call");
-    auto call_o_command = o_command_start;
 
-    auto&& param_list = this->oCallParamList();
+    auto param_list = this->oCallParamList();
 
     if (!this->_lookahead.empty()) this->eat("RTN");
     
-    return AstObject{
-        {"type", "oCallStatement"},
-        {"callOCommand", std::move(call_o_command)},
-        {"paramList", param_list}
-    };
+    return _make_ast_object(
+        "type", "oCallStatement",
+        "callOCommand", std::move(o_command_start),
+        "paramList", std::move(param_list)
+    );
 }
 
-AstObject Parser::oReturnStatement(const AstObject &o_command_start)
+template <typename Dialect>
+AstObject BasicParser<Dialect>::oReturnStatement(AstObject o_command_start)
 {
     if (this->_parsing_o_sub == false) {
         std::stringstream ss;
@@ -235,7 +321,6 @@ AstObject Parser::oReturnStatement(const AstObject &o_command_start)
     }
 
     this->eat("return");
-    auto return_o_command = o_command_start;
 
     AstObject return_expression;
     if (!this->_lookahead.empty() 
@@ -243,14 +328,15 @@ AstObject Parser::oReturnStatement(const AstObject &o_command_start)
         return_expression = this->parenthesizedExpression();
     }
     
-    return AstObject{
-        {"type", "oReturnStatement"},
-        {"returnOCommand", std::move(return_o_command)},
-        {"returnRtnExpr", std::move(return_expression)}
-    };
+    return _make_ast_object(
+        "type", "oReturnStatement",
+        "returnOCommand", std::move(o_command_start),
+        "returnRtnExpr", std::move(return_expression)
+    );
 }
 
-AstArray Parser::oCallParamList()
+template <typename Dialect>
+AstArray BasicParser<Dialect>::oCallParamList()
 {
     AstArray param_list;
 
@@ -262,38 +348,15 @@ AstArray Parser::oCallParamList()
     return param_list;
 }
 
-AstObject Parser::oIfStatement(const AstObject &o_command_start, bool should_eat_if/* = true*/)
+template <typename Dialect>
+AstObject BasicParser<Dialect>::oIfStatement(AstObject o_command_start)
 {
-    // should_eat_if is false when want to get a sub `elseif` statement
-    if (should_eat_if) this->eat("if");
-
-    // The `const reference` to o_command_start may refer to
-    // `this->_last_o_word` which may change during recursively
-    // calling `this->statementList()`. 
-    // So I make a copy here, and finally use std::move() to construct
-    // it into the AstObject's { "oIfCommand", std::move(if_o_command) }
-    // For example, if we don't copy here, when this oIfStatement is called
-    // by an oIfStatement() function itself, that is, in an `elseif`,
-    // we get a `o_command_start` which is bound to this->_last_o_word,
-    // when we skip out and eat an `endif`, this->_last_o_word will change
-    // to the o-word in front of `endif`, this time, `o_command_start` also
-    // changes !! 
-    auto if_o_command = o_command_start;
-
-    auto&& test = this->parenthesizedExpression();
-    this->eat("RTN");
+    this->eat("if");
 
-    // `o_word_list` is used to collect the o-words written for this whole 
-    // `oIfStatement`, we will examine whether these o-words are the same 
-    // value as each other in the future, to meet rs274 standard
-    AstArray o_word_list; 
-    // o_word_list.emplace_back(o_command_start);
-
-    // tell the statementList
-    // when encounter an oStatement and the next is else, elseif or endif
-    // stop generating list, with an pre-o-word eaten now,
-    // so we need to collect this eaten o-word later from this->_last_o_word
-    auto&& consequent = this->statementList({{"else", "elseif", "endif"}});
+    // `o_command_start` is taken by value, the caller moves the o-word in.
+    // The o-word of an `elseif` comes from `this->_last_o_word`, which
+    // changes during calling `this->statementList()`, when we skip out and
+    // eat an `endif`, it changes to the o-word in front of `endif`.
 
     /**
      * About how to deal with `elseif`:
@@ -314,36 +377,54 @@ AstObject Parser::oIfStatement(const AstObject &o_command_start, bool should_eat
      *          o1 if [#3]
      *          o1 else
      *          o1 endif
-     */
+     * 
+     * The branches are parsed in a loop, not recursively, so a long chain
+     * of `elseif` is not a deep nesting, and the chain is built from the
+     * last branch after the `endif`.
+    */
+    struct Branch {
+        AstObject o_command_start;
+        AstObject test;
+        AstArray consequent;
+        // `o_word_list` is used to collect the o-words written for this
+        // branch, we will examine whether these o-words are the same 
+        // value as each other in the future, to meet rs274 standard
+        AstArray o_word_list;
+    };
+    std::vector<Branch> branch_list;
+
+    while (true) {
+        Branch branch;
+        branch.o_command_start = std::move(o_command_start);
+        branch.test = this->parenthesizedExpression();
+        this->eat("RTN");
+
+        // tell the statementList
+        // when encounter an oStatement and the next is else, elseif or endif
+        // stop generating list, with an pre-o-word eaten now,
+        // so we need to collect this eaten o-word later from this->_last_o_word
+        branch.consequent = this->statementList({{"else", "elseif", "endif"}});
+
+        if (this->_lookahead.empty() 
+            || Tokenizer::GetTokenType(this->_lookahead) != "elseif") {
+            branch_list.emplace_back(std::move(branch));
+            break;
+        }
 
-    // elseif
-    if (!this->_lookahead.empty() 
-        && Tokenizer::GetTokenType(this->_lookahead) == "elseif") {
         // if next is elseif, eat an `elseif`
         this->eat("elseif");
-        
-        // _last_o_word here is the o-word in front of this `elseif`
-        o_word_list.emplace_back(this->_last_o_word);
- 
-        // without eating an if, get an ifStatement recursively
-        // pass the false, means not to eat if at the start of the function
-        auto&& sub_o_if_statement = this->oIfStatement(this->_last_o_word, false);
-
-        // directly returns an ifStatement here,
-        // because there will only be an `endif` in the whole if-block,
-        // and we will deal with the maybe-incoming `else` in the sub_o_if_statement,
-        // so we don't have to eat another `endif` or `else` after 
-        // getting this sub_o_if_statement .
-        return AstObject{
-            {"type", "oIfStatement"},
-            {"ifOCommand", std::move(if_o_command)},
-            {"test", test},
-            {"consequent", consequent},
-            {"alternate", sub_o_if_statement},
-            {"otherWordsList", std::move(o_word_list)}
-        };
+
+        // _last_o_word here is the o-word in front of this `elseif`,
+        // one copy for the examine, the other one starts the next branch
+        branch.o_word_list.emplace_back(this->_last_o_word);
+        o_command_start = std::move(this->_last_o_word);
+        branch_list.emplace_back(std::move(branch));
     }
 
+    // there will only be an `else` and an `endif` in the whole if-block,
+    // they belong to the last branch
+    auto&& last_branch = branch_list.back();
+
     // else
     AstArray alternate; // alternate is the `else` 's statementList
     if (!this->_lookahead.empty() 
@@ -352,27 +433,34 @@ AstObject Parser::oIfStatement(const AstObject &o_command_start, bool should_eat
         this->eat("else");
 
         // _last_o_word here is the o-word in front of this `else`
-        o_word_list.emplace_back(this->_last_o_word);
+        last_branch.o_word_list.emplace_back(std::move(this->_last_o_word));
         alternate = this->statementList({{"endif"}});
     }
 
     // _last_o_word here is the o-word in front of this `endif`
-    o_word_list.emplace_back(this->_last_o_word);
+    last_branch.o_word_list.emplace_back(std::move(this->_last_o_word));
     this->eat("endif");
     
     if (!this->_lookahead.empty()) this->eat("RTN");
 
-    return AstObject{
-        {"type", "oIfStatement"},
-        {"ifOCommand", std::move(if_o_command)},
-        {"test", test},
-        {"consequent", consequent},
-        {"alternate", std::move(alternate)},
-        {"otherWordsList", std::move(o_word_list)}
-    };
+    // from the last branch, each one is the `alternate` of the one before
+    AstValue o_if_statement = std::move(alternate);
+    for (auto it = branch_list.rbegin(); it != branch_list.rend(); ++it) {
+        o_if_statement = _make_ast_object(
+            "type", "oIfStatement",
+            "ifOCommand", std::move(it->o_command_start),
+            "test", std::move(it->test),
+            "consequent", std::move(it->consequent),
+            "alternate", std::move(o_if_statement),
+            "otherWordsList", std::move(it->o_word_list)
+        );
+    }
+
+    return std::move(o_if_statement.as_object());
 }
 
-AstObject Parser::oSubStatement(const AstObject &o_command_start)
+template <typename Dialect>
+AstObject BasicParser<Dialect>::oSubStatement(AstObject o_command_start)
 {   
     RS274LETTER_ASSERT(this->_parsing_o_sub == false);
     if (this->_parsing_o_sub == true) {
@@ -385,9 +473,8 @@ AstObject Parser::oSubStatement(const AstObject &o_command_start)
     this->_parsing_o_sub = true; // marked as parsing sub start
 
     this->eat("sub");
-    auto sub_o_command = o_command_start;
 
-    auto&& body = this->statementList({{"sub", "endsub"}});
+    auto body = this->statementList({{"sub", "endsub"}});
 
     // Do not allow nested o-sub !
     if (!this->_lookahead.empty() 
@@ -399,6 +486,7 @@ AstObject Parser::oSubStatement(const AstObject &o_command_start)
         throw SyntaxError(ss.str());
     }
 
+    auto endsub_o_command = std::move(this->_last_o_word);
     this->eat("endsub");
 
     AstObject return_expression;
@@ -411,111 +499,115 @@ AstObject Parser::oSubStatement(const AstObject &o_command_start)
 
     this->_parsing_o_sub = false; // marked as parsing sub end
 
-    return AstObject{
-        {"type", "oSubStatement"},
-        {"subOCommand", std::move(sub_o_command)},
-        {"endsubOCommand", this->_last_o_word},
-        {"body", body},
-        {"endsubRtnExpr", std::move(return_expression)}
-    };
+    return _make_ast_object(
+        "type", "oSubStatement",
+        "subOCommand", std::move(o_command_start),
+        "endsubOCommand", std::move(endsub_o_command),
+        "body", std::move(body),
+        "endsubRtnExpr", std::move(return_expression)
+    );
 }
 
-AstObject Parser::oWhileStatement(const AstObject &o_command_start)
+template <typename Dialect>
+AstObject BasicParser<Dialect>::oWhileStatement(AstObject o_command_start)
 {
-    ++this->_parsing_o_while_layers;
-    auto while_o_command = o_command_start;
+    ++this->_parsing_o_loop_layers;
 
     this->eat("while");
 
     // condition(test)
-    auto&& test = this->parenthesizedExpression();
+    auto test = this->parenthesizedExpression();
     this->eat("RTN");
 
     // body
-    auto&& body = this->statementList({{"endwhile"}});
+    auto body = this->statementList({{"endwhile"}});
 
     // endwhile
-    auto endwhile_o_command = this->_last_o_word;
+    auto endwhile_o_command = std::move(this->_last_o_word);
     this->eat("endwhile");
     if (!this->_lookahead.empty()) this->eat("RTN");
 
-    --this->_parsing_o_while_layers;
-    return AstObject{
-        {"type", "oWhileStatement"},
-        {"whileOCommand", std::move(while_o_command)},
-        {"endwhileOCommand", std::move(endwhile_o_command)},
-        {"test", test},
-        {"body", body},
-        {"nestedLayer", this->_parsing_o_while_layers + 1} // layers, used for debug
-    };
+    --this->_parsing_o_loop_layers;
+    return _make_ast_object(
+        "type", "oWhileStatement",
+        "whileOCommand", std::move(o_command_start),
+        "endwhileOCommand", std::move(endwhile_o_command),
+        "test", std::move(test),
+        "body", std::move(body),
+        "nestedLayer", this->_parsing_o_loop_layers + 1 // layers, used for debug
+    );
 }
 
-AstObject Parser::oContinueStatement(const AstObject &o_command_start)
+template <typename Dialect>
+AstObject BasicParser<Dialect>::oContinueStatement(AstObject o_command_start)
 {
-    if (this->_parsing_o_while_layers < 1) {
+    if (this->_parsing_o_loop_layers < 1) {
         std::stringstream ss;
-        ss << "o-continue statement should be in a while-statement\n"
+        ss << "o-continue statement should be in a while-statement or a repeat-statement\n"
            << this->_tokenizer->getLineColumnShowString();
         throw SyntaxError(ss.str());
     }
 
-    auto continue_o_command = this->_last_o_word;
     this->eat("continue");
     
-    return AstObject{
-        {"type", "oContinueStatement"},
-        {"continueOCommand", std::move(continue_o_command)},
-        {"nestedLayer", this->_parsing_o_while_layers}
-    };
+    return _make_ast_object(
+        "type", "oContinueStatement",
+        "continueOCommand", std::move(o_command_start),
+        "nestedLayer", this->_parsing_o_loop_layers
+    );
 }
 
-AstObject Parser::oBreakStatement(const AstObject & o_command_start)
+template <typename Dialect>
+AstObject BasicParser<Dialect>::oBreakStatement(AstObject o_command_start)
 {
-    if (this->_parsing_o_while_layers < 1) {
+    if (this->_parsing_o_loop_layers < 1) {
         std::stringstream ss;
-        ss << "o-break statement should be in a while-statement\n"
+        ss << "o-break statement should be in a while-statement or a repeat-statement\n"
            << this->_tokenizer->getLineColumnShowString();
         throw SyntaxError(ss.str());
     }
 
-    auto break_o_command = this->_last_o_word;
     this->eat("break");
     
-    return AstObject{
-        {"type", "oBreakStatement"},
-        {"breakOCommand", std::move(break_o_command)},
-        {"nestedLayer", this->_parsing_o_while_layers}
-    };
+    return _make_ast_object(
+        "type", "oBreakStatement",
+        "breakOCommand", std::move(o_command_start),
+        "nestedLayer", this->_parsing_o_loop_layers
+    );
 }
 
-AstObject Parser::oRepeatStatement(const AstObject &o_command_start)
+template <typename Dialect>
+AstObject BasicParser<Dialect>::oRepeatStatement(AstObject o_command_start)
 {
-    auto repeat_o_command = o_command_start;
+    ++this->_parsing_o_loop_layers;
 
     this->eat("repeat");
 
     // repeat times
-    auto&& times = this->parenthesizedExpression();
+    auto times = this->parenthesizedExpression();
     this->eat("RTN");
 
     // body
-    auto&& body = this->statementList({{"endrepeat"}});
+    auto body = this->statementList({{"endrepeat"}});
 
     // endrepeat
-    auto endrepeat_o_command = this->_last_o_word;
+    auto endrepeat_o_command = std::move(this->_last_o_word);
     this->eat("endrepeat");
     if (!this->_lookahead.empty()) this->eat("RTN");
 
-    return AstObject{
-        {"type", "oRepeatStatement"},
-        {"repeatOCommand", std::move(repeat_o_command)},
-        {"endrepeatOCommand", std::move(endrepeat_o_command)},
-        {"times", times},
-        {"body", body}
-    };
+    --this->_parsing_o_loop_layers;
+    return _make_ast_object(
+        "type", "oRepeatStatement",
+        "repeatOCommand", std::move(o_command_start),
+        "endrepeatOCommand", std::move(endrepeat_o_command),
+        "times", std::move(times),
+        "body", std::move(body),
+        "nestedLayer", this->_parsing_o_loop_layers + 1 // layers, used for debug
+    );
 }
 
-AstArray Parser::commandNumberGroupList()
+template <typename Dialect>
+AstArray BasicParser<Dialect>::commandNumberGroupList()
 {
     AstArray command_number_group_list;
 
@@ -527,53 +619,57 @@ AstArray Parser::commandNumberGroupList()
     return command_number_group_list;
 }
 
-AstObject Parser::commandNumberGroup()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::commandNumberGroup()
 {
     // eat a letter
-    auto&& letter = this->eat("LETTER");
+    auto letter = this->eat("LETTER");
 
     // transform letter to lower case
     std::transform(letter.begin(), letter.end(), letter.begin(), ::tolower);
     
     // number or sth (which can be calced as a number)
-    auto&& number = this->primaryExpression();
+    auto number = this->primaryExpression();
 
-    return AstObject{
-        {"type", "commandNumberGroup"},
-        {"letter", letter},
-        {"number", std::move(number)}
-    };
+    return _make_ast_object(
+        "type", "commandNumberGroup",
+        "letter", std::move(letter),
+        "number", std::move(number)
+    );
 }
 
-AstObject Parser::oCommand()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::oCommand()
 {
     this->eat("O");
     auto&& type = Tokenizer::GetTokenType(this->_lookahead);
 
     if (type == "VAR_NAME") {
         // #<_var_name_>
-        return AstObject{
-            {"type", "nameIndexOCommand"},
-            {"index", this->nameIndex()}
-        };
+        return _make_ast_object(
+            "type", "nameIndexOCommand",
+            "index", this->nameIndex()
+        );
     } else {
-        return AstObject{
-            {"type", "numberIndexOCommand"},
-            {"index", this->numberIndex()}
-        };
+        return _make_ast_object(
+            "type", "numberIndexOCommand",
+            "index", this->numberIndex()
+        );
     }
 }
 
-AstObject Parser::expression(bool must_be_assignment/* = false*/)
+template <typename Dialect>
+AstObject BasicParser<Dialect>::expression(bool must_be_assignment/* = false*/)
 {
     return this->assignmentExpression(must_be_assignment);
 }
 
-AstObject Parser::assignmentExpression(bool must_be_assignment/* = false*/)
+template <typename Dialect>
+AstObject BasicParser<Dialect>::assignmentExpression(bool must_be_assignment/* = false*/)
 {
     // auto&& left = this->additiveExpression();
     // auto&& left = this->relationalExpression();
-    auto&& left = this->logicalExpression();
+    auto left = this->logicalExpression();
 
     if (!this->IsAssignmentOperator(this->_lookahead)) {
         // if must_be_assignment, throw SyntaxError here
@@ -593,30 +689,37 @@ AstObject Parser::assignmentExpression(bool must_be_assignment/* = false*/)
     } 
 
     // this `assignmentExpression` is EXACTLY an assignmentExpression
-    return AstObject{
-        {"type", "assignmentExpression"},
-        {"operator", this->assignmentOperator()},
-        {"left", this->IsValidAssignmentTarget(left)}, // The additiveExpression may not be a valid `leftHandSideExpresion`
-#ifdef MUST_PRIMARY_RIGHT_HANDSIDE_OF_ASSIGN
-        {"right", this->primaryExpression()} // need to be a primary expression in rs274
-#else // NOT MUST_PRIMARY_RIGHT_HANDSIDE_OF_ASSIGN
-        {"right", this->assignmentExpression()} 
-#endif // MUST_PRIMARY_RIGHT_HANDSIDE_OF_ASSIGN
-    };
+    auto op = this->assignmentOperator();
+    this->IsValidAssignmentTarget(left); // The additiveExpression may not be a valid `leftHandSideExpresion`
+    AstObject right;
+    if constexpr (Dialect::kMustPrimaryRightHandsideOfAssign) {
+        right = this->primaryExpression(); // need to be a primary expression in rs274
+    } else {
+        right = this->assignmentExpression();
+    }
+
+    return _make_ast_object(
+        "type", "assignmentExpression",
+        "operator", std::move(op),
+        "left", std::move(left),
+        "right", std::move(right)
+    );
 }
 
-TokenValue Parser::assignmentOperator()
+template <typename Dialect>
+TokenValue BasicParser<Dialect>::assignmentOperator()
 {
     return this->eat("ASSIGN_OPERATOR");
 }
 
-AstObject Parser::logicalExpression()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::logicalExpression()
 {
-    auto&& left = this->relationalExpression();
+    auto left = this->relationalExpression();
 
     while (Tokenizer::GetTokenType(this->_lookahead) == "LOGICAL_OPERATOR") {
-        auto&& op = this->eat("LOGICAL_OPERATOR"); // eat the operator
-        auto&& right = this->relationalExpression(); // get the right hand side expression
+        auto op = this->eat("LOGICAL_OPERATOR"); // eat the operator
+        auto right = this->relationalExpression(); // get the right hand side expression
 
         std::transform(op.begin(), op.end(), op.begin(), [](int x) -> int {
             if (std::isalpha(x)) {
@@ -628,24 +731,25 @@ AstObject Parser::logicalExpression()
 
         // make the original left, be the "left-hand-side" of new left, 
         // since the original left found a right-hand-side expression
-        left = AstObject{
-            {"type", "binaryExpression"},
-            {"operator", op},
-            {"left", left},
-            {"right", right}
-        };
+        left = _make_ast_object(
+            "type", "binaryExpression",
+            "operator", std::move(op),
+            "left", std::move(left),
+            "right", std::move(right)
+        );
     }
 
     return left;
 }
 
-AstObject Parser::relationalExpression()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::relationalExpression()
 {
-    auto&& left = this->additiveExpression();
+    auto left = this->additiveExpression();
 
     while (Tokenizer::GetTokenType(this->_lookahead) == "RELATIONAL_OPERATOR") {
-        auto&& op = this->eat("RELATIONAL_OPERATOR"); // eat the operator
-        auto&& right = this->additiveExpression(); // get the right hand side expression
+        auto op = this->eat("RELATIONAL_OPERATOR"); // eat the operator
+        auto right = this->additiveExpression(); // get the right hand side expression
 
         std::transform(op.begin(), op.end(), op.begin(), [](int x) -> int {
             if (std::isalpha(x)) {
@@ -657,21 +761,22 @@ AstObject Parser::relationalExpression()
 
         // make the original left, be the "left-hand-side" of new left, 
         // since the original left found a right-hand-side expression
-        left = AstObject{
-            {"type", "binaryExpression"},
-            {"operator", op},
-            {"left", left},
-            {"right", right}
-        };
+        left = _make_ast_object(
+            "type", "binaryExpression",
+            "operator", std::move(op),
+            "left", std::move(left),
+            "right", std::move(right)
+        );
     }
 
     return left;
 }
 
-AstObject Parser::additiveExpression()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::additiveExpression()
 {   
     // an `additiveExpression` may just be a `multiplicativeExpression`
-    auto&& left = this->multiplicativeExpression();
+    auto left = this->multiplicativeExpression();
 
     // or have an ADDITIVE_OPERATOR with right-hand-side-multiplicativeExpression
     // while loop to expand nested additive expression
@@ -679,88 +784,93 @@ AstObject Parser::additiveExpression()
     // e.g. 1 + 2 * 3 would be -> left:1, op:+, right:(2 * 3), to make this expansion
     // e.g. 1 * 4 + 2 + 3 would be -> left:(1 * 4), op:+, right:2 -> left:(1 * 4) + 2, op:+, right:3 , to make this expansion
     while (Tokenizer::GetTokenType(this->_lookahead) == "ADDITIVE_OPERATOR") {
-        auto&& op = this->eat("ADDITIVE_OPERATOR"); // eat the operator
-        auto&& right = this->multiplicativeExpression(); // get the right hand side expression
+        auto op = this->eat("ADDITIVE_OPERATOR"); // eat the operator
+        auto right = this->multiplicativeExpression(); // get the right hand side expression
 
         // make the original left, be the "left-hand-side" of new left, 
         // since the original left found a right-hand-side expression
-        left = AstObject{
-            {"type", "binaryExpression"},
-            {"operator", op},
-            {"left", left},
-            {"right", right}
-        };
+        left = _make_ast_object(
+            "type", "binaryExpression",
+            "operator", std::move(op),
+            "left", std::move(left),
+            "right", std::move(right)
+        );
     }
 
     return left;
 }
 
-AstObject Parser::multiplicativeExpression()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::multiplicativeExpression()
 {
     // an `multiplicativeExpression` may just be a `primaryExpression`
-    auto&& left = this->powExpression();
+    auto left = this->powExpression();
 
     // or have an MULTIPLICATIVE_OPERATOR with right-hand-side-primaryExpression
     // while loop to expand nested multiplicativeExpression
     while (Tokenizer::GetTokenType(this->_lookahead) == "MULTIPLICATIVE_OPERATOR") {
-        auto&& op = this->eat("MULTIPLICATIVE_OPERATOR"); // eat the operator
-        auto&& right = this->powExpression(); // get the right hand side expression
+        auto op = this->eat("MULTIPLICATIVE_OPERATOR"); // eat the operator
+        auto right = this->powExpression(); // get the right hand side expression
 
         // make the original left, be the "left-hand-side" of new left, 
         // since the original left found a right-hand-side expression
-        left = AstObject{
-            {"type", "binaryExpression"},
-            {"operator", op},
-            {"left", left},
-            {"right", right}
-        };
+        left = _make_ast_object(
+            "type", "binaryExpression",
+            "operator", std::move(op),
+            "left", std::move(left),
+            "right", std::move(right)
+        );
     }
 
     return left;
 }
 
-AstObject Parser::powExpression()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::powExpression()
 {
     // an `powExpression` may just be a `primaryExpression`
-    auto&& left = this->primaryExpression();
+    auto left = this->primaryExpression();
 
     // or have an POW_OPERATOR with right-hand-side-primaryExpression
     // while loop to expand nested powExpression
     while (Tokenizer::GetTokenType(this->_lookahead) == "POW_OPERATOR") {
-        auto&& op = this->eat("POW_OPERATOR"); // eat the operator "**"
-        auto&& right = this->primaryExpression(); // get the right hand side expression
+        auto op = this->eat("POW_OPERATOR"); // eat the operator "**"
+        auto right = this->primaryExpression(); // get the right hand side expression
 
         // make the original left, be the "left-hand-side" of new left, 
         // since the original left found a right-hand-side expression
-        left = AstObject{
-            {"type", "binaryExpression"},
-            {"operator", op},
-            {"left", left},
-            {"right", right}
-        };
+        left = _make_ast_object(
+            "type", "binaryExpression",
+            "operator", std::move(op),
+            "left", std::move(left),
+            "right", std::move(right)
+        );
     }
 
     return left;
 }
 
-AstObject Parser::primaryExpression(/*bool can_have_forward_additive_op = true*/)
+template <typename Dialect>
+AstObject BasicParser<Dialect>::primaryExpression(/*bool can_have_forward_additive_op = true*/)
 {
+    NestingScope nesting_scope(this);
     auto&& type = Tokenizer::GetTokenType(this->_lookahead);
     
     if (type == "ADDITIVE_OPERATOR"/* && can_have_forward_additive_op*/) {
         // 一元运算符，正、负，识别为additive，包装为一个省略0的加减法表达式
-        auto zero = AstObject{
-            {"type", "integerNumericLiteral"},
-            {"value", 0}
-        };
-        auto&& op = this->eat("ADDITIVE_OPERATOR");
-
-        return AstObject{
-            {"type", "binaryExpression"},
-            {"operator", op},
-            {"left", std::move(zero)},
-            {"right", this->primaryExpression()}
-        };
+        auto zero = _make_ast_object(
+            "type", "integerNumericLiteral",
+            "value", 0
+        );
+        auto op = this->eat("ADDITIVE_OPERATOR");
+        auto right = this->primaryExpression();
+
+        return _make_ast_object(
+            "type", "binaryExpression",
+            "operator", std::move(op),
+            "left", std::move(zero),
+            "right", std::move(right)
+        );
     } else if ( type == "INTEGER" || type == "DOUBLE" ) {
         return this->numericLiteral();
     } else if (type == "[") {
@@ -772,9 +882,10 @@ AstObject Parser::primaryExpression(/*bool can_have_forward_additive_op = true*/
     }
 }
 
-AstObject Parser::insideFunctionExpression()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::insideFunctionExpression()
 {
-    auto&& function_name = this->eat("IDENTIFIER");
+    auto function_name = this->eat("IDENTIFIER");
     std::transform(function_name.begin(), function_name.end(), function_name.begin(), [](int x) -> int {
         if (std::isalpha(x)) {
             return std::tolower(x);
@@ -785,15 +896,16 @@ AstObject Parser::insideFunctionExpression()
 
     std::stringstream ss;
 
-    // examine whether the function name is valid
-    if (!IsInsideFunction(function_name)) {
+    // examine whether the function name is valid, and bind its id
+    auto&& function_id = GetInsideFunctionId(function_name);
+    if (!function_id) {
         ss << "Unexpected identifier name: " << function_name << "\n"
            << this->_tokenizer->getLineColumnShowString();
         throw SyntaxError(ss.str());
     }
 
     AstValue param;
-    if (function_name == "atan") {
+    if (function_id.value() == INSIDE_FUNCTION_ATAN) {
         param.array_emplace(this->parenthesizedExpression());
         
         // syntax: atan[...]/[...]
@@ -808,12 +920,28 @@ AstObject Parser::insideFunctionExpression()
 
         param.array_emplace(this->parenthesizedExpression());
 
+    } else if (IsNativeFunctionId(function_id.value())) {
+        // syntax: name[...][...], one parenthesizedExpression for each param
+        auto&& native_function = GetNativeFunction(function_id.value());
+        RS274LETTER_ASSERT(native_function != nullptr);
+
+        for (std::size_t i = 0; i < native_function->arity; ++i) {
+            if (this->_lookahead.empty()
+                || Tokenizer::GetTokenType(this->_lookahead) != "[") {
+                ss << "Native function " << function_name << " should have " 
+                   << native_function->arity << " params like: " << function_name << "[1][2]\n"
+                   << this->_tokenizer->getLineColumnShowString();
+                throw SyntaxError(ss.str());
+            }
+            param.array_emplace(this->parenthesizedExpression());
+        }
+
     } else {
         param = this->parenthesizedExpression();
     }
 
     // special function: exists[#<var_name>] / exists[#1]
-    if (function_name == "exists") {
+    if (function_id.value() == INSIDE_FUNCTION_EXISTS) {
         // check the param
         if (param.at("type").as_string() != "nameIndexVariable"
             && param.at("type").as_string() != "numberIndexVariable") {
@@ -823,21 +951,24 @@ AstObject Parser::insideFunctionExpression()
         }
     }
 
-    return AstObject{
-        {"type", "insideFunctionExpression"},
-        {"functionName", function_name},
-        {"param", param}
-    };
+    return _make_ast_object(
+        "type", "insideFunctionExpression",
+        "functionName", std::move(function_name),
+        "functionId", static_cast<int>(function_id.value()),
+        "param", std::move(param)
+    );
 }
 
-AstObject Parser::parenthesizedExpression()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::parenthesizedExpression()
 {
     this->eat("[");
-#ifdef DO_NOT_ALLOW_MULTIPLE_ASSIGN
-    auto&& expression = this->logicalExpression();
-#else // NOT DO_NOT_ALLOW_MULTIPLE_ASSIGN
-    auto&& expression = this->expression(); 
-#endif // DO_NOT_ALLOW_MULTIPLE_ASSIGN
+    AstObject expression;
+    if constexpr (Dialect::kDoNotAllowMultipleAssign) {
+        expression = this->logicalExpression();
+    } else {
+        expression = this->expression();
+    }
     RS274LETTER_ASSERT(!expression.empty()); // inside the [ ] should be an expression which should be empty
          
     this->eat("]");
@@ -845,12 +976,14 @@ AstObject Parser::parenthesizedExpression()
     return expression;
 }
 
-AstObject Parser::leftHandSideExpression()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::leftHandSideExpression()
 {
     return this->variable();
 }
 
-AstObject Parser::variable()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::variable()
 {
     this->eat("#");
 
@@ -858,47 +991,53 @@ AstObject Parser::variable()
 
     if (type == "VAR_NAME") {
         // #<_var_name_>
-        return AstObject{
-            {"type", "nameIndexVariable"},
-            {"index", this->nameIndex()}
-        };
+        return _make_ast_object(
+            "type", "nameIndexVariable",
+            "index", this->nameIndex()
+        );
     } else {
-        return AstObject{
-            {"type", "numberIndexVariable"},
-            {"index", this->numberIndex()}
-        };
+        return _make_ast_object(
+            "type", "numberIndexVariable",
+            "index", this->numberIndex()
+        );
     }
 }
 
-std::string Parser::nameIndex()
+template <typename Dialect>
+std::string BasicParser<Dialect>::nameIndex()
 {
     auto&& var_with_angle_brackets = this->eat("VAR_NAME");
 
     return var_with_angle_brackets.substr(1, var_with_angle_brackets.size() - 2);
 }
 
-AstValue Parser::numberIndex()
+template <typename Dialect>
+AstValue BasicParser<Dialect>::numberIndex()
 {   
-#ifdef NAMEINDEX_JUST_PRIMARYEXPRESSION
-    return this->primaryExpression();
-#else // NOT NAMEINDEX_JUST_PRIMARYEXPRESSION
-    auto&& type = Tokenizer::GetTokenType(this->_lookahead);
-
-    if (type == "INTEGER") {
-        return std::stoi(this->eat("INTEGER")); // literal won't be negative here
-    } else if (type == "DOUBLE") {
-        throw SyntaxError("Cannot have a Double Literal after #");
-    } else if (type == "[") {
-        return this->parenthesizedExpression();
-    } else if (type == "#") {
-        return this->variable();
+    if constexpr (Dialect::kNumberIndexJustPrimaryExpression) {
+        return this->primaryExpression();
     } else {
-        throw SyntaxError("Unexpected variable index type: " + type);
+        // `##1` does not pass primaryExpression
+        NestingScope nesting_scope(this);
+        auto&& type = Tokenizer::GetTokenType(this->_lookahead);
+
+        if (type == "INTEGER") {
+            // a literal node like any other index, won't be negative here
+            return this->integerNumericLiteral();
+        } else if (type == "DOUBLE") {
+            throw SyntaxError("Cannot have a Double Literal after #");
+        } else if (type == "[") {
+            return this->parenthesizedExpression();
+        } else if (type == "#") {
+            return this->variable();
+        } else {
+            throw SyntaxError("Unexpected variable index type: " + type);
+        }
     }
-#endif // NAMEINDEX_JUST_PRIMARYEXPRESSION
 }
 
-AstObject Parser::numericLiteral()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::numericLiteral()
 {
     if (Tokenizer::GetTokenType(this->_lookahead) == "INTEGER") {
         return this->integerNumericLiteral();
@@ -909,27 +1048,50 @@ AstObject Parser::numericLiteral()
     }
 }
 
-AstObject Parser::doubleNumericLiteral()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::doubleNumericLiteral()
 {
     auto&& token_value = this->eat("DOUBLE");
 
-    return AstObject{
-        {"type", "doubleNumericLiteral"},
-        {"value", std::stod(token_value)}
-    };
+    double value = 0;
+    try {
+        value = std::stod(token_value);
+    } catch (std::out_of_range&) {
+        std::stringstream ss;
+        ss << "Double literal out of range: " << token_value << "\n"
+           << this->_tokenizer->getLineColumnShowString();
+        throw SyntaxError(ss.str());
+    }
+
+    return _make_ast_object(
+        "type", "doubleNumericLiteral",
+        "value", value
+    );
 }
 
-AstObject Parser::integerNumericLiteral()
+template <typename Dialect>
+AstObject BasicParser<Dialect>::integerNumericLiteral()
 {
     auto&& token_value = this->eat("INTEGER");
 
-    return AstObject{
-        {"type", "integerNumericLiteral"},
-        {"value", std::stoi(token_value)}
-    };
+    int value = 0;
+    try {
+        value = std::stoi(token_value);
+    } catch (std::out_of_range&) {
+        std::stringstream ss;
+        ss << "Integer literal out of range: " << token_value << "\n"
+           << this->_tokenizer->getLineColumnShowString();
+        throw SyntaxError(ss.str());
+    }
+
+    return _make_ast_object(
+        "type", "integerNumericLiteral",
+        "value", value
+    );
 }
 
-TokenValue Parser::eat(const TokenType &token_type)
+template <typename Dialect>
+TokenValue BasicParser<Dialect>::eat(const TokenType &token_type)
 {
     auto&& token = this->_lookahead;
 
@@ -941,19 +1103,17 @@ TokenValue Parser::eat(const TokenType &token_type)
     }
 
     // lookahead does not have the key: type
-    auto&& token_type_opt = token.find("type");
-    if (!token_type_opt || !token_type_opt.value().is_string()) {
+    if (!token.contains("type") || !token.at("type").is_string()) {
         throw SyntaxError("Internal Error, token has no key 'type', or type is not string");
     }
 
     // lookahead does not have the key: value
-    auto&& token_value_opt = token.find("value");
-    if (!token_value_opt || !token_value_opt.value().is_string()) {
+    if (!token.contains("value") || !token.at("value").is_string()) {
         throw SyntaxError("Internal Error, token has no key 'value', or value is not string");
     }
 
     // lookahead's type != the given eating token_type
-    if (token_type_opt.value() != token_type) {
+    if (token.at("type").as_string() != token_type) {
         std::cout << rs274letter::util::BacktraceToString(100) << std::endl;
         std::stringstream ss;
         ss << "Unexpected token:\n"
@@ -964,27 +1124,32 @@ TokenValue Parser::eat(const TokenType &token_type)
         throw SyntaxError(ss.str());
     }
 
+    // take the token's value (which is a std::string) out, before the lookahead is replaced
+    TokenValue token_value = std::move(this->_lookahead["value"].as_string()); // Note: use as_string, not to_string
+
     // lookahead the next token
+    util::TraceScope trace_scope("tokenize", util::Trace::TOKEN);
     this->_lookahead = _tokenizer->getNextToken();
 
-    // return the token's value (which is a std::string)
-    return token_value_opt.value().as_string(); // Note: use as_string, not to_string
+    return token_value;
 }
 
-bool Parser::IsAssignmentOperator(const Token &token)
+template <typename Dialect>
+bool BasicParser<Dialect>::IsAssignmentOperator(const Token &token)
 {
     return Tokenizer::GetTokenType(token) == "ASSIGN_OPERATOR";
 }
 
 
-const AstValue& Parser::IsValidAssignmentTarget(const AstValue &ast_value)
+template <typename Dialect>
+const AstObject& BasicParser<Dialect>::IsValidAssignmentTarget(const AstObject &ast_object)
 {
-    auto&& type = ast_value.at("type").as_string();
+    auto&& type = ast_object.at("type").as_string();
     if (type == "numberIndexVariable" || type == "nameIndexVariable") {
-        return ast_value;
+        return ast_object;
     } else {
         std::stringstream ss;
-        ss << "Invalid assignment target on the lhs, target: " << ast_value.to_string();
+        ss << "Invalid assignment target on the lhs, target: " << ast_object.to_string();
         throw SyntaxError(ss.str());
     }
 }
@@ -1016,4 +1181,7 @@ const AstValue& Parser::IsValidAssignmentTarget(const AstValue &ast_value)
 //     return true;
 // }
 
+template class BasicParser<StrictDialect>;
+template class BasicParser<LenientDialect>;
+
 } // namespace rs274letter
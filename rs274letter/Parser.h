@@ -7,7 +7,9 @@
 #include "json.hpp"
 
 #include "Tokenizer.h"
+#include "Dialect.h"
 #include "Exception.h"
+#include "Stats.h"
 
 namespace rs274letter
 {
@@ -30,9 +32,24 @@ using AstValue = json::value;
 using AstObject = json::object;
 using AstArray = json::array;
 
-class Parser {
+/**
+ * BasicParser
+ * The grammar rules of the `Dialect` are checked at compile time, see `Dialect`.
+ * Instantiated for StrictDialect and LenientDialect, `Parser` is the StrictDialect one.
+*/
+template <typename Dialect>
+class BasicParser {
 public:
-    ~Parser() noexcept = default;
+    /**
+     * kMaxNestingDepth
+     * The deepest nesting of the brackets, the signs, the `#` and the o-blocks
+     * the recursive descent goes into, a deeper program throws a SyntaxError
+     * instead of exhausting the stack. An o-block counts once, the chained
+     * `elseif` of an o-if are not nested.
+    */
+    static constexpr std::size_t kMaxNestingDepth = 128;
+
+    ~BasicParser() noexcept = default;
 
     /**
      * parse()
@@ -41,8 +58,15 @@ public:
     */
     static AstObject parse(const std::string& string);
 
+    /**
+     * parse()
+     * parse like above, and set the `stats` of this parse. The stats of each
+     * successful parse are also added to the GlobalStats.
+    */
+    static AstObject parse(const std::string& string, ParserStats& stats);
+
 private:
-    Parser(const std::string::const_iterator& cbegin, const std::string::const_iterator& cend);
+    BasicParser(const std::string::const_iterator& cbegin, const std::string::const_iterator& cend);
 
     AstObject parse();
 
@@ -55,6 +79,7 @@ private:
     /**
      * A statementList is an array of statement:
      *  : statementList statement -> statement ... statement statement
+     * Each statement in the list gets a "line": the source line it starts at
     */
     AstArray statementList(const std::optional<std::vector<TokenType>>& stop_lookahead_tokentypes_after_o = std::nullopt);
     
@@ -103,16 +128,18 @@ private:
      *  | oWhileStatement
      *  | oRepeatStatement
      *  ;
-     * if given pre_o_word, it will not eat an oCommand inside the function
+     * if given pre_o_word, it will not eat an oCommand inside the function.
+     * The o-word is moved along into the statement, the o-statement functions
+     * below take it by value, pass it with std::move()
     */
-    AstObject oCommandStatement(const std::optional<AstObject> pre_o_word = std::nullopt);
+    AstObject oCommandStatement(std::optional<AstObject> pre_o_word = std::nullopt);
 
     /**
      * an oCallStatement is:
      *  : (pre-oCommand) call oCallParamList "RTN"
      *  ;
     */
-    AstObject oCallStatement(const AstObject& o_command_start);
+    AstObject oCallStatement(AstObject o_command_start);
 
     /**
      * an oReturnStatement is:
@@ -120,7 +147,7 @@ private:
      *  ;
      * Should only appear in a subStatement block
     */
-    AstObject oReturnStatement(const AstObject& o_command_start);
+    AstObject oReturnStatement(AstObject o_command_start);
 
     /**
      * an oCallParamList is:
@@ -135,8 +162,7 @@ private:
      *  | (pre-oCommand) if parenthesizedExpression "RTN" opt-statementList oCommand endif "RTN"
      *  ;
      */
-    AstObject oIfStatement(const AstObject& o_command_start,
-        bool should_eat_if = true);
+    AstObject oIfStatement(AstObject o_command_start);
 
     /**
      * an oSubStatement is:
@@ -144,36 +170,36 @@ private:
      *  ;
      * Do not allow nested oSubStatement
     */
-    AstObject oSubStatement(const AstObject& o_command_start);
+    AstObject oSubStatement(AstObject o_command_start);
 
     /**
      * an oWhileStatement is:
      *  : (pre-oCommand) while parenthesizedExpression "RTN" opt-statementList endwhile "RTN"
     */
-    AstObject oWhileStatement(const AstObject& o_command_start);
+    AstObject oWhileStatement(AstObject o_command_start);
 
     /**
      * an oContinueStatement is:
      *  : (pre-oCommand) continue "RTN"
      *  ;
-     * Should only appears in a while loop
+     * Should only appears in a while or repeat loop
     */
-    AstObject oContinueStatement(const AstObject& o_command_start);
+    AstObject oContinueStatement(AstObject o_command_start);
 
     /**
      * an oBreakStatement is:
      *  : (pre-oCommand) break "RTN"
      *  ;
-     * Should only appears in a while loop
+     * Should only appears in a while or repeat loop
     */
-    AstObject oBreakStatement(const AstObject& o_command_start);
+    AstObject oBreakStatement(AstObject o_command_start);
 
     /**
      * an oRepeatStatement is:
-     *  : (pre-oCommand) repeat parenthesizedExpression "RTN"
+     *  : (pre-oCommand) repeat parenthesizedExpression "RTN" opt-statementList endrepeat "RTN"
      *  ;
      */
-    AstObject oRepeatStatement(const AstObject& o_command_start);
+    AstObject oRepeatStatement(AstObject o_command_start);
 
     /**
      * A commandNumberGroupList is an array of commandNumberGroup:
@@ -298,6 +324,7 @@ private:
     /**
      * an insideFunctionExpression may be:
      *  : IDENTIFIER(=ATAN) parenthesizedExpression "/" parenthesizedExpression
+     *  | IDENTIFIER(native function) parenthesizedExpression ... (arity times)
      *  | IDENTIFIER(others) parenthesizedExpression
      *  ;
     */
@@ -363,7 +390,7 @@ private:
 private:
     // helper internal static functions
     static bool IsAssignmentOperator(const Token& token);
-    static const AstValue& IsValidAssignmentTarget(const AstValue& ast_value);
+    static const AstObject& IsValidAssignmentTarget(const AstObject& ast_object);
 
     /**
      * isNextLineOEndif()
@@ -383,13 +410,27 @@ private:
     // Note: any reference bound to this `_last_o_word` needs to pay attention
     // that `_last_o_word` may change during the call of this->statementList()
     // the reference bound to it may potentially change !
+    // It is moved out by the statement which consumes it.
     AstObject _last_o_word;
 
     // used to examine if `o... return` is used in an `o... sub`
     bool _parsing_o_sub = false;
 
-    // used to examine if `o... continue/break` is used in an `o... while`
-    int _parsing_o_while_layers = 0; // layer stands for the loop nested layers, 0 is no loop
+    // used to examine if `o... continue/break` is used in an `o... while` or `o... repeat`
+    int _parsing_o_loop_layers = 0; // layer stands for the loop nested layers, 0 is no loop
+
+    // the statements added to all the statement lists, for the ParserStats
+    std::uint64_t _statement_count = 0;
+
+    // counted by a NestingScope in each recursive rule, see kMaxNestingDepth
+    class NestingScope;
+    std::size_t _nesting_depth = 0;
 };
 
+extern template class BasicParser<StrictDialect>;
+extern template class BasicParser<LenientDialect>;
+
+using Parser = BasicParser<StrictDialect>;
+using LenientParser = BasicParser<LenientDialect>;
+
 } // namespace rs274letter
@@ -0,0 +1,30 @@
+// Program.cc
+#include "Program.h"
+
+#include "util.h"
+
+namespace rs274letter
+{
+
+Program::ptr Program::compile(AstObject parse_result)
+{
+    util::TraceScope trace_scope("compile");
+
+    // the LinkResult refers into the AST, so it is linked at its final place
+    std::shared_ptr<Program> program(new Program());
+    program->_ast = std::move(parse_result);
+
+    program->_native_function_list = GetNativeFunctionList();
+    {
+        util::TraceScope validate_trace_scope("validate");
+        AstValidator::validate(program->_ast, program->_native_function_list);
+    }
+    {
+        util::TraceScope link_trace_scope("link");
+        program->_link_result = Linker::link(program->_ast);
+    }
+
+    return program;
+}
+
+} // namespace rs274letter
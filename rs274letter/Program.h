@@ -0,0 +1,65 @@
+// Program.h
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "json.hpp"
+
+#include "Parser.h"
+#include "Linker.h"
+#include "AstValidator.h"
+#include "InsideFunction.h"
+
+namespace rs274letter
+{
+
+/**
+ * Program
+ * A parsed, validated and linked program, which never changes after
+ * `Program::compile()`. It is shared by `std::shared_ptr<const Program>`,
+ * so many Serializers execute one AST, each with its own variables,
+ * frame stack and commands.
+ * Thread-safety:
+ *  - All the members are const after compile(), the Serializers on different
+ *    threads may execute the same Program concurrently without any lock.
+ *  - The native functions are bound at compile(), their callbacks are called
+ *    from all these threads, so they should be thread-safe themselves.
+ *  - One Serializer should still be used by one thread at a time.
+*/
+class Program {
+public:
+    using ptr = std::shared_ptr<const Program>;
+    ~Program() noexcept = default;
+
+    /**
+     * compile()
+     * validate and link the parse_result, see `AstValidator` and `Linker`,
+     * and bind the registered native functions
+     * @throw AstValidateError, LinkError
+    */
+    static ptr compile(AstObject parse_result);
+
+    inline const AstObject& getAst() const { return this->_ast; }
+    inline const LinkResult& getLinkResult() const { return this->_link_result; }
+
+    // indexed by `function_id - INSIDE_FUNCTION_COUNT`
+    inline const std::vector<std::shared_ptr<const NativeFunction>>& getNativeFunctionList() const {
+        return this->_native_function_list;
+    }
+
+private:
+    Program() = default;
+    Program(const Program&) = delete;
+    Program& operator=(const Program&) = delete;
+
+private:
+    AstObject _ast;
+
+    // refers to the nodes of the _ast
+    LinkResult _link_result;
+
+    std::vector<std::shared_ptr<const NativeFunction>> _native_function_list;
+};
+
+} // namespace rs274letter
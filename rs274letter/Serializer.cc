@@ -1,23 +1,20 @@
 #include "Serializer.h"
+#include "InsideFunction.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 
 // #define VARIABLE_DEBUG_OUPUT
 
 namespace rs274letter
 {
 
-static double _rad2deg(double reg) {
-    static const double cvt = 180 / M_PI;
-    return reg * cvt;
-}
-
-static double _deg2rad(double reg) {
-    static const double cvt = M_PI / 180;
-    return reg * cvt;
-}
+// The AST shape is checked once by the AstValidator in link(), so the node
+// assertions are only compiled in the checked execution
+#ifdef RS274LETTER_CHECKED_EXECUTION
 
 #define RS274LETTER_ASSERT_TYPE(v, type) \
     RS274LETTER_ASSERT(v.at("type").as_string() == type)
@@ -25,7 +22,128 @@ static double _deg2rad(double reg) {
 #define RS274LETTER_ASSERT_TYPE2(v, type1, type2) \
     RS274LETTER_ASSERT(v.at("type").as_string() == type1 || v.at("type").as_string() == type2)
 
-void Serializer::initInternalVariables()
+#define RS274LETTER_ASSERT_AST(x) RS274LETTER_ASSERT(x)
+
+#else // NOT RS274LETTER_CHECKED_EXECUTION
+
+#define RS274LETTER_ASSERT_TYPE(v, type) ((void)(v))
+#define RS274LETTER_ASSERT_TYPE2(v, type1, type2) ((void)(v))
+#define RS274LETTER_ASSERT_AST(x) ((void)0)
+
+#endif // RS274LETTER_CHECKED_EXECUTION
+
+// replace the container with an empty one on the same memory resource
+template <typename Container>
+static void _release_container(Container& container)
+{
+    Container(container.get_allocator()).swap(container);
+}
+
+template <typename Dialect>
+void BasicSerializer<Dialect>::releaseMemory()
+{
+    _release_container(this->_numberindex_variable_value_map);
+    _release_container(this->_nameindex_variable_value_map);
+    _release_container(this->_sub_numberindex_variable_value_map);
+    _release_container(this->_sub_nameindex_variable_value_map);
+    _release_container(this->_global_nameindex_variable_value_map);
+    _release_container(this->_numberindex_oword_set);
+    _release_container(this->_nameindex_oword_set);
+    _release_container(this->_numberindex_o_substatement_map);
+    _release_container(this->_nameindex_o_substatement_map);
+    _release_container(this->_initial_numberindex_variable_list);
+    _release_container(this->_initial_nameindex_variable_list);
+    _release_container(this->_frame_stack);
+    _release_container(this->_call_param_value_list);
+    _release_container(this->_checkpoint_list);
+
+    // the containers on it are empty now
+    this->_frame_resource.release();
+}
+
+// a hash container with the heap of its string keys
+template <typename HashContainer>
+static std::size_t _name_container_bytes(const HashContainer& container)
+{
+    auto bytes = MemoryFootprint::HashContainerBytes(container);
+    for (auto&& value : container) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(value)>, std::string>) {
+            bytes += MemoryFootprint::StringBytes(value);
+        } else {
+            bytes += MemoryFootprint::StringBytes(value.first);
+        }
+    }
+    return bytes;
+}
+
+// a frame stack with the caller variables saved in its frames
+template <typename FrameStack>
+static std::size_t _frame_stack_bytes(const FrameStack& frame_stack)
+{
+    auto bytes = MemoryFootprint::VectorBytes(frame_stack);
+    for (auto&& frame : frame_stack) {
+        bytes += MemoryFootprint::HashContainerBytes(frame.caller_sub_numberindex_variable_value_map);
+        bytes += _name_container_bytes(frame.caller_sub_nameindex_variable_value_map);
+    }
+    return bytes;
+}
+
+template <typename Dialect>
+MemoryFootprint BasicSerializer<Dialect>::getMemoryFootprint() const
+{
+    MemoryFootprint footprint;
+
+    if (this->_program) {
+        footprint.ast = AstFootprint::Measure(this->_program->getAst());
+        auto&& link_result = this->_program->getLinkResult();
+        footprint.program_bytes = sizeof(Program) + footprint.ast.bytes
+            + MemoryFootprint::VectorBytes(link_result.sub_list)
+            + MemoryFootprint::VectorBytes(link_result.statement_line_list)
+            + MemoryFootprint::VectorBytes(link_result.statement_sub_index_list)
+            + MemoryFootprint::VectorBytes(this->_program->getNativeFunctionList());
+    } else {
+        footprint.ast = AstFootprint::Measure(this->_parse_result);
+        footprint.program_bytes = footprint.ast.bytes;
+    }
+
+    footprint.variable_bytes = MemoryFootprint::HashContainerBytes(this->_numberindex_variable_value_map)
+        + _name_container_bytes(this->_nameindex_variable_value_map)
+        + MemoryFootprint::HashContainerBytes(this->_sub_numberindex_variable_value_map)
+        + _name_container_bytes(this->_sub_nameindex_variable_value_map)
+        + _name_container_bytes(this->_global_nameindex_variable_value_map)
+        + MemoryFootprint::VectorBytes(this->_initial_numberindex_variable_list)
+        + MemoryFootprint::VectorBytes(this->_initial_nameindex_variable_list)
+        + MemoryFootprint::VectorBytes(this->_call_param_value_list);
+    for (auto&& [index, value] : this->_initial_nameindex_variable_list) {
+        footprint.variable_bytes += MemoryFootprint::StringBytes(index);
+    }
+
+    footprint.sub_bytes = MemoryFootprint::HashContainerBytes(this->_numberindex_oword_set)
+        + _name_container_bytes(this->_nameindex_oword_set)
+        + MemoryFootprint::HashContainerBytes(this->_numberindex_o_substatement_map)
+        + _name_container_bytes(this->_nameindex_o_substatement_map);
+
+    footprint.frame_stack_bytes = _frame_stack_bytes(this->_frame_stack);
+
+    footprint.checkpoint_bytes = MemoryFootprint::VectorBytes(this->_checkpoint_list);
+    for (auto&& checkpoint : this->_checkpoint_list) {
+        footprint.checkpoint_bytes += MemoryFootprint::HashContainerBytes(checkpoint.numberindex_variable_value_map)
+            + _name_container_bytes(checkpoint.nameindex_variable_value_map)
+            + MemoryFootprint::HashContainerBytes(checkpoint.sub_numberindex_variable_value_map)
+            + _name_container_bytes(checkpoint.sub_nameindex_variable_value_map)
+            + _name_container_bytes(checkpoint.global_nameindex_variable_value_map)
+            + MemoryFootprint::HashContainerBytes(checkpoint.numberindex_o_substatement_map)
+            + _name_container_bytes(checkpoint.nameindex_o_substatement_map)
+            + _frame_stack_bytes(checkpoint.frame_stack);
+    }
+
+    footprint.command_output_bytes = MemoryFootprint::ListBytes(this->_command_list_sink->getCommandList());
+
+    return footprint;
+}
+
+template <typename Dialect>
+void BasicSerializer<Dialect>::initInternalVariables()
 {
     // subroutine return state initialize
     // these are cleared to 0 just before the next subroutine call
@@ -35,12 +153,248 @@ void Serializer::initInternalVariables()
     this->storeVariable("_test_global", 1001, true);
 }
 
-void Serializer::processProgram()
+template <typename Dialect>
+void BasicSerializer<Dialect>::link()
+{
+    if (this->_program) return;
+
+    this->_program = Program::compile(std::move(this->_parse_result));
+}
+
+template <typename Dialect>
+void BasicSerializer<Dialect>::processProgram()
+{
+    while (this->step(std::numeric_limits<std::size_t>::max())) {}
+}
+
+template <typename Dialect>
+bool BasicSerializer<Dialect>::step(std::size_t max_commands)
+{
+    util::TraceScope trace_scope("execute");
+
+    auto step_begin = std::chrono::steady_clock::now();
+    if (!this->_is_started) {
+        this->startExecutionUsage();
+        this->startProgram();
+    } else if (this->_frame_stack.empty()) {
+        // already finished
+        this->publishStats();
+        return false;
+    }
+
+    // the duration budget is counted for the whole run, the time between the calls is not
+    this->_execution_usage.deadline = step_begin + this->_execution_budget.max_duration 
+        - this->_execution_usage.elapsed;
+
+    this->_step_command_count = 0;
+    while (!this->_frame_stack.empty()) {
+        if (this->_step_command_count >= max_commands) {
+            this->_execution_usage.elapsed += std::chrono::steady_clock::now() - step_begin;
+            this->publishStats();
+            return true;
+        }
+
+        this->processTopFrame();
+    }
+
+    ++this->_stats.programs;
+    this->publishStats();
+
+    util::TraceScope flush_trace_scope("flush", util::Trace::SINK);
+    this->_command_sink->flush();
+    return false;
+}
+
+template <typename Dialect>
+void BasicSerializer<Dialect>::publishStats()
+{
+    auto&& stats = this->_stats;
+    auto&& published_stats = this->_published_stats;
+
+    SerializerStats delta;
+    delta.programs = stats.programs - published_stats.programs;
+    delta.statements = stats.statements - published_stats.statements;
+    delta.expressions = stats.expressions - published_stats.expressions;
+    delta.variable_reads = stats.variable_reads - published_stats.variable_reads;
+    delta.variable_writes = stats.variable_writes - published_stats.variable_writes;
+    delta.o_calls = stats.o_calls - published_stats.o_calls;
+    delta.loop_iterations = stats.loop_iterations - published_stats.loop_iterations;
+    delta.commands = stats.commands - published_stats.commands;
+    GlobalStats::Add(delta);
+
+    this->_published_stats = stats;
+}
+
+template <typename Dialect>
+void BasicSerializer<Dialect>::restartFromCommand(std::size_t command_index)
+{
+    auto restart_begin = std::chrono::steady_clock::now();
+
+    // the nearest checkpoint at or before the command_index
+    auto it = std::upper_bound(this->_checkpoint_list.begin(), this->_checkpoint_list.end(), 
+        command_index, [](std::size_t index, const Checkpoint& checkpoint) {
+            return index < checkpoint.command_count;
+        });
+
+    this->startExecutionUsage();
+    if (it == this->_checkpoint_list.begin()) {
+        this->startProgram();
+    } else {
+        this->restoreCheckpoint(*std::prev(it));
+    }
+
+    // execute to the command_index, the commands are dropped
+    this->_is_fast_forwarding = true;
+    while (this->_command_count < command_index) {
+        if (this->_frame_stack.empty()) {
+            std::stringstream ss;
+            ss << "Restart command index out of range: " << command_index
+               << ", the program produces " << this->_command_count << " commands";
+            throw SerializerError(ss.str());
+        }
+
+        this->processTopFrame();
+    }
+    this->_is_fast_forwarding = false;
+    this->_execution_usage.elapsed = std::chrono::steady_clock::now() - restart_begin;
+}
+
+template <typename Dialect>
+void BasicSerializer<Dialect>::startProgram()
+{
+    this->link();
+
+    // drop the execution state of a previous run
+    this->_numberindex_variable_value_map.clear();
+    this->_nameindex_variable_value_map.clear();
+    this->_sub_numberindex_variable_value_map.clear();
+    this->_sub_nameindex_variable_value_map.clear();
+    this->_global_nameindex_variable_value_map.clear();
+    this->_numberindex_o_substatement_map.clear();
+    this->_nameindex_o_substatement_map.clear();
+    this->_is_in_sub = false;
+    this->_frame_stack.clear();
+    this->_command_count = 0;
+
+    this->initInternalVariables();
+
+    for (const auto& [index, value] : this->_initial_numberindex_variable_list) {
+        this->storeVariable(index, value);
+    }
+    for (const auto& [index, value] : this->_initial_nameindex_variable_list) {
+        this->storeVariable(index, value);
+    }
+
+    this->pushStatementListFrame(this->_program->getAst().at("body").as_array());
+    this->_is_started = true;
+
+    if (this->_checkpoint_interval != 0) {
+        this->recordCheckpoint();
+    }
+}
+
+template <typename Dialect>
+void BasicSerializer<Dialect>::recordCheckpoint()
+{
+    if (!this->_checkpoint_list.empty() 
+        && this->_checkpoint_list.back().command_count >= this->_command_count) {
+        // recorded by a previous run
+        return;
+    }
+
+    Checkpoint checkpoint(this->_checkpoint_list.get_allocator());
+    checkpoint.command_count = this->_command_count;
+    checkpoint.numberindex_variable_value_map = this->_numberindex_variable_value_map;
+    checkpoint.nameindex_variable_value_map = this->_nameindex_variable_value_map;
+    checkpoint.sub_numberindex_variable_value_map = this->_sub_numberindex_variable_value_map;
+    checkpoint.sub_nameindex_variable_value_map = this->_sub_nameindex_variable_value_map;
+    checkpoint.global_nameindex_variable_value_map = this->_global_nameindex_variable_value_map;
+    checkpoint.numberindex_o_substatement_map = this->_numberindex_o_substatement_map;
+    checkpoint.nameindex_o_substatement_map = this->_nameindex_o_substatement_map;
+    checkpoint.is_in_sub = this->_is_in_sub;
+    checkpoint.frame_stack = this->_frame_stack;
+
+    this->_checkpoint_list.emplace_back(std::move(checkpoint));
+}
+
+template <typename Dialect>
+void BasicSerializer<Dialect>::restoreCheckpoint(const Checkpoint &checkpoint)
+{
+    this->link();
+
+    this->_command_count = checkpoint.command_count;
+    this->_numberindex_variable_value_map = checkpoint.numberindex_variable_value_map;
+    this->_nameindex_variable_value_map = checkpoint.nameindex_variable_value_map;
+    this->_sub_numberindex_variable_value_map = checkpoint.sub_numberindex_variable_value_map;
+    this->_sub_nameindex_variable_value_map = checkpoint.sub_nameindex_variable_value_map;
+    this->_global_nameindex_variable_value_map = checkpoint.global_nameindex_variable_value_map;
+    this->_numberindex_o_substatement_map = checkpoint.numberindex_o_substatement_map;
+    this->_nameindex_o_substatement_map = checkpoint.nameindex_o_substatement_map;
+    this->_is_in_sub = checkpoint.is_in_sub;
+    this->_frame_stack = checkpoint.frame_stack;
+
+    this->_execution_usage.call_depth = std::count_if(this->_frame_stack.begin(), this->_frame_stack.end(), 
+        [](const ExecutionFrame& frame) { return frame.type == FrameType::FRAME_TYPE_O_CALL; });
+
+    this->_is_started = true;
+}
+
+template <typename Dialect>
+void BasicSerializer<Dialect>::startExecutionUsage()
+{
+    this->_execution_usage = ExecutionUsage{};
+    this->_execution_usage.deadline = std::chrono::steady_clock::now() 
+        + this->_execution_budget.max_duration;
+}
+
+template <typename Dialect>
+void BasicSerializer<Dialect>::checkExecutionBudget(const AstObject &o_word)
+{
+    auto&& budget = this->_execution_budget;
+    auto&& usage = this->_execution_usage;
+
+    if (budget.max_statements != 0 && usage.statements > budget.max_statements) {
+        this->throwExecutionBudgetExhausted("statements", budget.max_statements, o_word);
+    }
+
+    if (budget.max_commands != 0 && usage.commands > budget.max_commands) {
+        this->throwExecutionBudgetExhausted("commands", budget.max_commands, o_word);
+    }
+
+    if (budget.max_call_depth != 0 && usage.call_depth > budget.max_call_depth) {
+        this->throwExecutionBudgetExhausted("call depth", budget.max_call_depth, o_word);
+    }
+
+    if (budget.max_loop_iterations != 0 && usage.loop_iterations > budget.max_loop_iterations) {
+        this->throwExecutionBudgetExhausted("loop iterations", budget.max_loop_iterations, o_word);
+    }
+
+    // reading the clock is much more expensive than the counters
+    if (budget.max_duration.count() != 0
+        && ++usage.check_count % ExecutionBudget::kClockCheckInterval == 0
+        && std::chrono::steady_clock::now() > usage.deadline) {
+        this->throwExecutionBudgetExhausted("duration(ms)", budget.max_duration.count(), o_word);
+    }
+}
+
+template <typename Dialect>
+void BasicSerializer<Dialect>::throwExecutionBudgetExhausted(const char *budget_name, 
+    std::size_t limit, const AstObject &o_word) const
 {
-    this->processStatementList(this->_parse_result.at("body").as_array());
+    auto&& usage = this->_execution_usage;
+
+    std::stringstream ss;
+    ss << "Execution budget exhausted: " << budget_name << ", limit: " << limit
+       << "\nat: " << Linker::GetOWordShowString(o_word)
+       << ", statements: " << usage.statements
+       << ", commands: " << usage.commands
+       << ", call depth: " << usage.call_depth
+       << ", loop iterations: " << usage.loop_iterations;
+    throw SerializerError(ss.str());
 }
 
-void Serializer::deleteVariable(const std::string &index)
+template <typename Dialect>
+void BasicSerializer<Dialect>::deleteVariable(const std::string &index)
 {
 #ifdef VARIABLE_DEBUG_OUPUT
     const char* env = this->_isInSubEnvironment() ? "[Sub]" : "[Normal]";
@@ -55,23 +409,20 @@ void Serializer::deleteVariable(const std::string &index)
     }
 #endif
 
-#ifdef THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE
-    std::stringstream ss;
-#endif
-
     // examine whether the index stands for a global index
     if (_is_global_variable_name_index(index)) {
         // global index
         auto it = this->_global_nameindex_variable_value_map.find(index);
 
         if (it == this->_global_nameindex_variable_value_map.end()) {
-#ifdef THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE
-            ss << "Internal Error: delete an undefined name-variable in global:"
-               << index;
-            throw SerializerError(ss.str());
-#else // NOT THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE
-            return;
-#endif // THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE
+            if constexpr (Dialect::kThrowIfInternalDeleteUndefinedVariable) {
+                std::stringstream ss;
+                ss << "Internal Error: delete an undefined name-variable in global:"
+                   << index;
+                throw SerializerError(ss.str());
+            } else {
+                return;
+            }
         } else {
             this->_global_nameindex_variable_value_map.erase(it);
         }
@@ -83,13 +434,14 @@ void Serializer::deleteVariable(const std::string &index)
         auto it = this->_sub_nameindex_variable_value_map.find(index);
 
         if (it == this->_sub_nameindex_variable_value_map.end()) {
-#ifdef THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE
-            ss << "Internal Error: delete an undefined name-variable in sub:"
-               << index;
-            throw SerializerError(ss.str());
-#else // NOT THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE
-            return;
-#endif // THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE
+            if constexpr (Dialect::kThrowIfInternalDeleteUndefinedVariable) {
+                std::stringstream ss;
+                ss << "Internal Error: delete an undefined name-variable in sub:"
+                   << index;
+                throw SerializerError(ss.str());
+            } else {
+                return;
+            }
         } else {
             this->_sub_nameindex_variable_value_map.erase(it);
         }
@@ -98,20 +450,22 @@ void Serializer::deleteVariable(const std::string &index)
         auto it = this->_nameindex_variable_value_map.find(index);
 
         if (it == this->_nameindex_variable_value_map.end()) {
-#ifdef THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE
-            ss << "Internal Error: delete an undefined name-variable in normal:"
-               << index;
-            throw SerializerError(ss.str());
-#else // NOT THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE
-            return;
-#endif // THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE
+            if constexpr (Dialect::kThrowIfInternalDeleteUndefinedVariable) {
+                std::stringstream ss;
+                ss << "Internal Error: delete an undefined name-variable in normal:"
+                   << index;
+                throw SerializerError(ss.str());
+            } else {
+                return;
+            }
         } else {
             this->_nameindex_variable_value_map.erase(it);
         }
     }
 }
 
-void Serializer::deleteVariable(int index)
+template <typename Dialect>
+void BasicSerializer<Dialect>::deleteVariable(int index)
 {
 #ifdef VARIABLE_DEBUG_OUPUT
     const char* env = this->_isInSubEnvironment() ? "[Sub]" : "[Normal]";
@@ -126,22 +480,19 @@ void Serializer::deleteVariable(int index)
     }
 #endif
 
-#ifdef THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE
-    std::stringstream ss;
-#endif
-
     if (this->_isInSubEnvironment()) {
         // In a sub-environment
         auto it = this->_sub_numberindex_variable_value_map.find(index);
 
         if (it == this->_sub_numberindex_variable_value_map.end()) {
-#ifdef THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE
-            ss << "Internal Error: delete an undefined number-variable in sub:"
-               << index;
-            throw SerializerError(ss.str());
-#else // NOT THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE
-            return;
-#endif // THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE
+            if constexpr (Dialect::kThrowIfInternalDeleteUndefinedVariable) {
+                std::stringstream ss;
+                ss << "Internal Error: delete an undefined number-variable in sub:"
+                   << index;
+                throw SerializerError(ss.str());
+            } else {
+                return;
+            }
         } else {
             this->_sub_numberindex_variable_value_map.erase(it);
         }
@@ -150,30 +501,34 @@ void Serializer::deleteVariable(int index)
         auto it = this->_numberindex_variable_value_map.find(index);
 
         if (it == this->_numberindex_variable_value_map.end()) {
-#ifdef THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE
-            ss << "Internal Error: delete an undefined number-variable in normal:"
-               << index;
-            throw SerializerError(ss.str());
-#else // NOT THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE
-            return;
-#endif // THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE
+            if constexpr (Dialect::kThrowIfInternalDeleteUndefinedVariable) {
+                std::stringstream ss;
+                ss << "Internal Error: delete an undefined number-variable in normal:"
+                   << index;
+                throw SerializerError(ss.str());
+            } else {
+                return;
+            }
         } else {
             this->_numberindex_variable_value_map.erase(it);
         }
     }
 }
 
-void Serializer::clearVariable(const std::string &index, bool assign_internal/*=false*/)
+template <typename Dialect>
+void BasicSerializer<Dialect>::clearVariable(const std::string &index, bool assign_internal/*=false*/)
 {
     this->storeVariable(index, 0, assign_internal);
 }
 
-void Serializer::clearVariable(int index)
+template <typename Dialect>
+void BasicSerializer<Dialect>::clearVariable(int index)
 {
     this->storeVariable(index, 0);
 }
 
-void Serializer::storeVariable(const std::string &index, double value, bool assign_internal /* = false*/)
+template <typename Dialect>
+void BasicSerializer<Dialect>::storeVariable(const std::string &index, double value, bool assign_internal /* = false*/)
 {
 #ifdef VARIABLE_DEBUG_OUPUT
     const char* env = this->_isInSubEnvironment() ? "[Sub]" : "[Normal]";
@@ -222,7 +577,8 @@ void Serializer::storeVariable(const std::string &index, double value, bool assi
     }
 }
 
-void Serializer::storeVariable(int index, double value)
+template <typename Dialect>
+void BasicSerializer<Dialect>::storeVariable(int index, double value)
 {
 #ifdef VARIABLE_DEBUG_OUPUT
     const char* env = this->_isInSubEnvironment() ? "[Sub]" : "[Normal]";
@@ -246,7 +602,8 @@ void Serializer::storeVariable(int index, double value)
     }
 }
 
-std::optional<double> Serializer::existsAndGetVariable(int index) const
+template <typename Dialect>
+std::optional<double> BasicSerializer<Dialect>::existsAndGetVariable(int index) const
 {
     if (this->_isInSubEnvironment()) {
         auto it = this->_sub_numberindex_variable_value_map.find(index);
@@ -265,7 +622,8 @@ std::optional<double> Serializer::existsAndGetVariable(int index) const
     }
 }
 
-std::optional<double> Serializer::existsAndGetVariable(const std::string &index) const
+template <typename Dialect>
+std::optional<double> BasicSerializer<Dialect>::existsAndGetVariable(const std::string &index) const
 {
     if (_is_global_variable_name_index(index)) {
         auto it = this->_global_nameindex_variable_value_map.find(index);
@@ -293,7 +651,8 @@ std::optional<double> Serializer::existsAndGetVariable(const std::string &index)
     }
 }
 
-bool Serializer::isInternalNameIndex(const std::string &index) const
+template <typename Dialect>
+bool BasicSerializer<Dialect>::isInternalNameIndex(const std::string &index) const
 {
     // whether starts with _, if not, return false
     if (!_is_global_variable_name_index(index)) {
@@ -315,106 +674,115 @@ bool Serializer::isInternalNameIndex(const std::string &index) const
 
 }
 
-void Serializer::produceFlowControl(const AstObject &flow_jump_statement)
-{   
-    RS274LETTER_ASSERT(this->_current_flow_state == FlowState::FLOW_STATE_NORMAL);
-    auto&& type = flow_jump_statement.at("type").as_string();
+template <typename Dialect>
+void BasicSerializer<Dialect>::pushStatementListFrame(const AstArray &statement_list)
+{
+    ExecutionFrame frame;
+    frame.type = FrameType::FRAME_TYPE_STATEMENT_LIST;
+    frame.statement_list = &statement_list;
+    this->_frame_stack.emplace_back(std::move(frame));
+}
 
-    if (type == "oContinueStatement") {
-        this->_current_flow_state = FlowState::FLOW_STATE_NEED_CONTINUE;
-    } else if (type == "oBreakStatement") {
-        this->_current_flow_state = FlowState::FLOW_STATE_NEED_BREAK;
-    } else if (type == "oReturnStatement") {
-        this->_current_flow_state = FlowState::FLOW_STATE_NEED_RETURN;
+template <typename Dialect>
+void BasicSerializer<Dialect>::processTopFrame()
+{
+    if (this->_profiler) {
+        this->processTopFrameProfiled();
     } else {
-        RS274LETTER_ASSERT2(false, "not a valid flow control statement");
+        this->executeTopFrame();
     }
-
-    this->_current_flow_control_statement = flow_jump_statement;
 }
 
-void Serializer::consumeFlowControl(const AstObject &this_current_statement)
+template <typename Dialect>
+void BasicSerializer<Dialect>::processTopFrameProfiled()
 {
-    if (this->_current_flow_state == FlowState::FLOW_STATE_NORMAL) {
-        RS274LETTER_ASSERT(this->_current_flow_control_statement.empty());
-        std::cout << "[DEBUG] consume flow control does nothing(normal state): " << std::endl;
-        return;
+    auto& frame = this->_frame_stack.back();
+
+    // the statement which the time of this move is counted to
+    const AstObject* statement = nullptr;
+    bool is_execution = true;
+    switch (frame.type)
+    {
+    case FrameType::FRAME_TYPE_STATEMENT_LIST:
+        if (frame.next_index < frame.statement_list->size()) {
+            statement = &(*frame.statement_list)[frame.next_index].as_object();
+        }
+        break;
+    case FrameType::FRAME_TYPE_O_WHILE:
+    case FrameType::FRAME_TYPE_O_REPEAT:
+        // each test of the loop
+        statement = frame.statement;
+        break;
+    case FrameType::FRAME_TYPE_O_CALL:
+        // the return at the end of the sub body, timed but not counted
+        statement = frame.statement;
+        is_execution = false;
+        break;
     }
 
-    RS274LETTER_ASSERT(!this->_current_flow_control_statement.empty());
-
-    auto&& cur_statement_type = this_current_statement.at("type").as_string();
-    auto&& jump_type = this->_current_flow_control_statement.at("type").as_string();
-
-    std::stringstream ss;
+    if (statement == nullptr) {
+        this->executeTopFrame();
+        return;
+    }
 
-    if (cur_statement_type == "oWhileStatement") {
-        switch (this->_current_flow_state)
-        {
-        case FlowState::FLOW_STATE_NORMAL:
-            RS274LETTER_ASSERT(false);
-        case FlowState::FLOW_STATE_NEED_RETURN:
-            return;
-        case FlowState::FLOW_STATE_NEED_CONTINUE:
-        case FlowState::FLOW_STATE_NEED_BREAK:
-            // examine layers and o-words
-            // TODO, 还要实现o-word相关的计算、比较函数
+    auto& profiler = *this->_profiler;
+    if (profiler.getProgram() != this->_program) {
+        // the first step with this profiler, also after a restart from a checkpoint
+        profiler.bind(this->_program);
+    }
 
-            this->_current_flow_control_statement.clear();
-            this->_current_flow_state = FlowState::FLOW_STATE_NORMAL;
-            return;
-        }
-    } else if (cur_statement_type == "oCallStatement") {
-        switch (this->_current_flow_state)
-        {
-        case FlowState::FLOW_STATE_NORMAL:
-            RS274LETTER_ASSERT(false);
-        case FlowState::FLOW_STATE_NEED_CONTINUE:
-        case FlowState::FLOW_STATE_NEED_BREAK:
-            return;
-        case FlowState::FLOW_STATE_NEED_RETURN:
-            // examine o-words
-            // TODO, 还要实现o-word相关的计算、比较函数
-
-            // return value
-            RS274LETTER_ASSERT(jump_type == "oReturnStatement");
-            auto&& return_expression = this->_current_flow_control_statement.at("returnRtnExpr").as_object();
-            if (return_expression.empty()) {
-                this->storeVariable("_value_returned", 0, true);
-            } else {
-                this->storeVariable("_value_returned", 1, true);
-                double return_value = this->getValue(return_expression);
-                this->storeVariable("_value", return_value, true);
-            }
+    auto statement_id = static_cast<std::size_t>(statement->at("statementId").as_integer());
+    if (is_execution) {
+        profiler.count(statement_id);
+    }
 
-            this->_current_flow_control_statement.clear();
-            this->_current_flow_state = FlowState::FLOW_STATE_NORMAL;
-            return;
-        }
+    if (profiler.shouldSample()) {
+        auto start = std::chrono::steady_clock::now();
+        this->executeTopFrame();
+        profiler.addSample(statement_id, std::chrono::steady_clock::now() - start);
     } else {
-        std::cout << "[DEBUG] consume flow control does nothing, " 
-            << "statement_type: " << cur_statement_type
-            << "\njump_type: " << jump_type << std::endl;
+        this->executeTopFrame();
     }
 }
 
-void Serializer::processStatementList(const AstArray &statement_list)
+template <typename Dialect>
+void BasicSerializer<Dialect>::executeTopFrame()
 {
-    for (const auto& statement : statement_list) {
-        this->processStatement(statement.as_object());
+    auto& frame = this->_frame_stack.back();
+
+    switch (frame.type)
+    {
+    case FrameType::FRAME_TYPE_STATEMENT_LIST:
+        if (frame.next_index >= frame.statement_list->size()) {
+            // the whole list is executed
+            this->_frame_stack.pop_back();
+        } else {
+            // Note: `frame` may be invalid after processStatement() pushes frames
+            auto&& statement = (*frame.statement_list)[frame.next_index++].as_object();
+            this->processStatement(statement);
+        }
+        return;
+    case FrameType::FRAME_TYPE_O_WHILE:
+        this->processOWhileFrame();
+        return;
+    case FrameType::FRAME_TYPE_O_REPEAT:
+        this->processORepeatFrame();
+        return;
+    case FrameType::FRAME_TYPE_O_CALL:
+        // the sub body ends without an `o... return`
+        this->exitOCallFrame(frame.substatement->at("endsubRtnExpr").as_object());
+        return;
     }
 }
 
-void Serializer::processStatement(const AstObject& statement)
+template <typename Dialect>
+void BasicSerializer<Dialect>::processStatement(const AstObject& statement)
 {
-    // if is jumping flow, just return here, do nothing
-    // since we always call this function to process statements
-    // we do the flow return examine here
-    // if the current state isn't normal, do nothing but just return
-    if (this->_current_flow_state != FlowState::FLOW_STATE_NORMAL) return;
-
     auto&& statement_type = statement.at("type").as_string();
 
+    ++this->_execution_usage.statements;
+    ++this->_stats.statements;
+
     if (statement_type == "expressionStatement") {
         this->processExpressionStatement(statement);
     } else if (statement_type == "commandStatement") {
@@ -423,6 +791,8 @@ void Serializer::processStatement(const AstObject& statement)
         this->processOIfStatement(statement);
     } else if (statement_type == "oWhileStatement") {
         this->processOWhileStatement(statement);
+    } else if (statement_type == "oRepeatStatement") {
+        this->processORepeatStatement(statement);
     } else if (statement_type == "oContinueStatement") {
         this->processOContinueStatement(statement);
     } else if (statement_type == "oBreakStatement") {
@@ -441,21 +811,28 @@ void Serializer::processStatement(const AstObject& statement)
     }
 }
 
-void Serializer::processCommandStatement(const AstObject &command_statement)
+template <typename Dialect>
+void BasicSerializer<Dialect>::processCommandStatement(const AstObject &command_statement)
 {
     RS274LETTER_ASSERT_TYPE(command_statement, "commandStatement");
     CommandStatement cs;
     
-    RS274LETTER_ASSERT(command_statement.at("commands").is_array());
+    RS274LETTER_ASSERT_AST(command_statement.at("commands").is_array());
     auto&& commands = command_statement.at("commands").as_array();
     for (const auto& command : commands) {
         RS274LETTER_ASSERT_TYPE(command, "commandNumberGroup");
         auto&& letter_str = command.at("letter").as_string();
-        RS274LETTER_ASSERT(letter_str.size() == 1);
+        RS274LETTER_ASSERT_AST(letter_str.size() == 1);
         
         auto number_value = this->getValue(command.at("number").as_object());
 
-        cs.pushBack({letter_str[0], number_value});
+        if (!cs.pushBack({letter_str[0], number_value})) {
+            std::stringstream ss;
+            ss << "Too many repeated letters in one command line, allowed: "
+               << CommandStatement::kMaxOverflowNumbers
+               << "\nletter: " << letter_str;
+            throw SerializerError(ss.str());
+        }
     }
 
     // TODO IMPORTANT
@@ -466,103 +843,188 @@ void Serializer::processCommandStatement(const AstObject &command_statement)
      *  - 可能后续不会使用CommandStatement进行命令的最终输出，因为如果完成了检查，就应该可以更明确地进行命令分组
      * */
 
-    this->_command_statement_list.emplace_back(std::move(cs));
+    if (!this->_is_fast_forwarding) {
+        this->_command_sink->consume(cs);
+        ++this->_step_command_count;
+        ++this->_stats.commands;
+    }
+
+    ++this->_command_count;
+    ++this->_execution_usage.commands;
+    if (this->_checkpoint_interval != 0 && this->_command_count % this->_checkpoint_interval == 0) {
+        // the statement is done, the state is the same as before the next one
+        this->recordCheckpoint();
+    }
 }
 
-void Serializer::processExpressionStatement(const AstObject &expression_statement)
+template <typename Dialect>
+void BasicSerializer<Dialect>::processExpressionStatement(const AstObject &expression_statement)
 {
     RS274LETTER_ASSERT_TYPE(expression_statement, "expressionStatement");
     this->getValue(expression_statement.at("expression").as_object());
 }
 
-void Serializer::processOIfStatement(const AstObject &o_if_statement)
+template <typename Dialect>
+void BasicSerializer<Dialect>::processOIfStatement(const AstObject &o_if_statement)
 {
     RS274LETTER_ASSERT_TYPE(o_if_statement, "oIfStatement");
-    
-    double test_value = this->getValue(o_if_statement.at("test").as_object());
 
-    // examine o-words
-    // TODO
+    // o-words are examined by the Linker
 
-    if (!!test_value) {
-        this->processStatementList(o_if_statement.at("consequent").as_array());
-    } else {
-        this->processStatementList(o_if_statement.at("alternate").as_array());
+    // an `elseif` is expanded as an oIfStatement in the `alternate`
+    const AstObject* if_statement = &o_if_statement;
+    while (true) {
+        double test_value = this->getValue(if_statement->at("test").as_object());
+
+        if (!!test_value) {
+            this->pushStatementListFrame(if_statement->at("consequent").as_array());
+            return;
+        }
+
+        auto&& alternate = if_statement->at("alternate");
+        if (alternate.is_object()) {
+            // elseif
+            if_statement = &alternate.as_object();
+        } else {
+            // else, may be an empty list
+            this->pushStatementListFrame(alternate.as_array());
+            return;
+        }
     }
 }
 
-void Serializer::processOWhileStatement(const AstObject &o_while_statement)
+template <typename Dialect>
+void BasicSerializer<Dialect>::processOWhileStatement(const AstObject &o_while_statement)
 {
     RS274LETTER_ASSERT_TYPE(o_while_statement, "oWhileStatement");
 
-    std::size_t loop_times = 0;
-    std::stringstream ss;
-    while (this->getValue(o_while_statement.at("test").as_object())) {
-        ++loop_times;
-        // protect infinite loop
-        if (loop_times > _s_max_loop_times) {
-            ss << "While Statement loop times too large," 
-               << "now: " << loop_times
-               << ", allowed:" << _s_max_loop_times;
-            throw SerializerError(ss.str());
-        }
-        this->processStatementList(o_while_statement.at("body").as_array());
-
-        // examine the flow state
-        if (this->_current_flow_state == FlowState::FLOW_STATE_NEED_BREAK) {
-            this->consumeFlowControl(o_while_statement);
-            break;
-        } else if (this->_current_flow_state == FlowState::FLOW_STATE_NEED_CONTINUE) {
-            this->consumeFlowControl(o_while_statement);
-            continue;
-        } else if (this->_current_flow_state == FlowState::FLOW_STATE_NEED_RETURN) {
-            return;
-        }
+    ExecutionFrame frame;
+    frame.type = FrameType::FRAME_TYPE_O_WHILE;
+    frame.statement = &o_while_statement;
+    this->_frame_stack.emplace_back(std::move(frame));
+}
+
+template <typename Dialect>
+void BasicSerializer<Dialect>::processOWhileFrame()
+{
+    auto& frame = this->_frame_stack.back();
+    RS274LETTER_ASSERT(frame.type == FrameType::FRAME_TYPE_O_WHILE);
+    auto&& o_while_statement = *frame.statement;
+
+    if (!this->getValue(o_while_statement.at("test").as_object())) {
+        // loop ends
+        this->_frame_stack.pop_back();
+        return;
+    }
+
+    // a back-edge, protect infinite loop
+    ++frame.loop_times;
+    ++this->_execution_usage.loop_iterations;
+    ++this->_stats.loop_iterations;
+
+    auto&& while_o_word = o_while_statement.at("whileOCommand").as_object();
+    auto max_single_loop_iterations = this->_execution_budget.max_single_loop_iterations;
+    if (max_single_loop_iterations != 0 && frame.loop_times > max_single_loop_iterations) {
+        this->throwExecutionBudgetExhausted("single loop iterations", max_single_loop_iterations, while_o_word);
+    }
+    this->checkExecutionBudget(while_o_word);
+
+    this->pushStatementListFrame(o_while_statement.at("body").as_array());
+}
+
+template <typename Dialect>
+void BasicSerializer<Dialect>::processORepeatStatement(const AstObject &o_repeat_statement)
+{
+    RS274LETTER_ASSERT_TYPE(o_repeat_statement, "oRepeatStatement");
+
+    double times_value = this->getValue(o_repeat_statement.at("times").as_object());
+    auto&& times_opt = _convert_to_integer(times_value);
+    if (!times_opt) {
+        std::stringstream ss;
+        ss << "Invalid o-repeat times, should be a non-negative integer:"
+           << "\ntolerance:" << this->_s_double_to_integer_tolerance
+           << "\ntimes:" << std::setprecision(10) << times_value;
+        throw SerializerError(ss.str());
     }
+
+    ExecutionFrame frame;
+    frame.type = FrameType::FRAME_TYPE_O_REPEAT;
+    frame.statement = &o_repeat_statement;
+    frame.repeat_times = times_opt.value();
+    this->_frame_stack.emplace_back(std::move(frame));
+}
+
+template <typename Dialect>
+void BasicSerializer<Dialect>::processORepeatFrame()
+{
+    auto& frame = this->_frame_stack.back();
+    RS274LETTER_ASSERT(frame.type == FrameType::FRAME_TYPE_O_REPEAT);
+    auto&& o_repeat_statement = *frame.statement;
+
+    if (frame.loop_times >= frame.repeat_times) {
+        // loop ends
+        this->_frame_stack.pop_back();
+        return;
+    }
+
+    // a back-edge
+    ++frame.loop_times;
+    ++this->_execution_usage.loop_iterations;
+    ++this->_stats.loop_iterations;
+    this->checkExecutionBudget(o_repeat_statement.at("repeatOCommand").as_object());
+
+    this->pushStatementListFrame(o_repeat_statement.at("body").as_array());
 }
 
-void Serializer::processOContinueStatement(const AstObject &o_continue_statement)
+template <typename Dialect>
+void BasicSerializer<Dialect>::processOContinueStatement(const AstObject &o_continue_statement)
 {
     RS274LETTER_ASSERT_TYPE(o_continue_statement, "oContinueStatement");
-    this->produceFlowControl(o_continue_statement);
+
+    // the loop frame on the top starts the next iteration
+    this->unwindFrameStackToLoop();
 }
 
-void Serializer::processOBreakStatement(const AstObject &o_break_statement)
+template <typename Dialect>
+void BasicSerializer<Dialect>::processOBreakStatement(const AstObject &o_break_statement)
 {
     RS274LETTER_ASSERT_TYPE(o_break_statement, "oBreakStatement");
-    this->produceFlowControl(o_break_statement);
+
+    this->unwindFrameStackToLoop();
+    this->_frame_stack.pop_back(); // the loop frame
 }
 
-void Serializer::processOSubStatement(const AstObject &o_sub_statement)
+template <typename Dialect>
+void BasicSerializer<Dialect>::processOSubStatement(const AstObject &o_sub_statement)
 {
     RS274LETTER_ASSERT_TYPE(o_sub_statement, "oSubStatement");
-    // Here just simply store the substatement for further call
-    // use the o-index which is calced now
 
-    auto&& sub_o_word = o_sub_statement.at("subOCommand").as_object();
-    auto&& sub_o_word_type = sub_o_word.at("type").as_string();
+    // already registered by the Linker
+    if (o_sub_statement.contains("linkedSubIndex")) return;
 
-    if (sub_o_word_type == "nameIndexOCommand") {
-        // nameIndexOCommand
-        this->_nameindex_o_substatement_map[sub_o_word.at("index").as_string()] = o_sub_statement;
-    } else {
-        // numberIndexOCommand
-        this->_numberindex_o_substatement_map[this->getValue(sub_o_word.at("index").as_object())] = o_sub_statement;
-    }
+    // the o-word can only be calculated now, store the substatement
+    // for further call, use the o-index which is calced now
+    auto&& sub_o_word = o_sub_statement.at("subOCommand").as_object();
+    RS274LETTER_ASSERT_TYPE(sub_o_word, "numberIndexOCommand");
 
-    // TODO
-    // examine the "endsubOCommand"
+    this->_numberindex_o_substatement_map[this->getNumberIndexOfNumberIndexOCommand(sub_o_word)] = &o_sub_statement;
 }
 
-void Serializer::processOReturnStatement(const AstObject &o_return_statement)
+template <typename Dialect>
+void BasicSerializer<Dialect>::processOReturnStatement(const AstObject &o_return_statement)
 {
     RS274LETTER_ASSERT_TYPE(o_return_statement, "oReturnStatement");
-    this->produceFlowControl(o_return_statement);
+
+    this->unwindFrameStackTo(FrameType::FRAME_TYPE_O_CALL);
+    this->exitOCallFrame(o_return_statement.at("returnRtnExpr").as_object());
 }
 
-void Serializer::processOCallStatement(const AstObject &o_call_statement)
+template <typename Dialect>
+void BasicSerializer<Dialect>::processOCallStatement(const AstObject &o_call_statement)
 {
     RS274LETTER_ASSERT_TYPE(o_call_statement, "oCallStatement");
+
+    ++this->_stats.o_calls;
     
     // clear the #<_value> and #<_value_returned>
     this->clearVariable("_value", true);
@@ -572,74 +1034,163 @@ void Serializer::processOCallStatement(const AstObject &o_call_statement)
     auto&& call_o_word = o_call_statement.at("callOCommand").as_object();
     auto&& call_o_word_type = call_o_word.at("type").as_string();
 
-    std::stringstream ss;
-    AstObject substatement;
-    if (call_o_word_type == "nameIndexOCommand") {
+    const AstObject* substatement_ptr = nullptr;
+    if (o_call_statement.contains("linkedSubIndex")) {
+        // bound by the Linker
+        auto sub_index = static_cast<std::size_t>(o_call_statement.at("linkedSubIndex").as_integer());
+        substatement_ptr = this->_program->getLinkResult().sub_list[sub_index];
+        if (this->_profiler) {
+            this->_profiler->countSubCall(sub_index);
+        }
+    } else if (call_o_word_type == "nameIndexOCommand") {
         auto&& index = call_o_word.at("index").as_string();
         auto it = this->_nameindex_o_substatement_map.find(index);
         if (it == this->_nameindex_o_substatement_map.end()) {
+            std::stringstream ss;
             ss << "Undefined o-call subject: type: " << call_o_word_type 
                << ", index: " << index;
             throw SerializerError(ss.str());
         }
-        substatement = it->second;
+        substatement_ptr = it->second;
     } else {
         // numberIndexOCommand
-        double index = this->getValue(call_o_word.at("index").as_object());
+        int index = this->getNumberIndexOfNumberIndexOCommand(call_o_word);
         auto it = this->_numberindex_o_substatement_map.find(index);
         if (it == this->_numberindex_o_substatement_map.end()) {
+            std::stringstream ss;
             ss << "Undefined o-call subject: type: " << call_o_word_type 
                << ", index: " << index;
             throw SerializerError(ss.str());
         }
-        substatement = it->second;
+        substatement_ptr = it->second;
     }
 
-    auto&& body = substatement.at("body").as_array();
+    // calc the call params in the caller environment
+    auto&& param_list = o_call_statement.at("paramList").as_array();
+    auto& param_value_list = this->_call_param_value_list;
+    param_value_list.clear();
+    for (const auto& param : param_list) {
+        param_value_list.push_back(this->getValue(param.as_object()));
+    }
+
+    // save the caller environment, a sub may be called inside another sub,
+    // the frame takes the maps without copying, they share the memory resource
+    ExecutionFrame frame(this->_frame_stack.get_allocator());
+    frame.type = FrameType::FRAME_TYPE_O_CALL;
+    frame.statement = &o_call_statement;
+    frame.substatement = substatement_ptr;
+    frame.caller_is_in_sub = this->_is_in_sub;
+    frame.caller_sub_numberindex_variable_value_map = std::move(this->_sub_numberindex_variable_value_map);
+    frame.caller_sub_nameindex_variable_value_map = std::move(this->_sub_nameindex_variable_value_map);
+    if (util::Trace::IsEnabled(util::Trace::CALL)) {
+        frame.trace_begin_ns = util::Trace::NowNs();
+    }
+    this->_frame_stack.emplace_back(std::move(frame));
 
-    // set the in-sub flag
+    ++this->_execution_usage.call_depth;
+    this->checkExecutionBudget(call_o_word);
+
+    // enter the sub environment
     this->_is_in_sub = true;
-    
-    RS274LETTER_ASSERT(this->_sub_nameindex_variable_value_map.empty());
-    RS274LETTER_ASSERT(this->_sub_numberindex_variable_value_map.empty());
+    this->_sub_numberindex_variable_value_map.clear();
+    this->_sub_nameindex_variable_value_map.clear();
 
     // assign the sub-environment call param
-    auto&& param_list = o_call_statement.at("paramList").as_array();
-    if (!param_list.empty()) {
-        for (std::size_t i = 0; i < param_list.size(); ++i) {
-            this->storeVariable(i + 1, this->getValue(param_list[i].as_object()));
-        }
+    for (std::size_t i = 0; i < param_value_list.size(); ++i) {
+        this->storeVariable(i + 1, param_value_list[i]);
     }
-    
-    this->processStatementList(body);
 
-    // examine the flow state
-    if (this->_current_flow_state == FlowState::FLOW_STATE_NEED_RETURN) {
-        // return by the return statement
-        // consume the return flow
-        this->consumeFlowControl(o_call_statement);
+    this->pushStatementListFrame(substatement_ptr->at("body").as_array());
+}
+
+template <typename Dialect>
+void BasicSerializer<Dialect>::exitOCallFrame(const AstObject &return_expression)
+{
+    auto& frame = this->_frame_stack.back();
+    RS274LETTER_ASSERT(frame.type == FrameType::FRAME_TYPE_O_CALL);
+
+    // the return value is calculated in the sub environment
+    if (return_expression.empty()) {
+        this->storeVariable("_value_returned", 0, true);
     } else {
-        // not returned by a return statement
-        auto&& return_expression = substatement.at("endsubRtnExpr").as_object();
-        if (return_expression.empty()) {
-            this->storeVariable("_value_returned", 0, true);
-        } else {
-            this->storeVariable("_value_returned", 1, true);
-            double value = this->getValue(return_expression);
-            this->storeVariable("_value", value, true);   
-        }
+        double return_value = this->getValue(return_expression);
+        this->storeVariable("_value_returned", 1, true);
+        this->storeVariable("_value", return_value, true);
     }
 
-    // reset the in-sub flag
-    this->_is_in_sub = false;
-    this->_sub_nameindex_variable_value_map.clear();
-    this->_sub_numberindex_variable_value_map.clear();
+    // go back to the caller environment
+    this->_is_in_sub = frame.caller_is_in_sub;
+    this->_sub_numberindex_variable_value_map = std::move(frame.caller_sub_numberindex_variable_value_map);
+    this->_sub_nameindex_variable_value_map = std::move(frame.caller_sub_nameindex_variable_value_map);
+
+    if (frame.trace_begin_ns != 0) {
+        util::Trace::Record("o-call", util::Trace::CALL, frame.trace_begin_ns, util::Trace::NowNs(),
+            Linker::GetOWordShowString(frame.substatement->at("subOCommand").as_object()));
+    }
+
+    --this->_execution_usage.call_depth;
+    this->_frame_stack.pop_back();
+}
+
+template <typename Dialect>
+void BasicSerializer<Dialect>::unwindFrameStackTo(FrameType frame_type)
+{
+    // the Linker and Parser make sure the frame exists
+    while (!this->_frame_stack.empty() && this->_frame_stack.back().type != frame_type) {
+        // an o-return leaves the loops it is in, the loop frames hold no other state
+        RS274LETTER_ASSERT(this->_frame_stack.back().type == FrameType::FRAME_TYPE_STATEMENT_LIST
+            || (frame_type == FrameType::FRAME_TYPE_O_CALL
+                && (this->_frame_stack.back().type == FrameType::FRAME_TYPE_O_WHILE
+                    || this->_frame_stack.back().type == FrameType::FRAME_TYPE_O_REPEAT)));
+        this->_frame_stack.pop_back();
+    }
+
+    if (this->_frame_stack.empty()) {
+        throw SerializerError("Internal Error, flow control statement without a target frame");
+    }
+}
+
+template <typename Dialect>
+void BasicSerializer<Dialect>::unwindFrameStackToLoop()
+{
+    // the Linker and Parser make sure the loop exists in the same sub
+    while (!this->_frame_stack.empty() 
+        && this->_frame_stack.back().type != FrameType::FRAME_TYPE_O_WHILE
+        && this->_frame_stack.back().type != FrameType::FRAME_TYPE_O_REPEAT) {
+        RS274LETTER_ASSERT(this->_frame_stack.back().type == FrameType::FRAME_TYPE_STATEMENT_LIST);
+        this->_frame_stack.pop_back();
+    }
+
+    if (this->_frame_stack.empty()) {
+        throw SerializerError("Internal Error, o-break or o-continue without a loop frame");
+    }
+}
+
+template <typename Dialect>
+int BasicSerializer<Dialect>::getNumberIndexOfNumberIndexOCommand(const AstObject &o_word)
+{
+    RS274LETTER_ASSERT_TYPE(o_word, "numberIndexOCommand");
+    double o_word_index_d = this->getValue(o_word.at("index").as_object());
+
+    auto&& index_int_opt = _convert_to_integer(o_word_index_d);
+    if (!index_int_opt) {
+        std::stringstream ss;
+        ss << "Invalid o-word number index larger than tolerance or is negetive:"
+           << "\ntolerance:" << this->_s_double_to_integer_tolerance
+           << "\nindex:" << std::setprecision(10) << o_word_index_d;
+        throw SerializerError(ss.str());
+    }
+
+    return index_int_opt.value();
 }
 
-double Serializer::getValue(const AstObject &expression)
+template <typename Dialect>
+double BasicSerializer<Dialect>::getValue(const AstObject &expression)
 {
     auto&& expression_type = expression.at("type").as_string();
 
+    ++this->_stats.expressions;
+
     if (expression_type == "doubleNumericLiteral" || expression_type == "integerNumericLiteral") {
         return this->getValueOfNumericLiteral(expression);
     } else if (expression_type == "binaryExpression") {
@@ -660,25 +1211,29 @@ double Serializer::getValue(const AstObject &expression)
     }
 }
 
-double Serializer::getValueOfNumericLiteral(const AstObject &v)
+template <typename Dialect>
+double BasicSerializer<Dialect>::getValueOfNumericLiteral(const AstObject &v)
 {
     RS274LETTER_ASSERT_TYPE2(v, "doubleNumericLiteral", "integerNumericLiteral");
     return v.at("value").as_double();
 }
 
-double Serializer::getValueOfDoubleNumericLiteral(const AstObject &v)
+template <typename Dialect>
+double BasicSerializer<Dialect>::getValueOfDoubleNumericLiteral(const AstObject &v)
 {
     RS274LETTER_ASSERT_TYPE(v, "doubleNumericLiteral");
     return v.at("value").as_double();
 }
 
-int Serializer::getValueOfIntegerNumericLiteral(const AstObject &v)
+template <typename Dialect>
+int BasicSerializer<Dialect>::getValueOfIntegerNumericLiteral(const AstObject &v)
 {
     RS274LETTER_ASSERT_TYPE(v, "integerNumericLiteral");
     return v.at("value").as_integer();
 }
 
-int Serializer::getNumberIndexOfNumberIndexVariable(const AstObject &variable)
+template <typename Dialect>
+int BasicSerializer<Dialect>::getNumberIndexOfNumberIndexVariable(const AstObject &variable)
 {
     RS274LETTER_ASSERT_TYPE(variable, "numberIndexVariable");
     auto&& index = variable.at("index").as_object(); // the index node
@@ -693,14 +1248,17 @@ int Serializer::getNumberIndexOfNumberIndexVariable(const AstObject &variable)
         throw SerializerError(ss.str());
     }
 
-    RS274LETTER_ASSERT(index_int_opt.value() >= 0);
+    RS274LETTER_ASSERT_AST(index_int_opt.value() >= 0);
     return index_int_opt.value();
 }
 
-double Serializer::getValueOfNumberIndexVariable(const AstObject &v)
+template <typename Dialect>
+double BasicSerializer<Dialect>::getValueOfNumberIndexVariable(const AstObject &v)
 {
     RS274LETTER_ASSERT_TYPE(v, "numberIndexVariable");
-    RS274LETTER_ASSERT(v.at("index").is_object());
+    RS274LETTER_ASSERT_AST(v.at("index").is_object());
+
+    ++this->_stats.variable_reads;
     
     auto index_int = this->getNumberIndexOfNumberIndexVariable(v);
 
@@ -708,49 +1266,54 @@ double Serializer::getValueOfNumberIndexVariable(const AstObject &v)
         return variable_value.value();
     } else {
         // variable not defined
-#ifdef NUMBERINDEX_VARIABLE_UNDEFINED_ERROR
-        std::stringstream ss;
-        ss << "Use undefined numberIndexVariable:"
-           << "\nindex:" << index_int
-           << "\nvariable:" << v.to_string();
-        throw SerializerError(ss.str());
-#else // NOT NUMBERINDEX_VARIABLE_UNDEFINED_ERROR
-        return 0;
-#endif // NUMBERINDEX_VARIABLE_UNDEFINED_ERROR
+        if constexpr (Dialect::kNumberIndexVariableUndefinedError) {
+            std::stringstream ss;
+            ss << "Use undefined numberIndexVariable:"
+               << "\nindex:" << index_int
+               << "\nvariable:" << v.to_string();
+            throw SerializerError(ss.str());
+        } else {
+            return 0;
+        }
     }
 }
 
-std::string Serializer::getNameIndexOfNameIndexVariable(const AstObject &variable)
+template <typename Dialect>
+std::string BasicSerializer<Dialect>::getNameIndexOfNameIndexVariable(const AstObject &variable)
 {
     RS274LETTER_ASSERT_TYPE(variable, "nameIndexVariable");
-    RS274LETTER_ASSERT(variable.at("index").is_string());
+    RS274LETTER_ASSERT_AST(variable.at("index").is_string());
 
     return variable.at("index").as_string();
 }
 
-double Serializer::getValueOfNameIndexVariable(const AstObject &v)
+template <typename Dialect>
+double BasicSerializer<Dialect>::getValueOfNameIndexVariable(const AstObject &v)
 {
     RS274LETTER_ASSERT_TYPE(v, "nameIndexVariable");
-    RS274LETTER_ASSERT(v.at("index").is_string());
+    RS274LETTER_ASSERT_AST(v.at("index").is_string());
+
+    ++this->_stats.variable_reads;
 
     auto&& index_name = this->getNameIndexOfNameIndexVariable(v);
 
     if (auto variable_value = this->existsAndGetVariable(index_name)) {
         return variable_value.value();
     } else {
-#ifdef NAMEINDEX_VARIABLE_UNDEFINED_ERROR
-        std::stringstream ss;
-        ss << "Use undefined nameIndexVariable:"
-           << "\nindex:" << index_name
-           << "\nvariable:" << v.to_string();
-        throw SerializerError(ss.str());
-#else // NOT NAMEINDEX_VARIABLE_UNDEFINED_ERROR
-        return 0;
-#endif // NAMEINDEX_VARIABLE_UNDEFINED_ERROR
+        if constexpr (Dialect::kNameIndexVariableUndefinedError) {
+            std::stringstream ss;
+            ss << "Use undefined nameIndexVariable:"
+               << "\nindex:" << index_name
+               << "\nvariable:" << v.to_string();
+            throw SerializerError(ss.str());
+        } else {
+            return 0;
+        }
     }
 }
 
-double Serializer::getValueOfBinaryExpression(const AstObject &expression)
+template <typename Dialect>
+double BasicSerializer<Dialect>::getValueOfBinaryExpression(const AstObject &expression)
 {
     RS274LETTER_ASSERT_TYPE(expression, "binaryExpression");
     auto left_value = this->getValue(expression.at("left").as_object());
@@ -808,30 +1371,29 @@ double Serializer::getValueOfBinaryExpression(const AstObject &expression)
     }
 }
 
-double Serializer::getValueOfInsideFunctionExpression(const AstObject &expression)
+template <typename Dialect>
+double BasicSerializer<Dialect>::getValueOfInsideFunctionExpression(const AstObject &expression)
 {
     RS274LETTER_ASSERT_TYPE(expression, "insideFunctionExpression");
 
-    auto&& function_name = expression.at("functionName").as_string();
+    // bound by the Parser
+    auto function_id = static_cast<InsideFunctionId>(expression.at("functionId").as_integer());
 
     auto&& param = expression.at("param");
-    double param_value;
 
-    if (function_name == "atan") {
-        // special function atan, return in this cpp if-branch
-        RS274LETTER_ASSERT(param.is_array());
-        RS274LETTER_ASSERT(param.as_array().size() == 2);
+    switch (function_id) {
+    case INSIDE_FUNCTION_ATAN: {
+        // special function atan, atan[y]/[x]
+        RS274LETTER_ASSERT_AST(param.is_array());
+        RS274LETTER_ASSERT_AST(param.as_array().size() == 2);
 
-        // first param of atan2
-        param_value = this->getValue(param.as_array()[0].as_object());
-        
-        // second param of atan2
+        double param_value = this->getValue(param.as_array()[0].as_object());
         double param_value2 = this->getValue(param.as_array()[1].as_object());
-        
-        // reg2deg
-        return _rad2deg(std::atan2(param_value, param_value2));
-    } else if (function_name == "exists") {
-        // special function exists, return in this cpp if-branch
+
+        return Atan2Degree(param_value, param_value2);
+    }
+    case INSIDE_FUNCTION_EXISTS:
+        // special function exists
         RS274LETTER_ASSERT_TYPE2(param, "nameIndexVariable", "numberIndexVariable");
         if (param.at("type").as_string() == "nameIndexVariable") {
             auto&& param_name_index = this->getNameIndexOfNameIndexVariable(param.as_object());
@@ -840,44 +1402,47 @@ double Serializer::getValueOfInsideFunctionExpression(const AstObject &expressio
             auto&& param_number_index = this->getNumberIndexOfNumberIndexVariable(param.as_object());
             return this->existsAndGetVariable(param_number_index).has_value();
         }
-    } else {
-        RS274LETTER_ASSERT(param.is_object());
-        param_value = this->getValue(param.as_object());
+    default:
+        break;
+    }
+
+    if (IsNativeFunctionId(function_id)) {
+        return this->callNativeFunction(function_id, param.as_array());
     }
 
     // normal inside functions
-    if (function_name == "abs") {
-        return std::abs(param_value);
-    } else if (function_name == "acos") {
-        return _rad2deg(std::acos(param_value));
-    } else if (function_name == "asin") {
-        return _rad2deg(std::asin(param_value));
-    } else if (function_name == "cos") {
-        return std::cos(_deg2rad(param_value));
-    } else if (function_name == "exp") {
-        return std::exp(param_value);
-    } else if (function_name == "fix") {
-        return std::floor(param_value); // Round down to integer
-    } else if (function_name == "fup") {
-        return std::ceil(param_value); // Round up to integer
-    } else if (function_name == "round") {
-        return std::round(param_value); // Round to nearest integer
-    } else if (function_name == "ln") {
-        return std::log(param_value);
-    } else if (function_name == "sin") {
-        return std::sin(_deg2rad(param_value));
-    } else if (function_name == "sqrt") {
-        return std::sqrt(param_value);
-    } else if (function_name == "tan") {
-        return std::tan(_deg2rad(param_value));
+    auto function = GetUnaryInsideFunction(function_id);
+    RS274LETTER_ASSERT_AST(function != nullptr);
+    RS274LETTER_ASSERT_AST(param.is_object());
+
+    return function(this->getValue(param.as_object()));
+}
+
+template <typename Dialect>
+double BasicSerializer<Dialect>::callNativeFunction(InsideFunctionId function_id, const AstArray &param_list)
+{
+    // bound by Program::compile()
+    auto&& native_function_list = this->_program->getNativeFunctionList();
+    std::size_t index = function_id - INSIDE_FUNCTION_COUNT;
+    if (index >= native_function_list.size()) {
+        std::stringstream ss;
+        ss << "Native function is not registered, id: " << static_cast<int>(function_id);
+        throw SerializerError(ss.str());
     }
-    else {
-        RS274LETTER_ASSERT(false); // TODO
-        return -1;
-    } 
+
+    auto&& native_function = *native_function_list[index];
+    RS274LETTER_ASSERT_AST(param_list.size() == native_function.arity);
+
+    double param_values[NativeFunction::kMaxArity];
+    for (std::size_t i = 0; i < native_function.arity; ++i) {
+        param_values[i] = this->getValue(param_list[i].as_object());
+    }
+
+    return native_function.callback(param_values);
 }
 
-double Serializer::getValueOfAssignmentExpression(const AstObject &expression)
+template <typename Dialect>
+double BasicSerializer<Dialect>::getValueOfAssignmentExpression(const AstObject &expression)
 {
     RS274LETTER_ASSERT_TYPE(expression, "assignmentExpression");
 
@@ -893,9 +1458,13 @@ double Serializer::getValueOfAssignmentExpression(const AstObject &expression)
     return right_value; // return the assigned value as the value of assignmentExpression
 }
 
-void Serializer::assignVariable(const AstObject &target, double value)
+template <typename Dialect>
+void BasicSerializer<Dialect>::assignVariable(const AstObject &target, double value)
 {
     RS274LETTER_ASSERT_TYPE2(target, "numberIndexVariable", "nameIndexVariable");
+
+    ++this->_stats.variable_writes;
+
     if (target.at("type").as_string() == "numberIndexVariable") {
         // numberIndexVariable
         int target_index = this->getNumberIndexOfNumberIndexVariable(target);
@@ -909,28 +1478,32 @@ void Serializer::assignVariable(const AstObject &target, double value)
     }
 }
 
-bool Serializer::_is_within_tolerance(const double &d)
+template <typename Dialect>
+bool BasicSerializer<Dialect>::_is_within_tolerance(const double &d)
 {
     return (std::abs(d - std::round(d)) <= _s_double_to_integer_tolerance);
 }
 
-std::optional<int> Serializer::_convert_to_integer(const double &d, bool not_negative /* = true*/)
+template <typename Dialect>
+std::optional<int> BasicSerializer<Dialect>::_convert_to_integer(const double &d, bool not_negative /* = true*/)
 {
     if (not_negative && d < 0.0) return std::nullopt;
     if (_is_within_tolerance(d)) {
-        return static_cast<int>(d);
+        return static_cast<int>(std::round(d));
     } else {
         return std::nullopt;
     }
 }
 
-bool Serializer::_start_with_underline(const std::string &str)
+template <typename Dialect>
+bool BasicSerializer<Dialect>::_start_with_underline(const std::string &str)
 {
     if (str.empty()) return false;
     if (str[0] == '_') return true; else return false;
 }
 
-bool Serializer::_is_global_variable(const AstObject &variable)
+template <typename Dialect>
+bool BasicSerializer<Dialect>::_is_global_variable(const AstObject &variable)
 {
     RS274LETTER_ASSERT_TYPE2(variable, "numberIndexVariable", "nameIndexVariable");
     auto&& type = variable.at("type").as_string();
@@ -943,13 +1516,13 @@ bool Serializer::_is_global_variable(const AstObject &variable)
     }
 }
 
-bool Serializer::_is_global_variable_name_index(const std::string &variable_index)
+template <typename Dialect>
+bool BasicSerializer<Dialect>::_is_global_variable_name_index(const std::string &variable_index)
 {
     return _start_with_underline(variable_index);
 }
 
-} // namespace rs274letter
-
-
-
+template class BasicSerializer<StrictDialect>;
+template class BasicSerializer<LenientDialect>;
 
+} // namespace rs274letter
@@ -2,68 +2,28 @@
 
 #include "Tokenizer.h"
 #include "Parser.h"
+#include "Linker.h"
+#include "Program.h"
+#include "Dialect.h"
 #include "Exception.h"
+#include "CommandStatement.h"
+#include "CommandSink.h"
+#include "ExecutionBudget.h"
+#include "ExecutionProfiler.h"
+#include "MemoryFootprint.h"
+#include "Stats.h"
+#include "InsideFunction.h"
 #include "macro.h"
 
+#include <chrono>
 #include <list>
+#include <memory_resource>
 #include <unordered_map>
 #include <unordered_set>
 
 namespace rs274letter
 {
 
-using CommandNumberGroup = std::pair<char, double>;
-
-class CommandStatement {
-public:
-    CommandStatement() noexcept = default;
-    ~CommandStatement() noexcept = default;
-
-    inline void pushBack(const CommandNumberGroup& cng) {
-        auto it = command_map.find(cng.first);
-        if (it == command_map.end()) {
-            command_map.insert({cng.first, {cng.second}});
-        } else {
-            it->second.push_back(cng.second);
-        }
-    }
-
-    inline unsigned int appearTimesOfLetter(char letter) const { 
-        auto it = command_map.find(letter);
-        return it == command_map.end() ? 0 : it->second.size();
-    }
-
-    inline bool has_letter(char letter) const 
-    { return this->appearTimesOfLetter(letter) != 0 ; }
-
-    inline std::optional<std::vector<double>> getNumbersOfLetter(char letter) const {
-        auto it = command_map.find(letter);
-        if (it == command_map.end()) 
-            return std::nullopt;
-        else 
-            return it->second;
-    }
-
-    inline std::string toString() const {
-        std::stringstream ss;
-        for (const auto& group : command_map) {
-            ss << group.first << ": ";
-            for (const auto& number : group.second) {
-                ss << number << ", ";
-            }
-            ss << "\n";
-        }
-        return ss.str();
-    }
-private:
-    std::unordered_map<char, std::vector<double>> command_map;
-};
-
-inline std::ostream& operator<<(std::ostream& os, const CommandStatement& cs) {
-    os << cs.toString();
-    return os;
-}
-
 class SerializerError : public Exception {
 public:
     SerializerError(const std::string& str) : Exception(str) {}
@@ -76,31 +36,87 @@ public:
 /**
  * This class will 
  *  - calculate the variables in the parsed result
- *  - serialize the commands to a list
+ *  - serialize the commands to a CommandSink, a CommandListSink by default
  * Note:
- *  - Each while loop layer should be smaller than 1000 times by default, 
- *    otherwise throw exception.
+ *  - The execution is limited by an ExecutionBudget, by default each while
+ *    loop layer should be smaller than 1000 times, otherwise throw exception.
+ *  - The statements are executed on an explicit frame stack instead of
+ *    the C++ stack, so the execution can be paused after any command
+ *    with `step()`, and resumed later inside nested if/while/call blocks.
+ *  - With `setCheckpointInterval()`, the whole execution state is recorded
+ *    every K commands, `restartFromCommand()` then resumes from the nearest
+ *    checkpoint instead of executing the program from the top.
+ *  - The runtime state (variables, subs, frame stack, checkpoints) and the
+ *    default CommandListSink allocate from the memory resource given on
+ *    construction, the global heap by default. The name-indexed variable keys
+ *    are still std::string, the short names stay in their inline buffer.
+ *    With `reset(..., ResetMode::KEEP_CAPACITY)` one Serializer runs program
+ *    after program reusing the memory of the previous ones.
+ *  - Once warm, the loops and the o-calls allocate nothing: the local
+ *    variables of a call are hash nodes from a pool of the Serializer over
+ *    that resource, freed to the pool at its return and reused by the next
+ *    call.
+ *  - A Serializer executes a `Program`, either given by `reset(Program::ptr)`
+ *    or compiled from the parse_result by `link()`. Many Serializers can
+ *    share one Program, also on different threads, see `Program` for the
+ *    thread-safety. A Serializer itself is not thread-safe.
+ *  - The runtime rules of the `Dialect`, like reading an undefined variable,
+ *    are checked at compile time. Instantiated for StrictDialect and
+ *    LenientDialect, `Serializer` is the StrictDialect one.
  * 
  * Error:
  *  - Catch the exception 
 */
-class Serializer {
+template <typename Dialect>
+class BasicSerializer {
 public:
-    using ptr = std::shared_ptr<Serializer>;
-    ~Serializer() noexcept = default;
+    using ptr = std::shared_ptr<BasicSerializer>;
+    ~BasicSerializer() noexcept = default;
+
+    BasicSerializer() = default;
 
-    Serializer() noexcept = default;
+    // a copy would share the default CommandListSink with the original,
+    // and its frames would refer to the AST of the original
+    BasicSerializer(const BasicSerializer&) = delete;
+    BasicSerializer& operator=(const BasicSerializer&) = delete;
+
+    /**
+     * @brief construct with the memory resource of the runtime state and of the
+     * default CommandListSink. The resource should outlive the Serializer and
+     * the lists taken by takeCommandList().
+    */
+    explicit BasicSerializer(std::pmr::memory_resource* memory_resource)
+        : _memory_resource(memory_resource) {}
     
     // Construct or reset
-    template <typename T>
-    Serializer(T&& parse_result) noexcept {
+    template <typename T, typename = std::enable_if_t<
+        !std::is_convertible_v<T, std::pmr::memory_resource*> && std::is_constructible_v<AstObject, T>>>
+    BasicSerializer(T&& parse_result) {
         this->reset(std::forward<T>(parse_result));
     }
 
-    template <typename T>
-    void reset(T&& parse_result) noexcept {
-        static_assert(std::is_constructible<AstObject, T>::value, "Parameter can't be used to construct a (AstObject)parse_result");
-        this->clear();
+    explicit BasicSerializer(Program::ptr program) {
+        this->reset(std::move(program));
+    }
+
+    /**
+     * ResetMode
+     *  - RELEASE: the containers give their memory back, like a new Serializer
+     *  - KEEP_CAPACITY: the containers are only cleared, the vectors and the hash
+     *    tables keep their capacity. The nodes go back to the memory resource, so
+     *    with a pool resource the next program allocates almost nothing.
+    */
+    enum class ResetMode { RELEASE, KEEP_CAPACITY };
+
+    /**
+     * @brief reset with a parse_result, it is compiled into a Program
+     * owned by this Serializer when linking
+     * @throw std::bad_alloc, copying the parse_result and storing the
+     * internal variables allocate
+    */
+    template <typename T, typename = std::enable_if_t<std::is_constructible_v<AstObject, T>>>
+    void reset(T&& parse_result, ResetMode reset_mode = ResetMode::RELEASE) {
+        this->clear(reset_mode);
         this->_parse_result = std::forward<T>(parse_result);
 
 
@@ -115,13 +131,30 @@ public:
         this->initInternalVariables();
     }
 
-    inline void clear() {
+    /**
+     * @brief reset with a compiled Program, which may be shared with other
+     * Serializers, no copy of the AST is made
+     * @throw std::bad_alloc, storing the internal variables allocates
+    */
+    inline void reset(Program::ptr program, ResetMode reset_mode = ResetMode::RELEASE) {
+        this->clear(reset_mode);
+        this->_program = std::move(program);
+        this->initInternalVariables();
+    }
+
+    inline void clear(ResetMode reset_mode = ResetMode::RELEASE) {
         this->_parse_result.clear();
-        this->_command_statement_list.clear();
+        this->_program.reset();
+        this->_command_list_sink->clear();
 
         this->_nameindex_oword_set.clear();
         this->_numberindex_oword_set.clear();
 
+        this->_numberindex_o_substatement_map.clear();
+        this->_nameindex_o_substatement_map.clear();
+        this->_initial_numberindex_variable_list.clear();
+        this->_initial_nameindex_variable_list.clear();
+
         this->_nameindex_variable_value_map.clear();
         this->_numberindex_variable_value_map.clear();
         this->_sub_nameindex_variable_value_map.clear();
@@ -129,8 +162,38 @@ public:
         this->_global_nameindex_variable_value_map.clear();
 
         this->_is_in_sub = false;
+
+        this->_frame_stack.clear();
+        this->_is_started = false;
+        this->_step_command_count = 0;
+        this->_command_count = 0;
+        this->_is_fast_forwarding = false;
+
+        this->_checkpoint_list.clear();
+
+        this->_execution_usage = ExecutionUsage{};
+
+        if (reset_mode == ResetMode::RELEASE) {
+            this->releaseMemory();
+        }
     }
 
+    inline std::pmr::memory_resource* getMemoryResource() const { return this->_memory_resource; }
+
+    /**
+     * @brief the bytes held now by each component, and the AST nodes per type,
+     * see `MemoryFootprint`. Walks the AST and all the containers, call it
+     * between the steps, not for each command. For the peak bytes during the
+     * execution, construct the Serializer with a CountingMemoryResource.
+    */
+    MemoryFootprint getMemoryFootprint() const;
+
+private:
+    /**
+     * @brief give the capacity of the cleared containers back to the memory resource
+    */
+    void releaseMemory();
+
 private:
     void initInternalVariables();
 
@@ -160,15 +223,150 @@ public:
         }
     }
 
-    inline std::list<CommandStatement> getCommandList() const {
-        return this->_command_statement_list;
+    /**
+     * @brief set the sink which consumes the commands as they are produced.
+     * The sink is kept by reset(). Pass nullptr to go back to the default
+     * CommandListSink.
+    */
+    inline void setCommandSink(CommandSink::ptr command_sink) {
+        if (command_sink) {
+            this->_command_sink = std::move(command_sink);
+        } else {
+            this->_command_sink = this->_command_list_sink;
+        }
+    }
+
+    /**
+     * @brief the commands collected by the default CommandListSink,
+     * empty if another sink is set
+    */
+    inline const CommandListSink::CommandList& getCommandList() const {
+        return this->_command_list_sink->getCommandList();
+    }
+
+    /**
+     * @brief move the commands collected by the default CommandListSink out
+    */
+    inline CommandListSink::CommandList takeCommandList() {
+        return this->_command_list_sink->takeCommandList();
+    }
+
+    /**
+     * @brief set the limits of the execution, see `ExecutionBudget`.
+     * The budget is kept by reset().
+    */
+    inline void setExecutionBudget(const ExecutionBudget& execution_budget) {
+        this->_execution_budget = execution_budget;
     }
 
+    inline const ExecutionBudget& getExecutionBudget() const { return this->_execution_budget; }
+
     /**
-     * @brief process the whole parse_result
+     * @brief profile the execution per statement, see `ExecutionProfiler`.
+     * The profiler is kept by reset(). Pass nullptr to stop profiling, which
+     * is the default and costs one pointer test for each step.
+    */
+    inline void setProfiler(ExecutionProfiler::ptr profiler) {
+        this->_profiler = std::move(profiler);
+    }
+
+    inline const ExecutionProfiler::ptr& getProfiler() const { return this->_profiler; }
+
+    /**
+     * @brief the counters of the executions since the construction or
+     * resetStats(), they are kept by reset(). The counters are plain members,
+     * their changes are added to the GlobalStats at the end of each step().
+     * The commands dropped by restartFromCommand() are not counted.
+    */
+    inline const SerializerStats& getStats() const { return this->_stats; }
+
+    inline void resetStats() {
+        this->publishStats();
+        this->_stats = SerializerStats{};
+        this->_published_stats = SerializerStats{};
+    }
+
+    /**
+     * @brief compile the parse_result into a Program, see `Program::compile()`.
+     * Called by processProgram() if not linked yet, call it before to reject
+     * invalid ASTs and o-word mismatches without executing anything.
+     * Does nothing if reset with a Program.
+     * @throw AstValidateError, LinkError
+    */
+    void link();
+
+    /**
+     * @brief the executed Program, nullptr before link(). The Program
+     * compiled by link() can be shared with other Serializers.
+    */
+    inline Program::ptr getProgram() const { return this->_program; }
+
+    /**
+     * @brief set a variable before the program starts, like a param of the
+     * whole program. The initial variables are stored after the internal
+     * variables at each start, also when restarting without a checkpoint.
+     * They are cleared by reset().
+     * @throw SerializerError at the start, if a name-indexed one is internal
+    */
+    inline void setInitialVariable(int index, double value) {
+        this->_initial_numberindex_variable_list.emplace_back(index, value);
+    }
+
+    inline void setInitialVariable(const std::string& index, double value) {
+        this->_initial_nameindex_variable_list.emplace_back(index, value);
+    }
+
+    /**
+     * @brief process the whole parse_result, or the rest of it if `step()`
+     * has been called.
     */
     void processProgram();
 
+    /**
+     * @brief execute the program until `max_commands` commands are produced
+     * or the program ends. The next call resumes where this call stops.
+     * @return true if the program has more statements to execute
+     * @throw AstValidateError, LinkError, SerializerError. After a throw the execution state is
+     * undefined, call reset() before the next step().
+    */
+    bool step(std::size_t max_commands);
+
+    /**
+     * @brief returns true if the whole program has been executed
+    */
+    inline bool isFinished() const { return this->_is_started && this->_frame_stack.empty(); }
+
+    /**
+     * @brief the number of commands produced since the program start,
+     * which is also the index of the next command
+    */
+    inline std::size_t getCommandCount() const { return this->_command_count; }
+
+    /**
+     * @brief record a checkpoint of the execution state (variables, subs,
+     * frame stack and command count) at the program start and after every
+     * `interval` commands. 0 disables it, which is the default.
+     * The interval is kept by reset(), the recorded checkpoints are not.
+    */
+    inline void setCheckpointInterval(std::size_t interval) {
+        this->_checkpoint_interval = interval;
+    }
+
+    inline std::size_t getCheckpointCount() const { return this->_checkpoint_list.size(); }
+
+    /**
+     * @brief restart the execution at the command with index `command_index`
+     * (0-based, in the order the commands are produced). The state is restored
+     * from the nearest checkpoint before it, or from the program start if there
+     * is none, and the commands between are executed without being sent to the sink.
+     * Call processProgram() or step() to continue.
+     * @note the checkpoints refer to the AST of this Serializer, they are only
+     * valid until the next reset()
+     * @throw AstValidateError, LinkError, SerializerError, also if the program ends before
+     * `command_index`. After a throw call reset().
+    */
+    void restartFromCommand(std::size_t command_index);
+
     template <typename T>
     std::optional<double> hasVariable(const T& key) const {
         if constexpr (std::is_constructible_v<std::string, T>) {
@@ -219,8 +417,8 @@ private:
     */
 
     /**
-     * @brief delete a variable, if it doesn't exist, it depends on the impl definition
-     * THROW_IF_INTERNAL_DELETE_UNDEFINED_VARIABLE, if defined in the build stage
+     * @brief delete a variable, if it doesn't exist, it depends on the rule
+     * `Dialect::kThrowIfInternalDeleteUndefinedVariable`, if it is true
      * this function will throw exception.
      * @note this is an internal behaviour.
      */
@@ -285,37 +483,154 @@ private:
     /*** process statements ***/
     /**************************/
 
+    enum GlobalVariableType { Internal = 0, Normal = 1 };
+
+    enum FrameType {
+        FRAME_TYPE_STATEMENT_LIST = 0, // executing the statements in a list one by one
+        FRAME_TYPE_O_WHILE, // a while loop, below the frames of its body
+        FRAME_TYPE_O_REPEAT, // a repeat loop, below the frames of its body
+        FRAME_TYPE_O_CALL // a sub call, below the frames of the sub body
+    };
+
+    /**
+     * ExecutionFrame
+     * An element of the explicit frame stack, referring to the AST nodes
+     * of the _parse_result.
+     * It is allocator-aware, so the frames in a std::pmr::vector allocate
+     * the caller environment from the memory resource of the vector.
+    */
+    struct ExecutionFrame {
+        using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+        ExecutionFrame() = default;
+        ExecutionFrame(const ExecutionFrame&) = default;
+        ExecutionFrame(ExecutionFrame&&) = default;
+        ExecutionFrame& operator=(const ExecutionFrame&) = default;
+        ExecutionFrame& operator=(ExecutionFrame&&) = default;
+
+        explicit ExecutionFrame(const allocator_type& allocator)
+            : caller_sub_numberindex_variable_value_map(allocator.resource()),
+              caller_sub_nameindex_variable_value_map(allocator.resource()) {}
+        ExecutionFrame(const ExecutionFrame& other, const allocator_type& allocator)
+            : ExecutionFrame(allocator) { *this = other; }
+        ExecutionFrame(ExecutionFrame&& other, const allocator_type& allocator)
+            : ExecutionFrame(allocator) { *this = std::move(other); }
+
+        FrameType type;
+
+        // FRAME_TYPE_STATEMENT_LIST: the list and the index of the next statement
+        const AstArray* statement_list = nullptr;
+        std::size_t next_index = 0;
+
+        // FRAME_TYPE_O_WHILE, FRAME_TYPE_O_REPEAT, FRAME_TYPE_O_CALL: the statement of this frame
+        const AstObject* statement = nullptr;
+
+        // FRAME_TYPE_O_WHILE, FRAME_TYPE_O_REPEAT: the iterations done
+        std::size_t loop_times = 0;
+
+        // FRAME_TYPE_O_REPEAT: the count calculated when the loop is entered
+        std::size_t repeat_times = 0;
+
+        // FRAME_TYPE_O_CALL: the called sub, and the caller environment to go back
+        const AstObject* substatement = nullptr;
+        bool caller_is_in_sub = false;
+        std::pmr::unordered_map<int, double> caller_sub_numberindex_variable_value_map;
+        std::pmr::unordered_map<std::string, double> caller_sub_nameindex_variable_value_map;
+
+        // FRAME_TYPE_O_CALL: the start of the "o-call" trace span, 0 if not traced
+        std::uint64_t trace_begin_ns = 0;
+    };
+
+    /**
+     * Checkpoint
+     * A copy of the whole execution state after `command_count` commands.
+     * Allocator-aware like the ExecutionFrame.
+    */
+    struct Checkpoint {
+        using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+        Checkpoint() = default;
+        Checkpoint(const Checkpoint&) = default;
+        Checkpoint(Checkpoint&&) = default;
+        Checkpoint& operator=(const Checkpoint&) = default;
+        Checkpoint& operator=(Checkpoint&&) = default;
+
+        explicit Checkpoint(const allocator_type& allocator)
+            : numberindex_variable_value_map(allocator.resource()),
+              nameindex_variable_value_map(allocator.resource()),
+              sub_numberindex_variable_value_map(allocator.resource()),
+              sub_nameindex_variable_value_map(allocator.resource()),
+              global_nameindex_variable_value_map(allocator.resource()),
+              numberindex_o_substatement_map(allocator.resource()),
+              nameindex_o_substatement_map(allocator.resource()),
+              frame_stack(allocator.resource()) {}
+        Checkpoint(const Checkpoint& other, const allocator_type& allocator)
+            : Checkpoint(allocator) { *this = other; }
+        Checkpoint(Checkpoint&& other, const allocator_type& allocator)
+            : Checkpoint(allocator) { *this = std::move(other); }
+
+        std::size_t command_count = 0;
+
+        std::pmr::unordered_map<int, double> numberindex_variable_value_map;
+        std::pmr::unordered_map<std::string, double> nameindex_variable_value_map;
+        std::pmr::unordered_map<int, double> sub_numberindex_variable_value_map;
+        std::pmr::unordered_map<std::string, double> sub_nameindex_variable_value_map;
+        std::pmr::unordered_map<std::string, std::pair<GlobalVariableType, double>> global_nameindex_variable_value_map;
+
+        std::pmr::unordered_map<int, const AstObject*> numberindex_o_substatement_map;
+        std::pmr::unordered_map<std::string, const AstObject*> nameindex_o_substatement_map;
+
+        bool is_in_sub = false;
+        std::pmr::vector<ExecutionFrame> frame_stack;
+    };
+
+    /**
+     * @brief start executing the program body from the top, with only
+     * the internal variables defined
+    */
+    void startProgram();
+
     /**
-     * @brief produce a flow jump control
-     * Used to record the current flow_jump_statement waiting wo be consumed
+     * @brief record the current execution state as a checkpoint, if it is
+     * after the last recorded one
     */
-    void produceFlowControl(const AstObject& flow_jump_statement);
+    void recordCheckpoint();
 
     /**
-     * @brief try to consume the flow control produced
-     * It should be called after the while statement receive a RETURN_STATE_NEED_CONTINUE
-     * or RETURN_STATE_NEED_BREAK or FLOW_STATE_NEED_RETURN
-     * @throw throw if flow_jump type is matched but o-words do not match 
-     * @note:
-     *  - if currently flow state is normal, this does nothing
-     *  - if currently flow state isn't normal, and is not while-break or while-continue
-     *    or sub-return, this does nothing
-     *  - if currently flow state isn't normal, and match while-break or while-continue
-     *    or sub-return, but o-words doesn't match, throw
-     *  - if currently flow state isn't normal, and match while-break or while-continue
-     *    or sub-return, and o-words all match, will set current_flow state to normal,
-     *    and clear the current flow_jump_statement
+     * @brief restore the execution state of the checkpoint
     */
-    void consumeFlowControl(const AstObject& this_current_statement);
+    void restoreCheckpoint(const Checkpoint& checkpoint);
 
     /**
-     * @brief process a statement list
-     * This will process each statement in the statement list
+     * @brief push a frame executing the statement list from its first statement
     */
-    void processStatementList(const AstArray& statement_list);
+    void pushStatementListFrame(const AstArray& statement_list);
+
+    /**
+     * @brief execute the frame on the top of the frame stack by one move:
+     *  - a statement list frame executes its next statement, or pops itself at the end
+     *  - a while frame tests the condition, then pushes its body or pops itself
+     *  - a repeat frame pushes its body until the count is reached, then pops itself
+     *  - a call frame is reached when its body ends without `o... return`,
+     *    it calculates the endsub return value and pops itself
+    */
+    void processTopFrame();
+
+    /**
+     * @brief processTopFrame() without the profiler test
+    */
+    void executeTopFrame();
+
+    /**
+     * @brief executeTopFrame() counted and sampled to the statement of the
+     * frame by the _profiler
+    */
+    void processTopFrameProfiled();
 
     /**
      * @brief process a statement
+     * The statements with a body do not execute the body here, they push
+     * frames which are executed by the next processTopFrame().
      * @param statement Any statement that is allowed
      * @throw meet any error
     */
@@ -324,8 +639,7 @@ private:
     /**
      * @brief process the command statement. 
      * This will calculate every number after each command-letter,
-     * and then push back the CommandStatement struct into the
-     * internal command statement list
+     * and then push the CommandStatement struct into the command sink
     */
     void processCommandStatement(const AstObject& command_statement);
     
@@ -339,27 +653,47 @@ private:
     /**
      * @brief process the o-if statement.
      * This will calculate the `test`(condition)s of the if statement,
-     * go into the right branch and process the statement list inside.
+     * and push the statement list of the right branch.
      * @throw If `test` can not be calculated as a value
     */
     void processOIfStatement(const AstObject& o_if_statement);
 
     /**
-     * @brief process the o-while statement.
-     * @throw any error or the single while loop times is larger than allowed.
+     * @brief process the o-while statement, push a while frame
     */
     void processOWhileStatement(const AstObject& o_while_statement);
 
+    /**
+     * @brief test the condition of the while frame on the top, push the body
+     * if the condition is true, otherwise pop the while frame
+     * @throw any error or the execution budget is exhausted
+    */
+    void processOWhileFrame();
+
+    /**
+     * @brief process the o-repeat statement, calculate the count once
+     * and push a repeat frame
+     * @throw If the count is not a non-negative integer
+    */
+    void processORepeatStatement(const AstObject& o_repeat_statement);
+
+    /**
+     * @brief push the body of the repeat frame on the top if the count is not
+     * reached, otherwise pop the repeat frame. No expression is calculated here.
+     * @throw the execution budget is exhausted
+    */
+    void processORepeatFrame();
+
     /**
      * @brief process the o-continue statement
-     * This will produce a flow_jump_statement, and set the current flow state = FLOW_STATE_NEED_CONTINUE, 
-     * to wait for a while-statement to consume this flow_jump, and set the current state to normal.
-     * It is designed that during the flow jump, no other processing should be done
+     * This pops the frames inside the nearest loop, the loop frame then starts
+     * the next iteration.
     */
     void processOContinueStatement(const AstObject& o_continue_statement);
 
     /**
      * @brief process the o-break statement
+     * This pops the frames inside the nearest loop and the loop frame itself.
     */
     void processOBreakStatement(const AstObject& o_break_statement);
 
@@ -369,9 +703,68 @@ private:
     */
     void processOSubStatement(const AstObject& o_sub_statement);
 
-    void processOReturnStatement(const AstObject& o_break_statement);
+    /**
+     * @brief process the o-return statement
+     * This pops the frames inside the nearest call, and then exits the call.
+    */
+    void processOReturnStatement(const AstObject& o_return_statement);
+
+    /**
+     * @brief process the o-call statement
+     * This calculates the params in the caller environment, enters the sub
+     * environment, and pushes a call frame and the sub body.
+    */
     void processOCallStatement(const AstObject& o_call_statement);
 
+    /**
+     * @brief exit the call frame on the top of the frame stack, store the
+     * return value and go back to the caller environment
+     * @param return_expression the return expression of `o... return` or `o... endsub`,
+     * may be empty
+    */
+    void exitOCallFrame(const AstObject& return_expression);
+
+    /**
+     * @brief pop the frames until the top frame is of the `frame_type`,
+     * unwinding to an o-call also pops the while and repeat loops in the sub
+    */
+    void unwindFrameStackTo(FrameType frame_type);
+
+    /**
+     * @brief pop the frames until the top frame is the nearest while or repeat loop
+    */
+    void unwindFrameStackToLoop();
+
+    /**
+     * @brief start counting the execution budget usage of a run
+    */
+    void startExecutionUsage();
+
+    /**
+     * @brief add the change of the _stats since the last call to the GlobalStats
+    */
+    void publishStats();
+
+    /**
+     * @brief check the execution budget usage, called at the loop back-edges
+     * and the o-calls
+     * @param o_word the o-word of the loop or the call, for the error message
+     * @throw SerializerError if any budget is exhausted
+    */
+    void checkExecutionBudget(const AstObject& o_word);
+
+    /**
+     * @brief throw the SerializerError of an exhausted budget
+    */
+    [[noreturn]] void throwExecutionBudgetExhausted(const char* budget_name, 
+        std::size_t limit, const AstObject& o_word) const;
+
+    /**
+     * @brief get the calculated index of a numberIndexOCommand,
+     * only used for the o-words which are not linked
+    */
+    int getNumberIndexOfNumberIndexOCommand(const AstObject& o_word);
+
     /**************************/
     /*** astnode value get  ***/
     /**************************/
@@ -429,6 +822,12 @@ private:
     */
     double getValueOfInsideFunctionExpression(const AstObject& expression);
 
+    /**
+     * @brief calculate the params and call a registered native function
+     * @throw SerializerError if the function was not registered when linking
+    */
+    double callNativeFunction(InsideFunctionId function_id, const AstArray& param_list);
+
     /**
      * @brief get the calculated value of an assignmentExpression
     */
@@ -468,48 +867,92 @@ private: // static
     static bool _is_global_variable_name_index(const std::string& variable_index);
 
 private:
+    // the memory resource of the containers below, declared first to be
+    // initialized before them
+    std::pmr::memory_resource* _memory_resource = std::pmr::get_default_resource();
+
+    // the sub environment variables and the frame stack which saves them at each
+    // o-call, a pool over the _memory_resource: the nodes freed at a return are
+    // reused by the next call. The maps move between them, so they share it.
+    std::pmr::unsynchronized_pool_resource _frame_resource{_memory_resource};
+
     // normal variables
-    std::unordered_map<int, double> _numberindex_variable_value_map;
-    std::unordered_map<std::string, double> _nameindex_variable_value_map;
+    std::pmr::unordered_map<int, double> _numberindex_variable_value_map{_memory_resource};
+    std::pmr::unordered_map<std::string, double> _nameindex_variable_value_map{_memory_resource};
 
     // sub environment variables
-    std::unordered_map<int, double> _sub_numberindex_variable_value_map;
-    std::unordered_map<std::string, double> _sub_nameindex_variable_value_map;
+    std::pmr::unordered_map<int, double> _sub_numberindex_variable_value_map{&_frame_resource};
+    std::pmr::unordered_map<std::string, double> _sub_nameindex_variable_value_map{&_frame_resource};
 
     // global environment name-indexed variable
-    enum GlobalVariableType { Internal = 0, Normal = 1 };
-    std::unordered_map<std::string, std::pair<GlobalVariableType, double>> _global_nameindex_variable_value_map;
+    std::pmr::unordered_map<std::string, std::pair<GlobalVariableType, double>> _global_nameindex_variable_value_map{_memory_resource};
 
     // o-word set
-    std::unordered_set<int> _numberindex_oword_set;
-    std::unordered_set<std::string> _nameindex_oword_set;
+    std::pmr::unordered_set<int> _numberindex_oword_set{_memory_resource};
+    std::pmr::unordered_set<std::string> _nameindex_oword_set{_memory_resource};
 
-    // sub routine store
-    std::unordered_map<int, AstObject> _numberindex_o_substatement_map;
-    std::unordered_map<std::string, AstObject> _nameindex_o_substatement_map;
+    // sub routine store, only for the subs whose o-word is calculated at runtime,
+    // the other subs are in the _link_result
+    std::pmr::unordered_map<int, const AstObject*> _numberindex_o_substatement_map{_memory_resource};
+    std::pmr::unordered_map<std::string, const AstObject*> _nameindex_o_substatement_map{_memory_resource};
 
+    // the parse_result given by reset(), moved into the _program by link()
     AstObject _parse_result;
 
+    // the executed program, shared with other Serializers or compiled by link()
+    Program::ptr _program;
+
+    // set by setInitialVariable(), stored at each start in this order
+    std::pmr::vector<std::pair<int, double>> _initial_numberindex_variable_list{_memory_resource};
+    std::pmr::vector<std::pair<std::string, double>> _initial_nameindex_variable_list{_memory_resource};
+
 private:
     // environment and status
     bool _is_in_sub = false; // if is in a sub environment
 
-    enum FlowState {
-        FLOW_STATE_NORMAL = 0,
-        FLOW_STATE_NEED_CONTINUE, // tell the caller need to consume a continue
-        FLOW_STATE_NEED_BREAK, // tell the caller need to consume a break
-        FLOW_STATE_NEED_RETURN // tell the caller need to consume a return
+    std::pmr::vector<ExecutionFrame> _frame_stack{&_frame_resource};
+    // the values of the o-call params, reused by each call to keep its capacity,
+    // an expression can not call a sub, so the calls never nest while filling it
+    std::pmr::vector<double> _call_param_value_list{_memory_resource};
+    bool _is_started = false; // if the program body has been pushed
+    std::size_t _step_command_count = 0; // commands produced in the current step()
+    std::size_t _command_count = 0; // commands produced since the program start
+    bool _is_fast_forwarding = false; // if the produced commands are dropped by restartFromCommand()
+
+    std::size_t _checkpoint_interval = 0;
+    std::pmr::vector<Checkpoint> _checkpoint_list{_memory_resource}; // ordered by command_count
+
+    // the budget usage of the current run
+    struct ExecutionUsage {
+        std::size_t statements = 0;
+        std::size_t commands = 0;
+        std::size_t call_depth = 0;
+        std::size_t loop_iterations = 0;
+        std::size_t check_count = 0; // the wall clock is read every kClockCheckInterval checks
+        std::chrono::steady_clock::duration elapsed{0}; // the time spent in the previous calls of the run
+        std::chrono::steady_clock::time_point deadline; // of the current call
     };
 
-    FlowState _current_flow_state = FlowState::FLOW_STATE_NORMAL;
-    AstObject _current_flow_control_statement;
+    ExecutionBudget _execution_budget;
+    ExecutionUsage _execution_usage;
+
+    ExecutionProfiler::ptr _profiler;
+
+    SerializerStats _stats;
+    SerializerStats _published_stats; // the _stats added to the GlobalStats
 
 private:
-    std::list<CommandStatement> _command_statement_list;
+    CommandListSink::ptr _command_list_sink = std::make_shared<CommandListSink>(_memory_resource);
+    CommandSink::ptr _command_sink = _command_list_sink;
 
 private:
-    inline static std::size_t _s_max_loop_times = 1000;
     inline static double _s_double_to_integer_tolerance = 1e-6;
 };
 
+extern template class BasicSerializer<StrictDialect>;
+extern template class BasicSerializer<LenientDialect>;
+
+using Serializer = BasicSerializer<StrictDialect>;
+using LenientSerializer = BasicSerializer<LenientDialect>;
+
 } // namespace rs274letter
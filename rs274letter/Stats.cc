@@ -0,0 +1,153 @@
+// Stats.cc
+#include "Stats.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace rs274letter
+{
+
+// the totals of GlobalStats, in the order of the fields
+static std::atomic<std::uint64_t> s_parser_total_list[5];
+static std::atomic<std::uint64_t> s_serializer_total_list[8];
+
+static void _add(std::atomic<std::uint64_t>& total, std::uint64_t value) {
+    if (value != 0) total.fetch_add(value, std::memory_order_relaxed);
+}
+
+static std::uint64_t _get(const std::atomic<std::uint64_t>& total) {
+    return total.load(std::memory_order_relaxed);
+}
+
+void GlobalStats::Add(const ParserStats& stats)
+{
+    _add(s_parser_total_list[0], stats.programs);
+    _add(s_parser_total_list[1], stats.statements);
+    _add(s_parser_total_list[2], stats.tokens);
+    _add(s_parser_total_list[3], stats.lines);
+    _add(s_parser_total_list[4], stats.bytes);
+}
+
+void GlobalStats::Add(const SerializerStats& stats)
+{
+    _add(s_serializer_total_list[0], stats.programs);
+    _add(s_serializer_total_list[1], stats.statements);
+    _add(s_serializer_total_list[2], stats.expressions);
+    _add(s_serializer_total_list[3], stats.variable_reads);
+    _add(s_serializer_total_list[4], stats.variable_writes);
+    _add(s_serializer_total_list[5], stats.o_calls);
+    _add(s_serializer_total_list[6], stats.loop_iterations);
+    _add(s_serializer_total_list[7], stats.commands);
+}
+
+GlobalStats::Snapshot GlobalStats::Get()
+{
+    Snapshot snapshot;
+    snapshot.parser.programs = _get(s_parser_total_list[0]);
+    snapshot.parser.statements = _get(s_parser_total_list[1]);
+    snapshot.parser.tokens = _get(s_parser_total_list[2]);
+    snapshot.parser.lines = _get(s_parser_total_list[3]);
+    snapshot.parser.bytes = _get(s_parser_total_list[4]);
+
+    snapshot.serializer.programs = _get(s_serializer_total_list[0]);
+    snapshot.serializer.statements = _get(s_serializer_total_list[1]);
+    snapshot.serializer.expressions = _get(s_serializer_total_list[2]);
+    snapshot.serializer.variable_reads = _get(s_serializer_total_list[3]);
+    snapshot.serializer.variable_writes = _get(s_serializer_total_list[4]);
+    snapshot.serializer.o_calls = _get(s_serializer_total_list[5]);
+    snapshot.serializer.loop_iterations = _get(s_serializer_total_list[6]);
+    snapshot.serializer.commands = _get(s_serializer_total_list[7]);
+    return snapshot;
+}
+
+void GlobalStats::Reset()
+{
+    for (auto& total : s_parser_total_list) total.store(0, std::memory_order_relaxed);
+    for (auto& total : s_serializer_total_list) total.store(0, std::memory_order_relaxed);
+}
+
+std::string GlobalStats::ToPrometheusText()
+{
+    auto snapshot = Get();
+
+    std::stringstream ss;
+    auto counter = [&ss](const char* name, const char* help, std::uint64_t value) {
+        ss << "# HELP rs274letter_" << name << " " << help << "\n"
+           << "# TYPE rs274letter_" << name << " counter\n"
+           << "rs274letter_" << name << " " << value << "\n";
+    };
+
+    counter("parsed_programs_total", "Programs parsed.", snapshot.parser.programs);
+    counter("parsed_statements_total", "Statements parsed.", snapshot.parser.statements);
+    counter("tokens_total", "Tokens read by the parsers.", snapshot.parser.tokens);
+    counter("source_lines_total", "Source lines parsed.", snapshot.parser.lines);
+    counter("source_bytes_total", "Source bytes parsed.", snapshot.parser.bytes);
+
+    counter("executed_programs_total", "Programs executed to the end.", snapshot.serializer.programs);
+    counter("executed_statements_total", "Statements executed.", snapshot.serializer.statements);
+    counter("expressions_evaluated_total", "Expression nodes evaluated.", snapshot.serializer.expressions);
+    counter("variable_reads_total", "Variables read by expressions.", snapshot.serializer.variable_reads);
+    counter("variable_writes_total", "Variables assigned by expressions.", snapshot.serializer.variable_writes);
+    counter("o_calls_total", "Subs called.", snapshot.serializer.o_calls);
+    counter("loop_iterations_total", "Iterations of while and repeat loops.", snapshot.serializer.loop_iterations);
+    counter("commands_total", "Commands sent to the command sinks.", snapshot.serializer.commands);
+
+    return ss.str();
+}
+
+bool GlobalStats::WritePrometheusFile(const std::string& path)
+{
+    auto tmp_path = path + ".tmp";
+    {
+        std::ofstream ofs(tmp_path, std::ios::trunc);
+        if (!ofs.is_open()) return false;
+        ofs << ToPrometheusText();
+        if (!ofs.flush()) return false;
+    }
+    return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+StatsFileExporter::StatsFileExporter(const std::string& path, std::chrono::milliseconds interval)
+    : _path(path), _interval(interval), _thread(&StatsFileExporter::run, this)
+{
+}
+
+StatsFileExporter::~StatsFileExporter()
+{
+    this->stop();
+}
+
+void StatsFileExporter::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_stopping = true;
+    }
+    this->_cv.notify_all();
+
+    if (this->_thread.joinable()) {
+        this->_thread.join();
+    }
+}
+
+void StatsFileExporter::run()
+{
+    std::unique_lock<std::mutex> lock(this->_mutex);
+    while (true) {
+        bool stopping = this->_cv.wait_for(lock, this->_interval, [this]() { return this->_stopping; });
+
+        // write without the lock, stop() does not wait for the file
+        lock.unlock();
+        if (GlobalStats::WritePrometheusFile(this->_path)) {
+            this->_write_count.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            this->_failure_count.fetch_add(1, std::memory_order_relaxed);
+        }
+        lock.lock();
+
+        if (stopping) return;
+    }
+}
+
+} // namespace rs274letter
@@ -0,0 +1,133 @@
+// Stats.h
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace rs274letter
+{
+
+/**
+ * TokenizerStats
+ * The counters of one Tokenizer, see `Tokenizer::getStats()`.
+*/
+struct TokenizerStats {
+    std::uint64_t tokens = 0; // returned tokens, without the skipped spaces and comments
+    std::uint64_t lines = 0; // source lines started
+    std::uint64_t bytes = 0; // source bytes read
+};
+
+/**
+ * ParserStats
+ * The counters of one `Parser::parse()`, including its tokenizer.
+*/
+struct ParserStats {
+    std::uint64_t programs = 0;
+    std::uint64_t statements = 0; // in all the statement lists
+    std::uint64_t tokens = 0;
+    std::uint64_t lines = 0;
+    std::uint64_t bytes = 0;
+};
+
+/**
+ * SerializerStats
+ * The counters of one Serializer, over all the programs it executes until
+ * `resetStats()`, see `Serializer::getStats()`.
+*/
+struct SerializerStats {
+    std::uint64_t programs = 0; // executed to the end
+    std::uint64_t statements = 0;
+    std::uint64_t expressions = 0; // expression nodes evaluated
+    std::uint64_t variable_reads = 0; // variables read by the expressions
+    std::uint64_t variable_writes = 0; // variables assigned by the expressions
+    std::uint64_t o_calls = 0;
+    std::uint64_t loop_iterations = 0; // of the while and repeat loops
+    std::uint64_t commands = 0; // sent to the command sink
+};
+
+/**
+ * GlobalStats
+ * The totals of the process: each Parser::parse() adds its ParserStats at
+ * its end, each Serializer adds the change of its SerializerStats at the
+ * end of each step(). The totals are relaxed atomics, so adding costs a few
+ * atomic additions for each parse or step and none for each statement.
+*/
+class GlobalStats {
+public:
+    struct Snapshot {
+        ParserStats parser;
+        SerializerStats serializer;
+    };
+
+    static void Add(const ParserStats& stats);
+    static void Add(const SerializerStats& stats);
+
+    static Snapshot Get();
+
+    // set all the totals to 0
+    static void Reset();
+
+    /**
+     * ToPrometheusText()
+     * the totals as counters in the Prometheus text exposition format,
+     * like `rs274letter_tokens_total 1234`
+    */
+    static std::string ToPrometheusText();
+
+    /**
+     * WritePrometheusFile()
+     * write ToPrometheusText() to `path.tmp` and rename it to `path`, so a
+     * reader like the textfile collector of node_exporter never sees a partial file
+     * @return false if the file could not be written
+    */
+    static bool WritePrometheusFile(const std::string& path);
+
+private:
+    GlobalStats() = delete;
+};
+
+/**
+ * StatsFileExporter
+ * Writes the GlobalStats to a Prometheus text file every `interval` on its
+ * own thread, and once more when it is stopped or destructed.
+ *  auto exporter = std::make_unique<StatsFileExporter>(
+ *      "/var/lib/node_exporter/textfile_collector/rs274letter.prom", std::chrono::seconds(15));
+*/
+class StatsFileExporter {
+public:
+    StatsFileExporter(const std::string& path, std::chrono::milliseconds interval);
+    ~StatsFileExporter();
+
+    StatsFileExporter(const StatsFileExporter&) = delete;
+    StatsFileExporter& operator=(const StatsFileExporter&) = delete;
+
+    // stop the thread after a last write, called by the destructor
+    void stop();
+
+    // the files written, and the writes failed
+    inline std::uint64_t getWriteCount() const { return this->_write_count.load(std::memory_order_relaxed); }
+    inline std::uint64_t getFailureCount() const { return this->_failure_count.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+private:
+    std::string _path;
+    std::chrono::milliseconds _interval;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    bool _stopping = false;
+
+    std::atomic<std::uint64_t> _write_count{0};
+    std::atomic<std::uint64_t> _failure_count{0};
+
+    std::thread _thread; // the last member, started after the others are constructed
+};
+
+} // namespace rs274letter
@@ -4,6 +4,7 @@
 #include "Exception.h" // Define Exception
 #include "macro.h"
 
+#include <atomic>
 #include <regex> // c++ regex library
 #include <optional> // optional value support
 #include <vector>
@@ -15,6 +16,8 @@
 namespace rs274letter
 {
 
+static std::atomic<bool> s_print_comments{true};
+
 Tokenizer::Tokenizer(const std::string::const_iterator& beg, const std::string::const_iterator& end) noexcept {
     this->_cur = beg;
     this->_end = end;
@@ -34,10 +37,8 @@ static const std::vector<std::tuple<std::string, std::regex, TokenType>> s_spec_
     // Return
     XX(R"(^\n)", "RTN"),         // return, designed to use for line number calculation
 
-    // NULL Tokens
-    XX(R"(^[ \t]+)", "NULL"),          // spaces and tabs, excluding \n
-    XX(R"(^\(.*\))", "CMT()"),  // comment like : ( xxx )
-    XX(R"(^;.*)", "CMT;"),      // comment like : ; abc 
+    // NULL Tokens: spaces and tabs "NULL", comments "CMT()" and "CMT;",
+    // matched without regex by _match_skipped_token(), see below
     
     // Control Flow
     // should be above LETTER
@@ -130,19 +131,56 @@ static std::optional<TokenValue> _match_regex(const std::regex &pattern,
                                               const std::string::const_iterator &beg,
                                               const std::string::const_iterator &end)
 {
+    // all the patterns start with `^`, match_continuous stops the search at `beg`
+    // instead of scanning the rest of the code for each failed pattern
     std::smatch m;
-    if (std::regex_search(beg, end, m, pattern)) {
+    if (std::regex_search(beg, end, m, pattern, std::regex_constants::match_continuous)) {
         return m[0].str();
     } else {
         return std::nullopt;
     }
 }
 
-static bool _should_skip_token_type(const TokenType& type) {
-    return type == "NULL" 
-        // || type == "RTN" // RETURN should be used to seperate normal statement line
-        || type == "CMT;"
-        || type == "CMT()";
+/**
+ * _match_skipped_token()
+ *  Match the spaces and tabs ("NULL") and the comments ("CMT()", "CMT;")
+ *  at `beg`, like the regexes `^[ \t]+`, `^\(.*\)` and `^;.*` would do,
+ *  return the length of the match, 0 if not matched.
+ *  These have no length limit, and the std::regex of libstdc++ recurses
+ *  once for each matched char, so a long comment line exhausted the stack.
+ */
+static std::size_t _match_skipped_token(const std::string::const_iterator &beg,
+                                        const std::string::const_iterator &end,
+                                        TokenType &token_type)
+{
+    // `.` of the ECMAScript regex does not match the line terminators
+    auto is_line_end = [](char c) { return c == '\n' || c == '\r'; };
+
+    auto it = beg;
+    if (*it == ' ' || *it == '\t') {
+        while (it != end && (*it == ' ' || *it == '\t')) ++it;
+        token_type = "NULL";
+        return it - beg;
+    }
+
+    if (*it == '(') {
+        // greedy, until the last ')' of the line
+        auto close = end;
+        for (++it; it != end && !is_line_end(*it); ++it) {
+            if (*it == ')') close = it;
+        }
+        if (close == end) return 0;
+        token_type = "CMT()";
+        return close + 1 - beg;
+    }
+
+    if (*it == ';') {
+        while (it != end && !is_line_end(*it)) ++it;
+        token_type = "CMT;";
+        return it - beg;
+    }
+
+    return 0;
 }
 
 Token Tokenizer::getNextToken() {
@@ -165,22 +203,48 @@ Token Tokenizer::getNextToken() {
 
     // return next_token;
 
-    if (!this->hasMoreTokens()) {
-        return {};
-    }
+    // the skipped tokens are passed over by this loop, not recursively,
+    // a line of many comments would exhaust the stack
+    while (this->hasMoreTokens()) {
+        TokenType skipped_type;
+        auto skipped_size = _match_skipped_token(_cur, _end, skipped_type);
+        if (skipped_size > 0) {
+#ifdef COMMENT_STDOUT_OUTPUT
+            if ((skipped_type == "CMT;" || skipped_type == "CMT()")
+                && s_print_comments.load(std::memory_order_relaxed)) {
+                std::cout << this->_cur_line << "\t[COMMENT]: " << std::string(_cur, _cur + skipped_size) << std::endl;
+            }
+#endif // COMMENT_STDOUT_OUTPUT
 
-    for (auto&& [raw_pattern_str, pattern, token_type] : s_spec_vec) {
-        auto&& token_value_opt = _match_regex(pattern, _cur, _end);
-        if (!token_value_opt) {
-            continue; // current pattern match failed, continue match next pattern defined in the `s_spec_vec`
+            this->_cur += skipped_size;
+            this->_cur_col += skipped_size;
+            this->_stats.bytes += skipped_size;
+            continue;
         }
 
-        // matched, token_value_opt != std::nullopt
+        // the regexes only see kMaxTokenLength + 1 chars, see _match_skipped_token(),
+        // a match of the whole window is a token longer than kMaxTokenLength
+        auto window_end = _end - _cur > static_cast<std::ptrdiff_t>(kMaxTokenLength + 1)
+            ? _cur + kMaxTokenLength + 1 : _end;
+
+        for (auto&& [raw_pattern_str, pattern, token_type] : s_spec_vec) {
+            auto&& token_value_opt = _match_regex(pattern, _cur, window_end);
+            if (!token_value_opt) {
+                continue; // current pattern match failed, continue match next pattern defined in the `s_spec_vec`
+            }
 
-        auto&& token_value = token_value_opt.value();
+            // matched, token_value_opt != std::nullopt
+
+            auto&& token_value = token_value_opt.value();
+
+            if (window_end != _end && token_value.size() > kMaxTokenLength) {
+                std::stringstream ss;
+                ss << "Token longer than " << kMaxTokenLength << " chars: \"" << token_value.substr(0, 32) << "...\"\n"
+                   << this->getLineColumnShowString();
+                throw Exception(ss.str());
+            }
         
 #ifdef TOKEN_DEBUG_OUTPUT
-        if (token_type != "NULL")
             std::cout << "\t[DEBUG]: " 
                 // << "Match regex: " << "\033[33m" << raw_pattern_str  << "\033[0m"
                 << "\ttype: " << "\033[32m" << token_type << "\033[0m"
@@ -188,36 +252,30 @@ Token Tokenizer::getNextToken() {
                 << std::endl;
 #endif // TOKEN_DEBUG_OUTPUT
 
-        this->_cur += token_value.size(); // set the cursor to the begin of the next possible token
-        this->_cur_col += token_value.size();
-
-        if (token_type == "RTN") {
-            ++(this->_cur_line);
-            this->_cur_col = 1;
-        }
-
-#ifdef COMMENT_STDOUT_OUTPUT
-
-        if (token_type == "CMT;" || token_type == "CMT()") {
-            std::cout << this->_cur_line << "\t[COMMENT]: " << token_value << std::endl;
+            this->_cur += token_value.size(); // set the cursor to the begin of the next possible token
+            this->_cur_col += token_value.size();
+            this->_stats.bytes += token_value.size();
+
+            if (token_type == "RTN") {
+                ++(this->_cur_line);
+                ++(this->_stats.lines);
+                this->_cur_col = 1;
+            }
+
+            ++(this->_stats.tokens);
+            return Token { // json::object
+                {"type", token_type},
+                {"value", token_value}
+            };
         }
 
-#endif // COMMENT_STDOUT_OUTPUT
-
-        if (_should_skip_token_type(token_type)) {
-            return this->getNextToken(); // skip "null" token, give the next none-"null" token, recursively
-        }
-
-        return Token { // json::object
-            {"type", token_type},
-            {"value", token_value}
-        };
+        std::stringstream ss;
+        ss << "Unexpected token(char): \"" << (*this->_cur) << "\"\n"
+           << this->getLineColumnShowString();
+        throw Exception(ss.str());
     }
 
-    std::stringstream ss;
-    ss << "Unexpected token(char): \"" << (*this->_cur) << "\"\n"
-       << this->getLineColumnShowString();
-    throw Exception(ss.str());
+    return {};
 }
 
 // std::vector<Token> Tokenizer::lookAheadTokens(size_t token_num) const {
@@ -258,6 +316,10 @@ bool Tokenizer::IsTokenType(const Token &token, const TokenType &token_type)
     return (t.value() == token_type);
 }
 
+void Tokenizer::SetPrintComments(bool print_comments) {
+    s_print_comments.store(print_comments, std::memory_order_relaxed);
+}
+
 TokenType Tokenizer::GetTokenType(const Token& token) {
     return token.at("type").as_string();
 }
@@ -3,6 +3,8 @@
 
 #include "json.hpp"
 
+#include "Stats.h"
+
 #include <string>
 
 namespace rs274letter
@@ -22,6 +24,14 @@ using TokenValue = std::string; // value of a `Token`: "123", "abc", etc.
 
 class Tokenizer {
 public:
+    /**
+     * kMaxTokenLength
+     * The longest token, except the spaces and the comments which have no limit.
+     * The std::regex recursion grows with the length of the match, a longer
+     * token throws an Exception instead of exhausting the stack.
+    */
+    static constexpr std::size_t kMaxTokenLength = 256;
+
     /**
      * Constructor, disable default construct
      * We DO NOT store string in this class, to avoid the copy
@@ -37,7 +47,7 @@ public:
 
     /**
      * getNextToken()
-     * Get the next token.
+     * Get the next token, the spaces and the comments are skipped.
      * Side Effects: _cur and _cur_line may change.
      */
     Token getNextToken();
@@ -72,6 +82,17 @@ public:
 
     // inline void setCurLine(std::size_t line) { _cur_line = line; } 
 
+    /**
+     * getStats()
+     * Return the tokens, lines and bytes read until now, the skipped spaces
+     * and comments are not counted as tokens. A line is counted once it is started.
+    */
+    inline TokenizerStats getStats() const {
+        auto stats = _stats;
+        if (_cur_col > 1) ++stats.lines; // the last line without a '\n'
+        return stats;
+    }
+
     /**
      * IsTokenType()
      * Return True if token's type equals to token_type
@@ -85,6 +106,14 @@ public:
     */
     static TokenType GetTokenType(const Token& token);
 
+    /**
+     * SetPrintComments()
+     * The comments are printed to std::cout while tokenizing, turn it off for
+     * all the Tokenizers when std::cout carries other output, or when many
+     * threads parse at once
+    */
+    static void SetPrintComments(bool print_comments);
+
     /**
      * GetTokenTypeValueShowString()
      * Return a string to show the type and value of a token
@@ -107,6 +136,9 @@ private:
     std::string::const_iterator _end;
     std::size_t _cur_line{1};
     std::size_t _cur_col{1};
+
+    // lines counts the '\n' read
+    TokenizerStats _stats;
 };
 
 } // namespace rs274letter
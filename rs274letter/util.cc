@@ -1,5 +1,11 @@
 #include "util.h"
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
 #if (defined (__unix__)) && (!defined (_WIN32))
 #include <unistd.h>
 #include <sys/types.h>
@@ -65,5 +71,185 @@ std::string BacktraceToString(int size, int skip, const std::string& prefix) {
     return ss.str();
 }
 
+/**
+ * TraceBuffer
+ * The ring buffer of one thread. It is kept by the registry after the thread
+ * exits, so the spans of the joined threads are still exported.
+*/
+struct TraceBuffer {
+    std::vector<Trace::Event> event_list; // the ring, allocated at the first record
+    std::size_t next_index = 0;
+    std::uint64_t record_count = 0;
+    std::size_t capacity = Trace::kDefaultBufferCapacity;
+    std::uint32_t tid = 0;
+    std::string thread_name;
+};
+
+static std::mutex s_trace_registry_mutex;
+static std::vector<std::shared_ptr<TraceBuffer>> s_trace_buffer_list;
+static std::size_t s_trace_buffer_capacity = Trace::kDefaultBufferCapacity;
+static std::atomic<std::uint64_t> s_trace_epoch_ns{0};
+
+static TraceBuffer& _this_thread_trace_buffer() {
+    thread_local std::shared_ptr<TraceBuffer> t_buffer;
+    if (!t_buffer) {
+        t_buffer = std::make_shared<TraceBuffer>();
+
+        std::lock_guard<std::mutex> lock(s_trace_registry_mutex);
+        t_buffer->capacity = s_trace_buffer_capacity;
+        t_buffer->tid = static_cast<std::uint32_t>(s_trace_buffer_list.size() + 1);
+        s_trace_buffer_list.push_back(t_buffer);
+    }
+    return *t_buffer;
+}
+
+void Trace::Enable(std::uint32_t categories/* = DEFAULT_CATEGORIES*/) {
+    // the timestamps in the trace start at the first Enable()
+    std::uint64_t expected = 0;
+    s_trace_epoch_ns.compare_exchange_strong(expected, NowNs());
+
+    s_categories.store(categories, std::memory_order_relaxed);
+}
+
+void Trace::Record(const char* name, std::uint32_t category, std::uint64_t begin_ns, std::uint64_t end_ns,
+    const std::string& detail/* = std::string()*/) {
+    auto& buffer = _this_thread_trace_buffer();
+    if (buffer.event_list.empty()) {
+        buffer.event_list.resize(std::max<std::size_t>(buffer.capacity, 1));
+    }
+
+    auto& event = buffer.event_list[buffer.next_index];
+    event.name = name;
+    event.category = category;
+    auto detail_size = std::min(detail.size(), kDetailSize - 1);
+    std::memcpy(event.detail, detail.data(), detail_size);
+    event.detail[detail_size] = '\0';
+    event.begin_ns = begin_ns;
+    event.end_ns = end_ns;
+
+    if (++buffer.next_index == buffer.event_list.size()) {
+        buffer.next_index = 0;
+    }
+    ++buffer.record_count;
+}
+
+void Trace::SetThreadName(const std::string& name) {
+    auto& buffer = _this_thread_trace_buffer();
+    std::lock_guard<std::mutex> lock(s_trace_registry_mutex);
+    buffer.thread_name = name;
+}
+
+void Trace::SetBufferCapacity(std::size_t events_per_thread) {
+    std::lock_guard<std::mutex> lock(s_trace_registry_mutex);
+    s_trace_buffer_capacity = std::max<std::size_t>(events_per_thread, 1);
+}
+
+void Trace::Clear() {
+    std::lock_guard<std::mutex> lock(s_trace_registry_mutex);
+    for (auto&& buffer : s_trace_buffer_list) {
+        buffer->next_index = 0;
+        buffer->record_count = 0;
+    }
+}
+
+std::uint64_t Trace::GetDroppedCount() {
+    std::lock_guard<std::mutex> lock(s_trace_registry_mutex);
+    std::uint64_t dropped = 0;
+    for (auto&& buffer : s_trace_buffer_list) {
+        if (buffer->record_count > buffer->event_list.size()) {
+            dropped += buffer->record_count - buffer->event_list.size();
+        }
+    }
+    return dropped;
+}
+
+std::size_t Trace::GetEventCount() {
+    std::lock_guard<std::mutex> lock(s_trace_registry_mutex);
+    std::size_t count = 0;
+    for (auto&& buffer : s_trace_buffer_list) {
+        count += static_cast<std::size_t>(std::min<std::uint64_t>(buffer->record_count, buffer->event_list.size()));
+    }
+    return count;
+}
+
+static void _write_json_string(std::ostream& out, const char* str) {
+    out << '"';
+    for (; *str; ++str) {
+        auto c = *str;
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+static const char* _trace_category_name(std::uint32_t category) {
+    switch (category) {
+    case Trace::PHASE: return "phase";
+    case Trace::CALL: return "call";
+    case Trace::SINK: return "sink";
+    case Trace::TOKEN: return "token";
+    default: return "other";
+    }
+}
+
+void Trace::WriteChromeTrace(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(s_trace_registry_mutex);
+
+    auto epoch_ns = s_trace_epoch_ns.load();
+    // microseconds with the nanoseconds as decimals
+    auto write_us = [&out](std::uint64_t ns) {
+        out << ns / 1000 << '.' << static_cast<char>('0' + ns / 100 % 10)
+            << static_cast<char>('0' + ns / 10 % 10) << static_cast<char>('0' + ns % 10);
+    };
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for (auto&& buffer : s_trace_buffer_list) {
+        if (!buffer->thread_name.empty()) {
+            out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                << buffer->tid << ",\"args\":{\"name\":";
+            _write_json_string(out, buffer->thread_name.c_str());
+            out << "}}";
+            first = false;
+        }
+
+        // the oldest event is at next_index once the ring is full
+        auto size = static_cast<std::size_t>(std::min<std::uint64_t>(buffer->record_count, buffer->event_list.size()));
+        auto start = buffer->record_count > buffer->event_list.size() ? buffer->next_index : 0;
+        for (std::size_t i = 0; i < size; ++i) {
+            auto&& event = buffer->event_list[(start + i) % buffer->event_list.size()];
+            auto begin_ns = event.begin_ns > epoch_ns ? event.begin_ns - epoch_ns : 0;
+            auto end_ns = event.end_ns > event.begin_ns ? event.end_ns - event.begin_ns : 0;
+
+            out << (first ? "" : ",") << "\n{\"name\":";
+            _write_json_string(out, event.name);
+            out << ",\"cat\":\"" << _trace_category_name(event.category) << "\",\"ph\":\"X\",\"ts\":";
+            write_us(begin_ns);
+            out << ",\"dur\":";
+            write_us(end_ns);
+            out << ",\"pid\":1,\"tid\":" << buffer->tid;
+            if (event.detail[0] != '\0') {
+                out << ",\"args\":{\"detail\":";
+                _write_json_string(out, event.detail);
+                out << "}";
+            }
+            out << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+}
+
+std::string Trace::ToChromeTrace() {
+    std::stringstream ss;
+    WriteChromeTrace(ss);
+    return ss.str();
+}
+
 } // namespace util
 } // namespace rs274letter
@@ -2,7 +2,9 @@
 
 #include <string>
 #include <vector>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <type_traits>
 #include <iostream>
 
@@ -53,5 +55,125 @@ public:
     }
 };
 
+/**
+ * Trace
+ * Records nested spans of the pipeline, each thread into its own ring buffer,
+ * and exports them as Chrome trace-event JSON, which can be opened in
+ * Perfetto (ui.perfetto.dev) or chrome://tracing.
+ *  - A span is recorded by a `TraceScope`, or by `Record()` for a span which
+ *    is not a C++ scope, like an o-call, from the call to the return.
+ *  - The spans are grouped into categories, enabled by `Enable()`. While a
+ *    category is disabled its TraceScope only loads an atomic flag.
+ *  - Recording a span writes one Event into the ring buffer of the thread,
+ *    without any lock. A full ring buffer overwrites its oldest events.
+ *  - The spans recorded by the library:
+ *      PHASE: "parse", "compile", "validate", "link", "execute" (each step())
+ *      CALL:  "o-call", from the call to the return, with the o-word as detail
+ *      SINK:  "flush", the flush of the CommandSink at the end of the program
+ *      TOKEN: "tokenize", each token read by the Parser, off by default
+ *      as it records a span for each token
+ * Export or Clear() only while no thread records, like after joining them.
+*/
+class Trace {
+public:
+    enum Category : std::uint32_t {
+        PHASE = 1u << 0,
+        CALL = 1u << 1,
+        SINK = 1u << 2,
+        TOKEN = 1u << 3,
+        DEFAULT_CATEGORIES = PHASE | CALL | SINK,
+        ALL_CATEGORIES = 0xffffffffu
+    };
+
+    static constexpr std::size_t kDetailSize = 32;
+    static constexpr std::size_t kDefaultBufferCapacity = 1 << 16;
+
+    struct Event {
+        const char* name; // a string literal
+        std::uint32_t category;
+        char detail[kDetailSize]; // truncated, '\0' terminated
+        std::uint64_t begin_ns;
+        std::uint64_t end_ns;
+    };
+
+    static void Enable(std::uint32_t categories = DEFAULT_CATEGORIES);
+    static void Disable() { s_categories.store(0, std::memory_order_relaxed); }
+
+    static bool IsEnabled(std::uint32_t category) {
+        return (s_categories.load(std::memory_order_relaxed) & category) != 0;
+    }
+
+    // steady clock, never 0
+    static std::uint64_t NowNs() {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count()) | 1;
+    }
+
+    /**
+     * Record()
+     * record a span into the ring buffer of this thread
+     * @param name a string literal, it is not copied
+     * @param detail copied, truncated to kDetailSize - 1 chars
+    */
+    static void Record(const char* name, std::uint32_t category, std::uint64_t begin_ns, std::uint64_t end_ns,
+        const std::string& detail = std::string());
+
+    // the name of this thread in the trace
+    static void SetThreadName(const std::string& name);
+
+    // the capacity in events of the ring buffers created after, each thread creates its
+    // ring buffer at its first record
+    static void SetBufferCapacity(std::size_t events_per_thread);
+
+    // drop the recorded events of all threads
+    static void Clear();
+
+    // the events overwritten in the full ring buffers since the last Clear()
+    static std::uint64_t GetDroppedCount();
+
+    // the events kept in the ring buffers of all threads
+    static std::size_t GetEventCount();
+
+    static void WriteChromeTrace(std::ostream& out);
+    static std::string ToChromeTrace();
+
+private:
+    inline static std::atomic<std::uint32_t> s_categories{0};
+};
+
+/**
+ * TraceScope
+ * Records a span from its construction to its destruction, if its category
+ * is enabled at the construction.
+*/
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, std::uint32_t category = Trace::PHASE) noexcept
+        : _name(name), _category(category), _begin_ns(Trace::IsEnabled(category) ? Trace::NowNs() : 0) {}
+
+    ~TraceScope() {
+        if (_begin_ns) Trace::Record(_name, _category, _begin_ns, Trace::NowNs());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* _name;
+    std::uint32_t _category;
+    std::uint64_t _begin_ns;
+};
+
+/**
+ * NullBuffer
+ * A streambuf discarding all its output. The library prints the comments
+ * and the backtraces of the errors to std::cout, swap this in with
+ * `std::cout.rdbuf(&null_buffer)` to silence them.
+*/
+struct NullBuffer : std::streambuf {
+    int overflow(int c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
 } // namespace util
 } // namespace rs274letter 
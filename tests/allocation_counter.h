@@ -0,0 +1,153 @@
+// allocation_counter.h
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <malloc.h> // malloc_usable_size
+#endif
+
+// Replaces the global operator new and delete with versions counting the
+// heap allocations of the whole program, for the allocation tests and
+// benchmarks. Include it in exactly one source file of an executable.
+//  rs274letter::test::AllocationScope scope;
+//  ...
+//  scope.getCount(); // the allocations since the scope started
+// With glibc the bytes in use and their peak are also tracked, by the
+// usable size of each block, elsewhere they stay 0.
+
+namespace rs274letter::test
+{
+
+inline std::atomic<std::size_t> s_allocation_count{0};
+inline std::atomic<std::size_t> s_allocation_bytes{0};
+inline std::atomic<std::size_t> s_live_bytes{0};
+inline std::atomic<std::size_t> s_peak_live_bytes{0};
+
+/**
+ * AllocationScope
+ * The allocations (of all threads) since the construction or restart().
+*/
+class AllocationScope {
+public:
+    AllocationScope() noexcept { this->restart(); }
+
+    inline void restart() noexcept {
+        this->_count_start = s_allocation_count.load(std::memory_order_relaxed);
+        this->_bytes_start = s_allocation_bytes.load(std::memory_order_relaxed);
+    }
+
+    inline std::size_t getCount() const noexcept {
+        return s_allocation_count.load(std::memory_order_relaxed) - this->_count_start;
+    }
+
+    inline std::size_t getBytes() const noexcept {
+        return s_allocation_bytes.load(std::memory_order_relaxed) - this->_bytes_start;
+    }
+
+private:
+    std::size_t _count_start = 0;
+    std::size_t _bytes_start = 0;
+};
+
+// the allocations since the program start
+inline std::size_t GetAllocationCount() noexcept {
+    return s_allocation_count.load(std::memory_order_relaxed);
+}
+
+// the heap bytes in use now
+inline std::size_t GetLiveBytes() noexcept {
+    return s_live_bytes.load(std::memory_order_relaxed);
+}
+
+// the most heap bytes in use since the program start or RestartPeakLiveBytes()
+inline std::size_t GetPeakLiveBytes() noexcept {
+    return s_peak_live_bytes.load(std::memory_order_relaxed);
+}
+
+// start a new peak from the bytes in use now, for all the threads
+inline void RestartPeakLiveBytes() noexcept {
+    s_peak_live_bytes.store(s_live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+inline void* CountAllocated(void* p, std::size_t size) noexcept {
+    s_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    s_allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+#if defined(__GLIBC__)
+    if (p) {
+        auto usable_size = malloc_usable_size(p);
+        auto live = s_live_bytes.fetch_add(usable_size, std::memory_order_relaxed) + usable_size;
+        auto peak = s_peak_live_bytes.load(std::memory_order_relaxed);
+        while (live > peak && !s_peak_live_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    }
+#endif
+    return p;
+}
+
+inline void* CountedAllocate(std::size_t size) noexcept {
+    return CountAllocated(std::malloc(size ? size : 1), size);
+}
+
+inline void* CountedAlignedAllocate(std::size_t size, std::size_t alignment) noexcept {
+    return CountAllocated(std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment), size);
+}
+
+inline void CountedFree(void* p) noexcept {
+#if defined(__GLIBC__)
+    if (p) s_live_bytes.fetch_sub(malloc_usable_size(p), std::memory_order_relaxed);
+#endif
+    std::free(p);
+}
+
+} // namespace rs274letter::test
+
+// gcc warns when it inlines a delete below (free) into a caller of a new
+// it does not inline, though both sides use malloc/free
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size) {
+    if (void* p = rs274letter::test::CountedAllocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    if (void* p = rs274letter::test::CountedAllocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return rs274letter::test::CountedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return rs274letter::test::CountedAllocate(size);
+}
+
+// the aligned forms, std::pmr::new_delete_resource() allocates with them
+void* operator new(std::size_t size, std::align_val_t align) {
+    if (void* p = rs274letter::test::CountedAlignedAllocate(size, static_cast<std::size_t>(align))) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return operator new(size, align);
+}
+
+void operator delete(void* p) noexcept { rs274letter::test::CountedFree(p); }
+void operator delete[](void* p) noexcept { rs274letter::test::CountedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { rs274letter::test::CountedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { rs274letter::test::CountedFree(p); }
+void operator delete(void* p, std::align_val_t) noexcept { rs274letter::test::CountedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { rs274letter::test::CountedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { rs274letter::test::CountedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { rs274letter::test::CountedFree(p); }
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
@@ -0,0 +1,21 @@
+// check.h
+#pragma once
+
+#include <iostream>
+#include <string>
+
+// The result line of a test case, "passed: <name>" or "FAILED: <name>",
+// returns the failures to add up:
+//  int failed = 0;
+//  failed += rs274letter::test::Check(x == 1, "x is 1");
+//  return failed == 0 ? 0 : 1;
+
+namespace rs274letter::test
+{
+
+inline int Check(bool passed, const std::string& name) {
+    std::cout << (passed ? "passed" : "FAILED") << ": " << name << std::endl;
+    return passed ? 0 : 1;
+}
+
+} // namespace rs274letter::test
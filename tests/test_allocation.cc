@@ -0,0 +1,167 @@
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+#include "rs274letter/Serializer.h"
+#include "rs274letter/Tokenizer.h"
+
+#include "allocation_counter.h"
+
+// Heap allocations per parsed line, per operator of a long expression and
+// per executed line.
+// The global operator new is replaced to count the allocations, the counts
+// are checked against upper bounds, so copies of AST subtrees can not creep
+// back into the Parser and the Serializer. Returns 1 if any bound is exceeded.
+// The allocations of the Tokenizer (mostly inside std::regex) are counted
+// apart, the Parser's own allocations are the rest of the parse.
+
+// upper bounds of the allocations, about 1.2 times the measured counts
+// (66 per token, 60 per line, 14 per operator of the long expression,
+// 0.30 per executed line)
+static const double s_max_tokenize_allocations_per_token = 80.0;
+static const double s_max_parse_allocations_per_line = 72.0;
+static const double s_max_parse_allocations_per_operator = 17.0;
+static const double s_max_execute_allocations_per_line = 0.36;
+
+// each iteration of the o1 loop executes 10 lines
+static const int s_iterations = 2000;
+static const int s_lines_per_iteration = 10;
+static const int s_straight_lines = 400;
+static const int s_long_expression_operators = 200;
+
+// a long expression, a copy of the left subtree for each operator
+// would make it quadratic
+static std::string make_long_expression() {
+    std::stringstream ss;
+    ss << "#<long> = [0";
+    for (int i = 0; i < s_long_expression_operators; ++i) {
+        ss << " + " << i;
+    }
+    ss << "]\n";
+    return ss.str();
+}
+
+static std::string make_program() {
+    std::stringstream ss;
+    ss << R"(
+        o<move> sub
+            G01 X[#1 * 0.5] Y[#2 + 1] F1000
+        o<move> endsub
+
+        #<i> = 0
+        #<sum> = 0
+        o1 while [#<i> LT )" << s_iterations << R"(]
+            #<i> = [#<i> + 1]
+            #<sum> = [#<sum> + sin[#<i>] * cos[#<i>]]
+            o2 if [#<i> GT 100 AND #<i> LT 200]
+                G00 Z[#<i> / 10]
+            o2 else
+                G01 X[#<i> * 0.1] Y-[#<i> * 0.2]
+            o2 endif
+            o<move> call [#<i>] [#<sum>]
+            #3 = [abs[#<sum>] + #<i> ** 2]
+        o1 endwhile
+    )";
+
+    // straight-line code, the most common shape of a real program
+    for (int i = 0; i < s_straight_lines / 2; ++i) {
+        ss << "G01 X" << i * 0.1 << " Y[" << i << " * 0.2] F[1000 + #<i>]\n";
+        ss << "#" << 100 + i % 50 << " = [#<sum> + " << i << "]\n";
+    }
+
+    ss << make_long_expression();
+
+    return ss.str();
+}
+
+// the allocations of tokenizing and of parsing the code, the second without the first
+static std::pair<std::size_t, std::size_t> count_parse_allocations(const std::string& code, std::size_t& token_count) {
+    auto count_before_tokenize = rs274letter::test::GetAllocationCount();
+    token_count = 0;
+    {
+        rs274letter::Tokenizer tokenizer(code.cbegin(), code.cend());
+        while (!tokenizer.getNextToken().empty()) ++token_count;
+    }
+    auto tokenize_allocations = rs274letter::test::GetAllocationCount() - count_before_tokenize;
+
+    // the Parser runs the same Tokenizer
+    auto count_before_parse = rs274letter::test::GetAllocationCount();
+    rs274letter::Parser::parse(code);
+    auto parse_allocations = rs274letter::test::GetAllocationCount() - count_before_parse - tokenize_allocations;
+
+    return { tokenize_allocations, parse_allocations };
+}
+
+static std::size_t count_lines(const std::string& code) {
+    std::size_t lines = 0;
+    for (auto c : code) {
+        if (c == '\n') ++lines;
+    }
+    return lines;
+}
+
+int main() {
+    try {
+        auto code = make_program();
+        auto source_lines = count_lines(code);
+
+        std::size_t token_count = 0;
+        auto [tokenize_allocations, parse_allocations] = count_parse_allocations(code, token_count);
+
+        std::size_t long_expression_token_count = 0;
+        auto long_expression_parse_allocations = count_parse_allocations(make_long_expression(),
+            long_expression_token_count).second;
+
+        // execute, without storing the commands
+        std::size_t command_count = 0;
+        auto sink = std::make_shared<rs274letter::CallbackCommandSink>(
+            [&command_count](const rs274letter::CommandStatement&) { ++command_count; });
+
+        rs274letter::ExecutionBudget budget;
+        budget.max_single_loop_iterations = 0;
+
+        rs274letter::Serializer s(rs274letter::Parser::parse(code));
+        s.setCommandSink(sink);
+        s.setExecutionBudget(budget);
+        s.link();
+
+        auto count_before_execute = rs274letter::test::GetAllocationCount();
+        s.processProgram();
+        auto execute_allocations = rs274letter::test::GetAllocationCount() - count_before_execute;
+
+        auto executed_lines = s_iterations * s_lines_per_iteration + 2 + s_straight_lines + 1;
+
+        double tokenize_per_token = static_cast<double>(tokenize_allocations) / token_count;
+        double parse_per_line = static_cast<double>(parse_allocations) / source_lines;
+        double execute_per_line = static_cast<double>(execute_allocations) / executed_lines;
+        double parse_per_operator = static_cast<double>(long_expression_parse_allocations) / s_long_expression_operators;
+
+        std::cout << "tokens: " << token_count
+                  << ", tokenize allocations: " << tokenize_allocations
+                  << ", per token: " << tokenize_per_token
+                  << " (max " << s_max_tokenize_allocations_per_token << ")" << std::endl;
+        std::cout << "source lines: " << source_lines
+                  << ", parse allocations: " << parse_allocations
+                  << ", per line: " << parse_per_line
+                  << " (max " << s_max_parse_allocations_per_line << ")" << std::endl;
+        std::cout << "long expression operators: " << s_long_expression_operators
+                  << ", parse allocations: " << long_expression_parse_allocations
+                  << ", per operator: " << parse_per_operator
+                  << " (max " << s_max_parse_allocations_per_operator << ")" << std::endl;
+        std::cout << "executed lines: " << executed_lines
+                  << ", commands: " << command_count
+                  << ", execute allocations: " << execute_allocations
+                  << ", per line: " << execute_per_line
+                  << " (max " << s_max_execute_allocations_per_line << ")" << std::endl;
+
+        bool passed = tokenize_per_token <= s_max_tokenize_allocations_per_token
+            && parse_per_line <= s_max_parse_allocations_per_line
+            && parse_per_operator <= s_max_parse_allocations_per_operator
+            && execute_per_line <= s_max_execute_allocations_per_line;
+        std::cout << (passed ? "passed" : "FAILED, allocation bound exceeded") << std::endl;
+        return passed ? 0 : 1;
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,203 @@
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tools/BatchRunner.h"
+#include "check.h"
+
+// The WorkStealingPool runs each task once and the idle workers steal, and
+// the BatchRunner checks a directory of programs: the results in the order
+// of the files, the errors of each phase, and the duplicates checked once,
+// not the files which only have the same hash and size. An exception of any
+// type fails its file only.
+
+using rs274letter::test::Check;
+using rs274letter::tools::BatchRunner;
+using rs274letter::tools::WorkStealingPool;
+
+static void write_file(const std::filesystem::path& path, const std::string& content) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream ofs(path, std::ios::binary);
+    ofs << content;
+}
+
+static int test_pool() {
+    int failed = 0;
+
+    std::vector<std::atomic<int>> run_count_list(10000);
+    {
+        WorkStealingPool pool(4);
+        for (auto&& run_count : run_count_list) {
+            pool.submit([&run_count]() { ++run_count; });
+        }
+        pool.wait();
+    }
+    bool once = true;
+    for (auto&& run_count : run_count_list) once = once && run_count == 1;
+    failed += Check(once, "each task runs once");
+
+    // one task queues all the others on its own worker, the idle workers steal them
+    WorkStealingPool pool(4);
+    std::atomic<int> done{0};
+    pool.submit([&]() {
+        for (int i = 0; i < 64; ++i) {
+            pool.submit([&done]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                ++done;
+            });
+        }
+    });
+    pool.wait();
+    failed += Check(done == 64 && pool.getStealCount() > 0,
+        "idle workers steal, steals: " + std::to_string(pool.getStealCount()));
+
+    return failed;
+}
+
+static int test_batch(const std::filesystem::path& dir) {
+    int failed = 0;
+
+    std::string valid = "#<x> = 1\nG01 X#<x> Y2\n";
+    write_file(dir / "a_valid.ngc", valid);
+    write_file(dir / "b_syntax_error.ngc", "G01 X[1 + \n");
+    write_file(dir / "c_undefined_sub.ngc", "o<missing> call\n");
+    write_file(dir / "d_undefined_variable.ngc", "G01 X#<nowhere>\n");
+    write_file(dir / "sub" / "e_copy.ngc", valid);
+    write_file(dir / "sub" / "f_loop.ngc", "#1 = 0\no1 while [#1 lt 10]\n    #1 = [#1 + 1]\n    G01 X#1\no1 endwhile\n");
+    write_file(dir / "notes.txt", "not a program");
+
+    auto file_list = BatchRunner::CollectFiles({dir.string()}, {".ngc"});
+    failed += Check(file_list.size() == 6, "6 programs collected, the .txt is not");
+
+    BatchRunner::Options options;
+    options.thread_count = 3;
+    options.execute = true;
+
+    std::vector<BatchRunner::FileResult> result_list;
+    BatchRunner runner(options);
+    auto summary = runner.run(file_list, [&](const BatchRunner::FileResult& result) {
+        result_list.push_back(result);
+    });
+
+    bool ordered = result_list.size() == file_list.size();
+    for (std::size_t i = 0; ordered && i < file_list.size(); ++i) {
+        ordered = result_list[i].file == file_list[i];
+    }
+    failed += Check(ordered, "the results in the order of the files");
+    if (!ordered) return failed + 1;
+
+    failed += Check(result_list[0].status == BatchRunner::OK && result_list[0].serializer_stats.commands == 1,
+        "a valid program");
+    failed += Check(result_list[1].status == BatchRunner::PARSE_ERROR && !result_list[1].error.empty(),
+        "a syntax error");
+    failed += Check(result_list[2].status == BatchRunner::COMPILE_ERROR, "a call to an undefined sub");
+    failed += Check(result_list[3].status == BatchRunner::EXECUTION_ERROR, "an undefined variable read");
+    failed += Check(result_list[4].status == BatchRunner::OK
+        && result_list[4].duplicate_of == file_list[0]
+        && result_list[4].hash == result_list[0].hash
+        && result_list[4].parse_ns == 0, "a copy is not checked again");
+    failed += Check(result_list[5].status == BatchRunner::OK && result_list[5].serializer_stats.commands == 10,
+        "a loop executed");
+    failed += Check(summary.files == 6 && summary.duplicates == 1 && summary.failed == 3, "the summary");
+
+    auto line = BatchRunner::ToJsonLine(result_list[4]);
+    failed += Check(line.find("\"status\": \"ok\"") != std::string::npos
+        && line.find("\"duplicate_of\": ") != std::string::npos
+        && line.find('\n') == std::string::npos, "a JSON line: " + line);
+
+    options.deduplicate = false;
+    options.execute = false;
+    std::vector<BatchRunner::FileResult> parse_only_list;
+    BatchRunner(options).run(file_list, [&](const BatchRunner::FileResult& result) {
+        parse_only_list.push_back(result);
+    });
+    failed += Check(parse_only_list[4].duplicate_of.empty() && parse_only_list[4].parse_ns > 0
+        && !parse_only_list[0].executed && parse_only_list[3].status == BatchRunner::OK,
+        "without dedup and execution");
+
+    return failed;
+}
+
+// two programs of the same size and 64-bit FNV-1a hash, found by a collision search
+static int test_hash_collision(const std::filesystem::path& dir) {
+    std::string valid = "G01 X0.17820819493751970427\n";
+    std::string invalid = "G01 #0.17414705964398274282\n";
+    write_file(dir / "a_valid.ngc", valid);
+    write_file(dir / "b_invalid.ngc", invalid);
+    write_file(dir / "c_invalid_copy.ngc", invalid);
+
+    auto file_list = BatchRunner::CollectFiles({dir.string()}, {".ngc"});
+    BatchRunner::Options options;
+    options.thread_count = 2;
+
+    std::vector<BatchRunner::FileResult> result_list;
+    auto summary = BatchRunner(options).run(file_list, [&](const BatchRunner::FileResult& result) {
+        result_list.push_back(result);
+    });
+    if (result_list.size() != 3) return Check(false, "a hash collision");
+
+    return Check(BatchRunner::ContentHash(valid) == BatchRunner::ContentHash(invalid)
+        && result_list[0].hash == result_list[1].hash && result_list[0].bytes == result_list[1].bytes
+        && result_list[0].status == BatchRunner::OK && result_list[0].duplicate_of.empty()
+        && result_list[1].status == BatchRunner::PARSE_ERROR && result_list[1].duplicate_of.empty()
+        && result_list[1].parse_ns > 0
+        && result_list[2].status == BatchRunner::PARSE_ERROR && result_list[2].duplicate_of == file_list[1]
+        && summary.duplicates == 1 && summary.failed == 2,
+        "a hash collision is checked itself, its copy is not");
+}
+
+// native functions throwing, like a std::bad_alloc deep in the execution
+static int test_foreign_exception(const std::filesystem::path& dir) {
+    rs274letter::RegisterNativeFunction("throw_length", 1, [](const double*) -> double {
+        throw std::length_error("too long");
+    });
+    rs274letter::RegisterNativeFunction("throw_int", 1, [](const double*) -> double {
+        throw 42;
+    });
+    write_file(dir / "a_length_error.ngc", "#1 = 1\nG01 X[throw_length[#1]]\n");
+    write_file(dir / "b_valid.ngc", "G01 X1\n");
+    write_file(dir / "c_int.ngc", "#1 = 1\nG01 X[throw_int[#1]]\n");
+
+    auto file_list = BatchRunner::CollectFiles({dir.string()}, {".ngc"});
+    BatchRunner::Options options;
+    options.thread_count = 2;
+    options.execute = true;
+
+    std::vector<BatchRunner::FileResult> result_list;
+    auto summary = BatchRunner(options).run(file_list, [&](const BatchRunner::FileResult& result) {
+        result_list.push_back(result);
+    });
+    if (result_list.size() != 3) return Check(false, "an exception of another type");
+
+    return Check(result_list[0].status == BatchRunner::EXECUTION_ERROR && result_list[0].error == "too long"
+        && result_list[1].status == BatchRunner::OK
+        && result_list[2].status == BatchRunner::EXECUTION_ERROR && result_list[2].error == "unknown exception"
+        && summary.failed == 2,
+        "an exception of another type fails its file only");
+}
+
+int main() {
+    int failed = 0;
+    rs274letter::Tokenizer::SetPrintComments(false);
+
+    auto dir = std::filesystem::temp_directory_path() / ("rs274letter_test_batch_"
+        + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    try {
+        failed += test_pool();
+        failed += test_batch(dir);
+        failed += test_hash_collision(dir / "collision");
+        failed += test_foreign_exception(dir / "foreign");
+    } catch (std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failed += 1;
+    }
+    std::filesystem::remove_all(dir);
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "tools/BenchCompare.h"
+#include "check.h"
+
+// The benchmark results compared with a baseline: each metric regresses
+// only past its threshold and its noise floor, a missing input fails.
+
+using rs274letter::test::Check;
+using rs274letter::tools::BenchCompare;
+
+static std::string make_document(double contour_lines_per_second, double contour_allocations_per_line,
+    double contour_peak_bytes, bool with_pocket = true) {
+    std::stringstream ss;
+    ss << R"({"benchmark": "bench_parser", "item": "statements", "warmup": 3, "repetitions": 30, "results": [)"
+       << R"({"input": "contour.ngc", "lines": 100, "lines_per_second": )" << contour_lines_per_second
+       << R"(, "allocations_per_line": )" << contour_allocations_per_line
+       << R"(, "peak_bytes": )" << contour_peak_bytes << "}";
+    if (with_pocket) {
+        ss << R"(, {"input": "pocket.ngc", "lines": 50, "lines_per_second": 2000000, "allocations_per_line": 0, "peak_bytes": 1000})";
+    }
+    ss << "]}";
+    return ss.str();
+}
+
+static BenchCompare::ResultMap load(const std::string& document) {
+    BenchCompare::ResultMap result_map;
+    BenchCompare::LoadResults(document, result_map);
+    return result_map;
+}
+
+static BenchCompare::Status status_of(const std::vector<BenchCompare::Row>& row_list,
+    const std::string& input, const std::string& metric) {
+    for (auto&& row : row_list) {
+        if (row.input == input && row.metric == metric) return row.status;
+    }
+    return BenchCompare::OK;
+}
+
+int main() {
+    int failed = 0;
+
+    try {
+        BenchCompare::Options options;
+        options.time_threshold = 0.10;
+        options.allocation_threshold = 0.05;
+        options.memory_threshold = 0.10;
+
+        auto baseline = load(make_document(1000000, 20, 100000));
+
+        auto same = BenchCompare::Compare(baseline, load(make_document(1000000, 20, 100000)), options);
+        failed += Check(same.size() == 6 && !BenchCompare::HasFailure(same), "the same results pass");
+
+        auto noisy = BenchCompare::Compare(baseline, load(make_document(950000, 20.5, 105000)), options);
+        failed += Check(!BenchCompare::HasFailure(noisy), "changes within the thresholds pass");
+
+        auto slower = BenchCompare::Compare(baseline, load(make_document(850000, 20, 100000)), options);
+        failed += Check(status_of(slower, "contour.ngc", "lines_per_second") == BenchCompare::REGRESSED
+            && BenchCompare::HasFailure(slower), "15% fewer lines/s regresses");
+
+        auto faster = BenchCompare::Compare(baseline, load(make_document(1500000, 20, 100000)), options);
+        failed += Check(status_of(faster, "contour.ngc", "lines_per_second") == BenchCompare::IMPROVED
+            && !BenchCompare::HasFailure(faster), "more lines/s improves");
+
+        auto allocating = BenchCompare::Compare(baseline, load(make_document(1000000, 22, 100000)), options);
+        failed += Check(status_of(allocating, "contour.ngc", "allocations_per_line") == BenchCompare::REGRESSED,
+            "10% more allocations/line regresses");
+
+        auto larger = BenchCompare::Compare(baseline, load(make_document(1000000, 20, 130000)), options);
+        failed += Check(status_of(larger, "contour.ngc", "peak_bytes") == BenchCompare::REGRESSED,
+            "30% more peak bytes regresses");
+
+        // the checkpoint bytes of bench_restart
+        auto restart_baseline = load(R"({"benchmark": "restart", "results": [)"
+            R"({"input": "interval_1000@50500", "lines_per_second": 1000, "checkpoint_bytes": 200000}]})");
+        auto restart_current = load(R"({"benchmark": "restart", "results": [)"
+            R"({"input": "interval_1000@50500", "lines_per_second": 1000, "checkpoint_bytes": 260000}]})");
+        auto checkpointed = BenchCompare::Compare(restart_baseline, restart_current, options);
+        failed += Check(checkpointed.size() == 2
+            && status_of(checkpointed, "interval_1000@50500", "checkpoint_bytes") == BenchCompare::REGRESSED,
+            "30% more checkpoint bytes regresses");
+
+        // pocket.ngc has 0 allocations and a small peak in the baseline
+        auto zero_baseline = load(R"({"benchmark": "bench_parser", "results": [)"
+            R"({"input": "pocket.ngc", "lines_per_second": 2000000, "allocations_per_line": 0.005, "peak_bytes": 3000}]})");
+        auto floor = BenchCompare::Compare(load(make_document(1000000, 20, 100000)), zero_baseline, options);
+        failed += Check(status_of(floor, "pocket.ngc", "allocations_per_line") == BenchCompare::OK
+            && status_of(floor, "pocket.ngc", "peak_bytes") == BenchCompare::OK, "changes below the noise floor pass");
+
+        auto missing = BenchCompare::Compare(baseline, load(make_document(1000000, 20, 100000, false)), options);
+        failed += Check(status_of(missing, "pocket.ngc", "lines_per_second") == BenchCompare::MISSING
+            && BenchCompare::HasFailure(missing), "a missing input fails");
+
+        // an old baseline without the heap metrics only compares lines/s
+        auto old_baseline = load(R"({"benchmark": "bench_parser", "results": [{"input": "contour.ngc", "lines_per_second": 1000000}]})");
+        auto old = BenchCompare::Compare(old_baseline, load(make_document(1000000, 20, 100000)), options);
+        failed += Check(old.size() == 1 && !BenchCompare::HasFailure(old), "a metric missing in the baseline is skipped");
+
+        bool thrown = false;
+        try {
+            load(R"({"not": "a result"})");
+        } catch (std::invalid_argument&) {
+            thrown = true;
+        }
+        failed += Check(thrown, "not a result document");
+
+        std::stringstream table;
+        BenchCompare::PrintTable(table, slower);
+        std::cout << table.str();
+        failed += Check(table.str().find("REGRESSED") != std::string::npos
+            && table.str().find("-15.0%") != std::string::npos
+            && table.str().find("6 metrics compared, 1 failed") != std::string::npos, "the diff table");
+    } catch (std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,228 @@
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "rs274letter/ColumnarCommandStore.h"
+#include "rs274letter/MemoryFootprint.h"
+#include "check.h"
+
+using rs274letter::test::Check;
+using rs274letter::ColumnarCommandStore;
+using rs274letter::CommandStatement;
+
+// The commands decoded from a ColumnarCommandStore equal the consumed ones
+// within the quantum: by decode() of each row, and by a Cursor from any row.
+// A toolpath takes about 9 bytes per row, a CommandListSink more than 300.
+
+static const double s_quantum = 1e-4;
+static const std::size_t s_row_count = 1000; // 7 full blocks and a partial one
+
+// the letters of both within the quantum, in the same order
+static bool same_command(const CommandStatement& expected, const CommandStatement& decoded, double quantum) {
+    if (expected.letterMask() != decoded.letterMask()) return false;
+
+    for (char letter = 'a'; letter <= 'z'; ++letter) {
+        auto&& expected_numbers = expected.getNumbersOfLetter(letter);
+        if (!expected_numbers) continue;
+        auto&& decoded_numbers = decoded.getNumbersOfLetter(letter);
+        if (decoded_numbers->size() != expected_numbers->size()) return false;
+
+        for (std::size_t i = 0; i < expected_numbers->size(); ++i) {
+            double a = (*expected_numbers)[i];
+            double b = (*decoded_numbers)[i];
+            // a large number also loses the rounding of number / quantum * quantum
+            if (std::abs(a - b) > quantum / 2 + 4 * std::numeric_limits<double>::epsilon() * std::abs(a)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * A toolpath of s_row_count rows:
+ *  - G, X, Y, Z in each row, X and Y a random walk, Z a slow ramp
+ *  - every 10th row repeats G and M, they go into the overflow area
+ *  - F is first used at row 127, the last row of the first block, A at
+ *    row 300 in the middle of a block, B at row 384 which starts a block
+ *  - X jumps far away and back at rows 500 and 501, a large negative and
+ *    a large positive delta
+*/
+static std::vector<CommandStatement> make_toolpath() {
+    std::vector<CommandStatement> command_list;
+    std::mt19937_64 rng(29);
+    std::uniform_real_distribution<double> step(-0.5, 0.5);
+
+    double x = 0, y = 0;
+    for (std::size_t row = 0; row < s_row_count; ++row) {
+        x += step(rng);
+        y += step(rng);
+
+        CommandStatement cs;
+        cs.pushBack({'G', row % 3 == 0 ? 0.0 : 1.0});
+        if (row % 10 == 0) {
+            cs.pushBack({'G', 90});
+            cs.pushBack({'M', 3});
+            cs.pushBack({'G', 40});
+            cs.pushBack({'M', 8});
+        }
+        cs.pushBack({'X', row == 500 ? -3.5e8 : (row == 501 ? 3.9e8 : x)});
+        cs.pushBack({'Y', y});
+        cs.pushBack({'Z', -0.001 * static_cast<double>(row)});
+        if (row >= 127 && row % 7 == 1) cs.pushBack({'F', 100.0 + static_cast<double>(row % 50)});
+        if (row >= 300) cs.pushBack({'A', static_cast<double>(row) * 0.25});
+        if (row >= 384 && row % 2 == 0) cs.pushBack({'B', -static_cast<double>(row)});
+        command_list.push_back(cs);
+    }
+    return command_list;
+}
+
+static int test_decode(const ColumnarCommandStore& store, const std::vector<CommandStatement>& command_list) {
+    int failed = 0;
+
+    // all the rows, backwards, so each decode starts from its checkpoint
+    bool same = store.size() == command_list.size();
+    CommandStatement decoded;
+    for (std::size_t row = command_list.size(); same && row-- > 0;) {
+        store.decode(row, decoded);
+        same = same_command(command_list[row], decoded, s_quantum);
+        if (!same) std::cout << "row " << row << ":\n" << decoded;
+    }
+    failed += Check(same, "decode() each row");
+
+    // before, at and after each checkpoint
+    bool around = true;
+    for (std::size_t block = 1; block * ColumnarCommandStore::kBlockRows < command_list.size(); ++block) {
+        auto checkpoint_row = block * ColumnarCommandStore::kBlockRows;
+        for (auto row : { checkpoint_row - 1, checkpoint_row, checkpoint_row + 1 }) {
+            around = around && same_command(command_list[row], store.at(row), s_quantum);
+        }
+    }
+    failed += Check(around, "decode() around each checkpoint");
+
+    bool thrown = false;
+    try {
+        store.at(command_list.size());
+    } catch (rs274letter::Exception&) {
+        thrown = true;
+    }
+    failed += Check(thrown, "decode() out of range throws");
+
+    return failed;
+}
+
+static int test_cursor(const ColumnarCommandStore& store, const std::vector<CommandStatement>& command_list) {
+    int failed = 0;
+
+    for (std::size_t start : { 0, 1, 63, 127, 128, 129, 300, 383, 384, 500, 999 }) {
+        auto cursor = store.cursor(start);
+        CommandStatement decoded;
+        bool same = true;
+        std::size_t row = start;
+        while (same && cursor.next(decoded)) {
+            same = same_command(command_list[row], decoded, s_quantum);
+            ++row;
+        }
+        failed += Check(same && row == command_list.size() && cursor.row() == row,
+            "a cursor from row " + std::to_string(start));
+    }
+
+    CommandStatement decoded;
+    auto end_cursor = store.cursor(command_list.size());
+    failed += Check(!end_cursor.next(decoded), "a cursor from the end");
+
+    return failed;
+}
+
+// the deltas near the limit of the quantized numbers, and a number past it
+static int test_large_numbers() {
+    int failed = 0;
+
+    ColumnarCommandStore store(1e-6);
+    std::vector<CommandStatement> command_list;
+    for (double x : { 0.0, 3.9e12, -3.9e12, 3.9e12, -1e-6, 1e-6, -3.9e12 }) {
+        CommandStatement cs;
+        cs.pushBack({'X', x});
+        cs.pushBack({'X', -x});
+        store.consume(cs);
+        command_list.push_back(cs);
+    }
+
+    bool same = true;
+    auto cursor = store.cursor();
+    CommandStatement decoded;
+    for (std::size_t row = 0; row < command_list.size(); ++row) {
+        same = same && same_command(command_list[row], store.at(row), 1e-6)
+            && cursor.next(decoded) && same_command(command_list[row], decoded, 1e-6);
+    }
+    failed += Check(same, "large negative and positive deltas");
+
+    CommandStatement too_large;
+    too_large.pushBack({'Y', 1});
+    too_large.pushBack({'X', 5e12});
+    bool thrown = false;
+    try {
+        store.consume(too_large);
+    } catch (rs274letter::Exception&) {
+        thrown = true;
+    }
+    failed += Check(thrown && store.size() == command_list.size() && !store.at(command_list.size() - 1).has_letter('y'),
+        "a number too large for the quantum throws, the store is unchanged");
+
+    return failed;
+}
+
+// a 3-axis toolpath of 100k rows, each axis moving up to 0.5 mm per row
+static int test_bytes_per_row() {
+    const std::size_t row_count = 100000;
+
+    ColumnarCommandStore store(s_quantum);
+    rs274letter::CountingMemoryResource counting_resource;
+    rs274letter::CommandListSink list_sink(&counting_resource);
+
+    std::mt19937_64 rng(1);
+    std::uniform_real_distribution<double> step(-0.5, 0.5);
+    double x = 0, y = 0, z = 0;
+    for (std::size_t row = 0; row < row_count; ++row) {
+        x += step(rng);
+        y += step(rng);
+        z += step(rng);
+        CommandStatement cs;
+        cs.pushBack({'G', 1});
+        cs.pushBack({'X', x});
+        cs.pushBack({'Y', y});
+        cs.pushBack({'Z', z});
+        store.consume(cs);
+        list_sink.consume(cs);
+    }
+    store.shrinkToFit();
+
+    double store_bytes_per_row = static_cast<double>(store.memoryUsage()) / row_count;
+    double list_bytes_per_row = static_cast<double>(counting_resource.getBytes()) / row_count;
+    return Check(store_bytes_per_row <= 10 && list_bytes_per_row >= 300,
+        "bytes per row, store: " + std::to_string(store_bytes_per_row)
+        + ", CommandListSink: " + std::to_string(list_bytes_per_row));
+}
+
+int main() {
+    int failed = 0;
+
+    try {
+        auto command_list = make_toolpath();
+        ColumnarCommandStore store(s_quantum);
+        for (auto&& cs : command_list) store.consume(cs);
+
+        failed += test_decode(store, command_list);
+        failed += test_cursor(store, command_list);
+        failed += test_large_numbers();
+        failed += test_bytes_per_row();
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        failed += 1;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
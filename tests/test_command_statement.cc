@@ -0,0 +1,140 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "rs274letter/Serializer.h"
+#include "check.h"
+
+using rs274letter::test::Check;
+using rs274letter::CommandStatement;
+
+// The fixed layout of a CommandStatement: the letter slots, the repeated
+// letters in the inline overflow area seen through a NumberView, and the
+// Serializer rejecting a line which overflows it.
+
+static std::vector<double> numbers_of(const CommandStatement& cs, char letter) {
+    std::vector<double> number_list;
+    if (auto&& view = cs.getNumbersOfLetter(letter)) {
+        for (auto&& number : view.value()) number_list.push_back(number);
+    }
+    return number_list;
+}
+
+static int test_letters() {
+    int failed = 0;
+
+    CommandStatement cs;
+    failed += Check(cs.empty() && !cs.getNumbersOfLetter('g'), "an empty statement");
+
+    bool all_pushed = true;
+    for (char letter = 'a'; letter <= 'z'; ++letter) {
+        all_pushed = all_pushed && cs.pushBack({letter, static_cast<double>(letter - 'a')});
+    }
+    bool all_found = cs.letterMask() == (1u << CommandStatement::kLetterCount) - 1;
+    for (char letter = 'A'; letter <= 'Z'; ++letter) {
+        all_found = all_found && cs.appearTimesOfLetter(letter) == 1
+            && numbers_of(cs, letter) == std::vector<double>{ static_cast<double>(letter - 'A') };
+    }
+    failed += Check(all_pushed && all_found, "26 letters, in either case");
+
+    failed += Check(!cs.pushBack({'1', 1}) && !cs.pushBack({'#', 1}) && !cs.has_letter('#'), "not a letter");
+
+    cs.clear();
+    failed += Check(cs.empty() && !cs.has_letter('a') && numbers_of(cs, 'a').empty(), "clear()");
+
+    return failed;
+}
+
+static int test_overflow() {
+    int failed = 0;
+
+    // G90 X1 G01 Y2 G40 X3 M3 M8: the repeated letters interleaved in the overflow area
+    CommandStatement cs;
+    cs.pushBack({'G', 90});
+    cs.pushBack({'X', 1});
+    cs.pushBack({'G', 1});
+    cs.pushBack({'Y', 2});
+    cs.pushBack({'g', 40});
+    cs.pushBack({'x', 3});
+    cs.pushBack({'M', 3});
+    cs.pushBack({'M', 8});
+
+    auto g = cs.getNumbersOfLetter('g').value();
+    failed += Check(numbers_of(cs, 'G') == std::vector<double>{ 90, 1, 40 }
+        && g.size() == 3 && g.front() == 90 && g[1] == 1 && g[2] == 40,
+        "the numbers of a letter in order");
+    failed += Check(numbers_of(cs, 'X') == std::vector<double>{ 1, 3 }
+        && numbers_of(cs, 'Y') == std::vector<double>{ 2 }
+        && numbers_of(cs, 'M') == std::vector<double>{ 3, 8 }, "the other letters between them");
+
+    // 4 of the 8 overflow numbers are used (G, G, X, M), the repeated Fs take the rest
+    bool pushed = true;
+    for (int i = 0; i < 5; ++i) pushed = pushed && cs.pushBack({'F', 100.0 + i});
+    failed += Check(pushed && numbers_of(cs, 'F') == std::vector<double>{ 100, 101, 102, 103, 104 },
+        "the overflow area filled");
+
+    auto times = cs.appearTimesOfLetter('g');
+    failed += Check(!cs.pushBack({'G', 2}) && !cs.pushBack({'F', 2}) && cs.appearTimesOfLetter('g') == times
+        && numbers_of(cs, 'G') == std::vector<double>{ 90, 1, 40 }, "a full overflow area rejects a repeated letter");
+    failed += Check(cs.pushBack({'Z', -1}) && numbers_of(cs, 'Z') == std::vector<double>{ -1 },
+        "a full overflow area still takes a new letter");
+
+    cs.clear();
+    bool refilled = cs.pushBack({'G', 0});
+    for (std::size_t i = 0; i < CommandStatement::kMaxOverflowNumbers; ++i) {
+        refilled = refilled && cs.pushBack({'G', static_cast<double>(i + 1)});
+    }
+    failed += Check(refilled && cs.appearTimesOfLetter('G') == CommandStatement::kMaxOverflowNumbers + 1
+        && numbers_of(cs, 'G') == std::vector<double>{ 0, 1, 2, 3, 4, 5, 6, 7, 8 }, "clear() empties the overflow area");
+
+    return failed;
+}
+
+static std::string repeated(const std::string& word, int times) {
+    std::string line;
+    for (int i = 0; i < times; ++i) line += word + std::to_string(i) + " ";
+    return line + "\n";
+}
+
+static int test_serializer() {
+    int failed = 0;
+
+    {
+        rs274letter::Serializer s(rs274letter::Parser::parse(repeated("G", CommandStatement::kMaxOverflowNumbers + 1)));
+        s.processProgram();
+        auto&& command_list = s.getCommandList();
+        failed += Check(command_list.size() == 1
+            && command_list.front().appearTimesOfLetter('G') == CommandStatement::kMaxOverflowNumbers + 1,
+            "a line with the most repeated letters");
+    }
+
+    // the line is rejected, the lines before it are kept
+    std::string message;
+    std::size_t command_count = 0;
+    rs274letter::Serializer s(rs274letter::Parser::parse("G00 X0\n" + repeated("G", CommandStatement::kMaxOverflowNumbers + 2)));
+    try {
+        s.processProgram();
+    } catch (rs274letter::SerializerError& e) {
+        message = e.what();
+        command_count = s.getCommandList().size();
+    }
+    failed += Check(message.find("Too many repeated letters in one command line") != std::string::npos
+        && command_count == 1, "a line overflowing the overflow area");
+
+    return failed;
+}
+
+int main() {
+    int failed = 0;
+
+    try {
+        failed += test_letters();
+        failed += test_overflow();
+        failed += test_serializer();
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        failed += 1;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
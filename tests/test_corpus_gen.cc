@@ -0,0 +1,69 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "rs274letter/Serializer.h"
+#include "tools/CorpusGenerator.h"
+
+// The generated programs are reproducible, and each block kind parses and
+// executes with the strict Parser and Serializer.
+
+using rs274letter::tools::CorpusGenerator;
+
+static std::string generate(const CorpusGenerator::Options& options) {
+    std::stringstream ss;
+    CorpusGenerator generator(options);
+    generator.generate(ss);
+    return ss.str();
+}
+
+int main() {
+    int failed = 0;
+
+    CorpusGenerator::Options options;
+    options.seed = 42;
+    options.target_bytes = 32 * 1024;
+
+    auto program = generate(options);
+    bool same = program == generate(options);
+    std::cout << (same ? "passed" : "FAILED") << ": the same seed, the same program" << std::endl;
+    if (!same) ++failed;
+
+    options.seed = 43;
+    bool differ = program != generate(options);
+    std::cout << (differ ? "passed" : "FAILED") << ": another seed, another program" << std::endl;
+    if (!differ) ++failed;
+
+    bool sized = program.size() >= options.target_bytes && program.size() < options.target_bytes + 64 * 1024;
+    std::cout << (sized ? "passed" : "FAILED") << ": " << program.size() << " bytes for "
+              << options.target_bytes << std::endl;
+    if (!sized) ++failed;
+
+    // each block kind alone, then the default mix
+    for (int kind = 0; kind <= CorpusGenerator::kBlockKindCount; ++kind) {
+        std::string name = kind < CorpusGenerator::kBlockKindCount
+            ? CorpusGenerator::BlockKindName(static_cast<CorpusGenerator::BlockKind>(kind)) : "default";
+
+        CorpusGenerator::Options kind_options;
+        kind_options.seed = 7 + kind;
+        kind_options.target_bytes = 16 * 1024;
+        if (kind < CorpusGenerator::kBlockKindCount) {
+            kind_options.mix = CorpusGenerator::ParseMix(name + "=1");
+        }
+
+        try {
+            rs274letter::Serializer s(rs274letter::Parser::parse(generate(kind_options)));
+            s.processProgram();
+            bool passed = !s.getCommandList().empty();
+            std::cout << (passed ? "passed" : "FAILED") << ": " << name << ", "
+                      << s.getCommandList().size() << " commands" << std::endl;
+            if (!passed) ++failed;
+        } catch (rs274letter::Exception& e) {
+            std::cout << e.what() << std::endl;
+            std::cout << "FAILED: " << name << std::endl;
+            ++failed;
+        }
+    }
+
+    return failed == 0 ? 0 : 1;
+}
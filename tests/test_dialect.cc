@@ -0,0 +1,72 @@
+#include <iostream>
+#include <string>
+
+#include "rs274letter/Serializer.h"
+
+// The strict and the lenient dialect in one process: each program is
+// rejected by the strict Parser or Serializer, and accepted by the lenient ones.
+
+struct Case {
+    const char* rule;
+    const char* code;
+    const char* variable; // checked after the lenient run
+    double value;
+};
+
+static const Case s_case_list[] = {
+    { "kNoSingleNonAssignExpression", "#1 = 2\n#1 + 2\n", "1", 2 },
+    { "kMustPrimaryRightHandsideOfAssign", "#2 = 1\n#1 = #2 + 1\n", "1", 2 },
+    { "kDoNotAllowMultipleAssign", "#1 = [#2 = 3]\n", "2", 3 },
+    { "kNumberIndexVariableUndefinedError", "#1 = [#5 + 1]\n", "1", 1 },
+    { "kNameIndexVariableUndefinedError", "#<a> = [#<b> + 2]\n", "a", 2 },
+};
+
+static double get_variable(const rs274letter::LenientSerializer& s, const std::string& variable) {
+    if (variable[0] >= '0' && variable[0] <= '9') {
+        return s.getVariableValue(std::stoi(variable));
+    }
+    return s.getVariableValue(variable);
+}
+
+int main() {
+    int failed = 0;
+
+    for (auto&& c : s_case_list) {
+        bool strict_rejected = false;
+        try {
+            rs274letter::Serializer s(rs274letter::Parser::parse(c.code));
+            s.processProgram();
+        } catch (rs274letter::Exception&) {
+            strict_rejected = true;
+        }
+
+        double value = 0;
+        bool lenient_passed = true;
+        try {
+            rs274letter::LenientSerializer s(rs274letter::LenientParser::parse(c.code));
+            s.processProgram();
+            value = get_variable(s, c.variable);
+        } catch (rs274letter::Exception& e) {
+            std::cout << e.what() << std::endl;
+            lenient_passed = false;
+        }
+
+        bool passed = strict_rejected && lenient_passed && value == c.value;
+        std::cout << (passed ? "passed" : "FAILED") << ": " << c.rule << std::endl;
+        if (!passed) ++failed;
+    }
+
+    // a number index without the primaryExpression rule, the same AST shape
+    try {
+        rs274letter::LenientSerializer s(rs274letter::LenientParser::parse("#3 = 4\n##3 = 5\nG01 X#[2 + 2]\n"));
+        s.processProgram();
+        bool passed = s.getVariableValue(4) == 5 && s.getCommandList().size() == 1;
+        std::cout << (passed ? "passed" : "FAILED") << ": lenient number index" << std::endl;
+        if (!passed) ++failed;
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        ++failed;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
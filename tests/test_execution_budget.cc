@@ -0,0 +1,136 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "rs274letter/Serializer.h"
+#include "check.h"
+
+using rs274letter::test::Check;
+using rs274letter::ExecutionBudget;
+
+// Each limit of the ExecutionBudget: a program within it runs, a program
+// over it throws the SerializerError naming it. The duration is counted
+// for the whole run, over the step() calls and without the pauses between.
+
+// the message of the SerializerError thrown by running the code, or "" if none is thrown
+static std::string run_error(const std::string& code, const ExecutionBudget& budget) {
+    rs274letter::Serializer s(rs274letter::Parser::parse(code));
+    s.setExecutionBudget(budget);
+    try {
+        s.processProgram();
+    } catch (rs274letter::SerializerError& e) {
+        return e.what();
+    }
+    return "";
+}
+
+static int test_limit(const std::string& name, const std::string& within_code, const std::string& over_code,
+    const ExecutionBudget& budget) {
+    auto within_error = run_error(within_code, budget);
+    auto over_error = run_error(over_code, budget);
+
+    bool passed = within_error.empty()
+        && over_error.find("Execution budget exhausted: " + name + ", limit: ") != std::string::npos;
+    if (!passed) std::cout << within_error << "\n" << over_error << std::endl;
+    return Check(passed, name);
+}
+
+// a while loop of `times` iterations with a command in each
+static std::string loop_code(int times) {
+    return "#1 = 0\no1 while [#1 lt " + std::to_string(times) + "]\n    #1 = [#1 + 1]\n    G01 X#1\no1 endwhile\n";
+}
+
+// `depth` nested calls of a recursive sub
+static std::string recursion_code(int depth) {
+    return "o<r> sub\n    o1 if [#1 gt 1]\n        o<r> call [#1 - 1]\n    o1 endif\n    G01 X#1\no<r> endsub\n"
+        "o<r> call [" + std::to_string(depth) + "]\n";
+}
+
+static int test_counters() {
+    int failed = 0;
+
+    ExecutionBudget budget;
+    budget.max_statements = 100;
+    failed += test_limit("statements", loop_code(10), loop_code(60), budget);
+
+    budget = ExecutionBudget();
+    budget.max_commands = 20;
+    failed += test_limit("commands", loop_code(10), loop_code(30), budget);
+
+    budget = ExecutionBudget();
+    budget.max_call_depth = 5;
+    failed += test_limit("call depth", recursion_code(5), recursion_code(6), budget);
+
+    // the outer and the inner iterations count together, 10 + 10 * 9 and 10 + 10 * 10
+    budget = ExecutionBudget();
+    budget.max_loop_iterations = 100;
+    failed += test_limit("loop iterations",
+        "o1 repeat [10]\n    o2 repeat [9]\n        G01 X1\n    o2 endrepeat\no1 endrepeat\n",
+        "o1 repeat [10]\n    o2 repeat [10]\n        G01 X1\n    o2 endrepeat\no1 endrepeat\n", budget);
+
+    failed += test_limit("single loop iterations", loop_code(1000), loop_code(1001), ExecutionBudget());
+
+    return failed;
+}
+
+static int test_duration() {
+    int failed = 0;
+
+    ExecutionBudget budget;
+    budget.max_duration = std::chrono::milliseconds(100);
+    budget.max_single_loop_iterations = 0;
+    const std::string endless_code = "o1 while [1]\n    G01 X1\no1 endwhile\n";
+
+    failed += test_limit("duration(ms)", loop_code(100), endless_code, budget);
+
+    // each step is shorter than the limit, the run is not
+    {
+        rs274letter::Serializer s(rs274letter::Parser::parse(endless_code));
+        s.setExecutionBudget(budget);
+        s.setCommandSink(std::make_shared<rs274letter::CallbackCommandSink>([](const rs274letter::CommandStatement&) {}));
+
+        std::string error;
+        auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        try {
+            while (s.step(100) && std::chrono::steady_clock::now() < give_up) {}
+        } catch (rs274letter::SerializerError& e) {
+            error = e.what();
+        }
+        failed += Check(error.find("Execution budget exhausted: duration(ms)") != std::string::npos,
+            "the duration of a run in short steps");
+    }
+
+    // the pauses between the steps are not counted
+    {
+        rs274letter::Serializer s(rs274letter::Parser::parse(loop_code(500)));
+        s.setExecutionBudget(budget);
+
+        std::string error;
+        try {
+            while (s.step(100)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+        } catch (rs274letter::SerializerError& e) {
+            error = e.what();
+        }
+        failed += Check(error.empty() && s.isFinished() && s.getCommandCount() == 500,
+            "the pauses between the steps");
+    }
+
+    return failed;
+}
+
+int main() {
+    int failed = 0;
+
+    try {
+        failed += test_counters();
+        failed += test_duration();
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        failed += 1;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
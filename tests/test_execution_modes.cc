@@ -0,0 +1,160 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+
+#include "rs274letter/Serializer.h"
+#include "rs274letter/AstValidator.h"
+
+// Built twice: `test_execution_modes` links the default (unchecked) library,
+// `test_execution_modes_checked` links the one built with RS274LETTER_CHECKED_EXECUTION.
+// Both write the same output, compared by the `compare_execution_modes` target.
+// usage: test_execution_modes [output_file], prints to stdout without output_file
+
+static const char* s_program_list[] = {
+R"(
+    #1 = 3
+    #<_scale> = 0.5
+    G90 G01 X[#1 * #<_scale>] Y-[#1 ** 2] F1000
+    #2 = [#1 GT 2 AND #1 LT 4]
+    #3 = [#1 EQ 3 XOR #2 NE 0]
+    #4 = [atan[1]/[-1] + sin[30] + cos[60] + sqrt[16] + abs[-2]]
+    #5 = [fix[2.7] + fup[2.1] + round[2.5] + exp[0] + ln[1] + tan[45]]
+    #6 = [exists[#1] + exists[#<undefined>]]
+    G01 X#4 Y#5 Z#6
+)",
+R"(
+    #<i> = 0
+    o1 while [#<i> LT 10]
+        #<i> = [#<i> + 1]
+        o2 if [#<i> EQ 3]
+            o1 continue
+        o2 elseif [#<i> EQ 8]
+            o1 break
+        o2 else
+            G01 X#<i>
+        o2 endif
+    o1 endwhile
+    o3 repeat [3]
+        G01 Y#<i>
+    o3 endrepeat
+)",
+R"(
+    o<square> sub
+        o10 if [#1 LT 0]
+            o<square> return [0]
+        o10 endif
+        G01 Z#1
+    o<square> endsub [#1 * #1]
+
+    o100 sub
+        o<square> call [#1 + 1]
+        o100 return [#<_value> + 1]
+    o100 endsub
+
+    #1 = 0
+    o2 repeat [4]
+        o100 call [#1]
+        G01 A#<_value> B#<_value_returned>
+        #1 = [#1 + 1]
+    o2 endrepeat
+    o<square> call [-1]
+    G01 C#<_value>
+
+    #50 = 200
+    o[#50] sub
+        G01 U#1
+    o[#50] endsub
+    o[#50] call [7]
+)",
+};
+
+static void run_program(const std::string& code, std::ostream& out) {
+    rs274letter::Serializer s(rs274letter::Parser::parse(code));
+    s.processProgram();
+
+    for (auto&& command : s.getCommandList()) {
+        out << command.toString() << std::endl;
+    }
+}
+
+// a hand-built AST which passes the Parser's checks but not the shape check
+static bool is_rejected(const rs274letter::AstObject& program, std::ostream& out) {
+    try {
+        rs274letter::Serializer s(program);
+        s.link();
+    } catch (rs274letter::AstValidateError& e) {
+        out << "rejected: " << e.what() << std::endl;
+        return true;
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    std::ofstream ofs;
+    if (argc > 1) {
+        ofs.open(argv[1]);
+        if (!ofs.is_open()) {
+            std::cout << "cannot open output file: " << argv[1] << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = argc > 1 ? ofs : std::cout;
+    out << std::setprecision(10);
+
+    try {
+        for (auto&& code : s_program_list) {
+            run_program(code, out);
+        }
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    using rs274letter::AstObject;
+    using rs274letter::AstArray;
+
+    auto literal = AstObject{{"type", "integerNumericLiteral"}, {"value", 1}};
+
+    AstObject bad_letter{
+        {"type", "program"},
+        {"body", AstArray{
+            AstObject{
+                {"type", "commandStatement"},
+                {"commands", AstArray{
+                    AstObject{{"type", "commandNumberGroup"}, {"letter", "G1"}, {"number", literal}}
+                }}
+            }
+        }}
+    };
+
+    AstObject bad_operator{
+        {"type", "program"},
+        {"body", AstArray{
+            AstObject{
+                {"type", "expressionStatement"},
+                {"expression", AstObject{
+                    {"type", "binaryExpression"}, {"operator", "mod"}, {"left", literal}, {"right", literal}
+                }}
+            }
+        }}
+    };
+
+    AstObject missing_body{
+        {"type", "program"},
+        {"body", AstArray{
+            AstObject{
+                {"type", "oWhileStatement"},
+                {"whileOCommand", AstObject{{"type", "numberIndexOCommand"}, {"index", literal}}},
+                {"endwhileOCommand", AstObject{{"type", "numberIndexOCommand"}, {"index", literal}}},
+                {"test", literal}
+            }
+        }}
+    };
+
+    if (!is_rejected(bad_letter, out) || !is_rejected(bad_operator, out) || !is_rejected(missing_body, out)) {
+        std::cout << "an invalid AST is not rejected" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "fuzz/fuzz_harness.h"
+
+// The inputs saved in fuzz/regression: each one was slow, exhausted the
+// stack or threw a non rs274letter::Exception, now the Tokenizer, the
+// Parser and the Serializer run each within the budget of fuzz_harness.h.
+// The valid programs among them must also run to the end, not be rejected.
+// usage: test_fuzz_regression [DIR]
+
+#ifndef RS274LETTER_FUZZ_REGRESSION_DIR
+#define RS274LETTER_FUZZ_REGRESSION_DIR "fuzz/regression"
+#endif
+
+using namespace rs274letter::fuzz;
+
+// the inputs which are valid programs
+static const char* s_valid_input_list[] = { "long_elseif.ngc" };
+
+static int check(const std::string& target_name, const std::string& input_name,
+    const Measurement& measurement, const Budget& budget) {
+    bool passed = measurement.isWithin(budget);
+    std::cout << (passed ? "passed" : "FAILED") << ": " << target_name << " " << input_name
+              << ", " << measurement.toString(budget) << std::endl;
+    return passed ? 0 : 1;
+}
+
+static int check_valid(const std::string& input_name, const std::string& code) {
+    std::string error;
+    try {
+        rs274letter::Serializer s(rs274letter::Program::compile(rs274letter::Parser::parse(code)));
+        s.processProgram();
+        if (!s.isFinished()) error = "not finished";
+    } catch (rs274letter::Exception& e) {
+        error = e.what();
+    }
+    std::cout << (error.empty() ? "passed" : "FAILED") << ": valid " << input_name;
+    if (!error.empty()) std::cout << ", error: " << error;
+    std::cout << std::endl;
+    return error.empty() ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    std::string dir = argc > 1 ? argv[1] : RS274LETTER_FUZZ_REGRESSION_DIR;
+    auto budget = Budget::FromEnvironment();
+
+    std::vector<std::filesystem::path> path_list;
+    std::error_code ec;
+    for (auto&& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (entry.is_regular_file()) path_list.push_back(entry.path());
+    }
+    if (ec || path_list.empty()) {
+        std::cout << "FAILED: no input in " << dir << std::endl;
+        return 1;
+    }
+    std::sort(path_list.begin(), path_list.end());
+
+    int failed = 0;
+    for (auto&& path : path_list) {
+        std::ifstream ifs(path, std::ios::binary);
+        std::stringstream ss;
+        ss << ifs.rdbuf();
+        auto code = ss.str();
+        auto name = path.filename().string();
+
+        failed += check("tokenizer", name, Measure(code, budget, RunTokenizer), budget);
+        failed += check("parser", name, Measure(code, budget, RunParser), budget);
+        failed += check("serializer", name, Measure(code, budget, RunSerializer), budget);
+
+        if (std::find(std::begin(s_valid_input_list), std::end(s_valid_input_list), name)
+            != std::end(s_valid_input_list)) {
+            failed += check_valid(name, code);
+        }
+    }
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "rs274letter/InsideFunction.h"
+#include "rs274letter/Serializer.h"
+#include "check.h"
+
+using rs274letter::test::Check;
+
+// The degree-domain functions: exact at the special angles, within a few
+// ulps of the std:: functions elsewhere, and the batch functions giving the
+// same results as the scalar ones, element by element.
+
+static const long double s_pi = 3.141592653589793238462643383279502884L;
+
+// the ulps of the error of value, measured at the reference
+static double ulp_error(double value, long double reference) {
+    double ref = static_cast<double>(reference);
+    if (value == ref) return 0;
+    double ulp = std::nextafter(std::abs(ref), HUGE_VAL) - std::abs(ref);
+    return static_cast<double>(std::abs(static_cast<long double>(value) - reference) / ulp);
+}
+
+// sin and cos of a degree in long double: the degree is reduced by a multiple
+// of 90 first, which is exact, so the reference is accurate near the zeros too
+static void reference_sin_cos(double degree, long double& sin_value, long double& cos_value) {
+    long double n = std::round(static_cast<long double>(degree) / 90);
+    long double radian = (degree - 90 * n) * s_pi / 180;
+    long double s = std::sin(radian), c = std::cos(radian);
+    int quadrant = static_cast<int>(std::fmod(n, 4.0L) + 4) % 4;
+    sin_value = quadrant == 0 ? s : (quadrant == 1 ? c : (quadrant == 2 ? -s : -c));
+    cos_value = quadrant == 0 ? c : (quadrant == 1 ? -s : (quadrant == 2 ? -c : s));
+}
+
+static bool same_result(double a, double b) {
+    return a == b ? std::signbit(a) == std::signbit(b) : (std::isnan(a) && std::isnan(b));
+}
+
+// the X of the command produced by `G01 X[expression]`
+static double run_expression(const std::string& expression) {
+    rs274letter::Serializer s(rs274letter::Parser::parse("G01 X[" + expression + "]\n"));
+    s.processProgram();
+    return s.getCommandList().front().getNumbersOfLetter('x')->front();
+}
+
+static int test_exact() {
+    int failed = 0;
+
+    struct Case {
+        const char* expression;
+        double expected;
+    };
+    static const Case s_case_list[] = {
+        { "sin[30]", 0.5 }, { "sin[-30]", -0.5 }, { "sin[150]", 0.5 }, { "sin[180]", 0 },
+        { "sin[90]", 1 }, { "sin[-270]", 1 }, { "sin[720]", 0 },
+        { "cos[90]", 0 }, { "cos[60]", 0.5 }, { "cos[120]", -0.5 }, { "cos[180]", -1 }, { "cos[360]", 1 },
+        { "tan[45]", 1 }, { "tan[-45]", -1 }, { "tan[135]", -1 }, { "tan[180]", 0 },
+        { "atan[1]/[1]", 45 }, { "atan[1]/[0]", 90 }, { "atan[0]/[-1]", 180 }, { "atan[-1]/[-1]", -135 },
+        { "asin[0.5]", 30 }, { "asin[-1]", -90 }, { "acos[0.5]", 60 }, { "acos[0]", 90 }, { "acos[-1]", 180 },
+    };
+
+    for (auto&& c : s_case_list) {
+        auto value = run_expression(c.expression);
+        failed += Check(value == c.expected && !std::signbit(value - c.expected),
+            std::string(c.expression) + " == " + std::to_string(c.expected));
+    }
+
+    failed += Check(rs274letter::TanDegree(90) == HUGE_VAL && rs274letter::TanDegree(-270) == HUGE_VAL,
+        "tan at the odd multiples of 90 is +inf");
+    failed += Check(rs274letter::SinDegree(45) == std::sqrt(0.5) && rs274letter::CosDegree(-45) == std::sqrt(0.5)
+        && rs274letter::SinDegree(60) == std::sqrt(3.0) / 2 && rs274letter::CosDegree(30) == std::sqrt(3.0) / 2
+        && rs274letter::TanDegree(60) == std::sqrt(3.0) && rs274letter::TanDegree(-120) == std::sqrt(3.0),
+        "sin and cos at 45 and 60, tan at 60, rounded to the nearest");
+
+    return failed;
+}
+
+static int test_ulp() {
+    int failed = 0;
+
+    std::mt19937_64 rng(34);
+    std::uniform_real_distribution<double> degree_distribution(-1080, 1080);
+    std::uniform_real_distribution<double> unit_distribution(-1, 1);
+
+    double sin_max = 0, cos_max = 0, tan_max = 0, asin_max = 0, acos_max = 0, atan_max = 0;
+    for (int i = 0; i < 200000; ++i) {
+        double d = degree_distribution(rng);
+        long double s, c;
+        reference_sin_cos(d, s, c);
+        sin_max = std::max(sin_max, ulp_error(rs274letter::SinDegree(d), s));
+        cos_max = std::max(cos_max, ulp_error(rs274letter::CosDegree(d), c));
+        tan_max = std::max(tan_max, ulp_error(rs274letter::TanDegree(d), s / c));
+
+        double v = unit_distribution(rng);
+        asin_max = std::max(asin_max, ulp_error(rs274letter::AsinDegree(v), std::asin(static_cast<long double>(v)) * 180 / s_pi));
+        acos_max = std::max(acos_max, ulp_error(rs274letter::AcosDegree(v), std::acos(static_cast<long double>(v)) * 180 / s_pi));
+
+        double y = d, x = degree_distribution(rng);
+        atan_max = std::max(atan_max, ulp_error(rs274letter::Atan2Degree(y, x),
+            std::atan2(static_cast<long double>(y), static_cast<long double>(x)) * 180 / s_pi));
+    }
+
+    // measured: about 1.6 ulp for sin, cos, asin and acos, 2.7 for atan, 3.1 for tan (sin / cos)
+    const double max_ulp = 4;
+    failed += Check(sin_max <= max_ulp, "sin within " + std::to_string(sin_max) + " ulp");
+    failed += Check(cos_max <= max_ulp, "cos within " + std::to_string(cos_max) + " ulp");
+    failed += Check(tan_max <= max_ulp, "tan within " + std::to_string(tan_max) + " ulp");
+    failed += Check(asin_max <= max_ulp, "asin within " + std::to_string(asin_max) + " ulp");
+    failed += Check(acos_max <= max_ulp, "acos within " + std::to_string(acos_max) + " ulp");
+    failed += Check(atan_max <= max_ulp, "atan within " + std::to_string(atan_max) + " ulp");
+
+    return failed;
+}
+
+static int test_batch() {
+    int failed = 0;
+
+    // 4 blocks and a partial one, the third has the params the kernels can not reduce
+    std::vector<double> param_list(1100), param2_list(1100);
+    std::mt19937_64 rng(35);
+    std::uniform_real_distribution<double> degree_distribution(-1000, 1000);
+    for (std::size_t i = 0; i < param_list.size(); ++i) {
+        param_list[i] = i % 7 == 0 ? 30.0 * static_cast<double>(i % 25) : degree_distribution(rng);
+        param2_list[i] = i % 11 == 0 ? 0.0 : degree_distribution(rng);
+    }
+    param_list[600] = 1e20;
+    param_list[601] = HUGE_VAL;
+    param_list[602] = NAN;
+    param_list[603] = -0.0;
+    param2_list[604] = -HUGE_VAL;
+
+    // in the order of InsideFunctionId
+    static const char* s_name_list[] = { "atan", "abs", "acos", "asin", "cos", "exp", "fix", "fup", "round",
+        "ln", "sin", "sqrt", "tan", "exists" };
+    static_assert(sizeof(s_name_list) / sizeof(s_name_list[0]) == rs274letter::INSIDE_FUNCTION_COUNT);
+
+    std::vector<double> result_list(param_list.size());
+    for (int id = 0; id < rs274letter::INSIDE_FUNCTION_COUNT; ++id) {
+        auto function_id = static_cast<rs274letter::InsideFunctionId>(id);
+        auto scalar_function = rs274letter::GetUnaryInsideFunction(function_id);
+        if (function_id == rs274letter::INSIDE_FUNCTION_EXISTS) continue;
+
+        rs274letter::EvaluateInsideFunctionBatch(function_id, param_list.data(), result_list.data(),
+            param_list.size(), param2_list.data());
+
+        bool same = true;
+        for (std::size_t i = 0; same && i < param_list.size(); ++i) {
+            double expected = scalar_function ? scalar_function(param_list[i])
+                : rs274letter::Atan2Degree(param_list[i], param2_list[i]);
+            same = same_result(result_list[i], expected);
+            if (!same) std::cout << "param " << param_list[i] << ", " << param2_list[i] << std::endl;
+        }
+        failed += Check(same, std::string("the batch of ") + s_name_list[id] + " equals the scalar one");
+    }
+
+    // in place
+    auto in_place_list = param_list;
+    rs274letter::BatchSinDegree(in_place_list.data(), in_place_list.data(), in_place_list.size());
+    bool same = true;
+    for (std::size_t i = 0; i < param_list.size(); ++i) {
+        same = same && same_result(in_place_list[i], rs274letter::SinDegree(param_list[i]));
+    }
+    failed += Check(same, "the batch in place");
+
+    bool thrown = false;
+    try {
+        rs274letter::EvaluateInsideFunctionBatch(rs274letter::INSIDE_FUNCTION_ATAN,
+            param_list.data(), result_list.data(), param_list.size());
+    } catch (rs274letter::Exception&) {
+        thrown = true;
+    }
+    failed += Check(thrown, "atan without param2 throws");
+
+    thrown = false;
+    try {
+        rs274letter::EvaluateInsideFunctionBatch(rs274letter::INSIDE_FUNCTION_EXISTS,
+            param_list.data(), result_list.data(), param_list.size());
+    } catch (rs274letter::Exception&) {
+        thrown = true;
+    }
+    failed += Check(thrown, "exists throws");
+
+    return failed;
+}
+
+int main() {
+    int failed = 0;
+
+    try {
+        failed += test_exact();
+        failed += test_ulp();
+        failed += test_batch();
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        failed += 1;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
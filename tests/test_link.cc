@@ -0,0 +1,177 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "rs274letter/Linker.h"
+#include "rs274letter/Serializer.h"
+#include "check.h"
+
+using rs274letter::test::Check;
+
+// The link pass: each invalid program is rejected by a LinkError with its
+// message before any statement runs, the valid ones link and run.
+
+struct Case {
+    const char* name;
+    const char* code;
+    const char* message; // a part of the LinkError message
+};
+
+static const Case s_case_list[] = {
+    { "o-word mismatch in if", "o1 if [1]\n    G01 X1\no2 endif\n",
+        "o-word does not match in oIfStatement\nexpected: o1\ngot: o2" },
+    { "o-word mismatch in else", "o1 if [1]\no2 else\no1 endif\n",
+        "o-word does not match in oIfStatement\nexpected: o1\ngot: o2" },
+    { "o-word mismatch in while", "o1 while [1]\no2 endwhile\n",
+        "o-word does not match in oWhileStatement\nexpected: o1\ngot: o2" },
+    { "o-word mismatch in repeat", "o1 repeat [2]\no2 endrepeat\n",
+        "o-word does not match in oRepeatStatement\nexpected: o1\ngot: o2" },
+    { "break of another loop", "o1 while [1]\n    o2 while [1]\n        o1 break\n    o2 endwhile\no1 endwhile\n",
+        "o-word does not match in oBreakStatement\nexpected: o2\ngot: o1" },
+    { "continue of another loop", "o1 repeat [2]\n    o2 continue\no1 endrepeat\n",
+        "o-word does not match in oContinueStatement\nexpected: o1\ngot: o2" },
+    { "return of another sub", "o<a> sub\n    o<b> return\no<a> endsub\n",
+        "o-word does not match in oReturnStatement\nexpected: o<a>\ngot: o<b>" },
+    { "endsub of another sub", "o<a> sub\n    G01 X1\no<b> endsub\n",
+        "o-word does not match in oSubStatement\nexpected: o<a>\ngot: o<b>" },
+    { "undefined o-call target", "o<a> sub\no<a> endsub\no<b> call\n",
+        "Undefined o-call subject: o<b>" },
+    { "duplicate sub", "o100 sub\no100 endsub\no[50 * 2] sub\no[50 * 2] endsub\n",
+        "Duplicate o-sub definition: o100" },
+    { "negative o-word", "o[0 - 1] sub\no[0 - 1] endsub\n",
+        "Invalid o-word number index" },
+};
+
+// the message of the LinkError thrown by f, or "" if none is thrown
+template <typename F>
+static std::string link_error_of(F&& f) {
+    try {
+        f();
+    } catch (rs274letter::LinkError& e) {
+        return e.what();
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        return "not a LinkError";
+    }
+    return "";
+}
+
+static int test_link_error(const Case& c) {
+    auto message = link_error_of([&]() {
+        auto ast = rs274letter::Parser::parse(c.code);
+        rs274letter::Linker::link(ast);
+    });
+
+    // the Serializer links before running the first statement
+    std::size_t command_count = 0;
+    auto run_message = link_error_of([&]() {
+        rs274letter::Serializer s(rs274letter::Parser::parse(std::string("G00 X0\n") + c.code));
+        try {
+            s.processProgram();
+        } catch (...) {
+            command_count = s.getCommandList().size();
+            throw;
+        }
+    });
+
+    bool passed = message.find("RS274Exception: LinkError:\n") == 0
+        && message.find(c.message) != std::string::npos
+        && run_message == message && command_count == 0;
+    if (!passed) std::cout << message << std::endl;
+    return Check(passed, c.name);
+}
+
+// break/continue/return outside a loop or a sub are rejected by the Parser,
+// the Linker still examines an AST built without it: the first statement
+// of the first block is moved out to the top level
+static int test_unparsed_statement(const std::string& code, const std::string& name, const std::string& message) {
+    auto ast = rs274letter::Parser::parse(code);
+    auto statement = ast["body"].as_array()[0].as_object()["body"].as_array()[0];
+    ast["body"] = rs274letter::AstArray{ statement };
+
+    auto error = link_error_of([&]() { rs274letter::Linker::link(ast); });
+    bool passed = error.find(message) != std::string::npos;
+    if (!passed) std::cout << error << std::endl;
+    return Check(passed, name);
+}
+
+// the X of each command run
+static std::vector<double> run_x_list(const std::string& code) {
+    rs274letter::Serializer s(rs274letter::Parser::parse(code));
+    s.processProgram();
+
+    std::vector<double> x_list;
+    for (auto&& command : s.getCommandList()) {
+        auto&& x = command.getNumbersOfLetter('x');
+        x_list.push_back(x ? x->front() : -1);
+    }
+    return x_list;
+}
+
+static int test_valid() {
+    int failed = 0;
+
+    // called before its definition, a break through an if inside a sub
+    {
+        auto x_list = run_x_list(
+            "o<line> call [1] [2]\n"
+            "o<line> sub\n"
+            "    o1 while [#1 lt 10]\n"
+            "        #1 = [#1 + #2]\n"
+            "        o2 if [#1 gt 5]\n"
+            "            o1 break\n"
+            "        o2 endif\n"
+            "    o1 endwhile\n"
+            "    G01 X#1\n"
+            "o<line> endsub\n");
+        failed += Check(x_list == std::vector<double>{ 7 }, "a sub called before its definition");
+    }
+
+    // an o-word calculated at runtime is not examined by the link pass
+    {
+        auto x_list = run_x_list(
+            "#50 = 3\n"
+            "o[#50] sub\n"
+            "    G01 X#1\n"
+            "o[#50] endsub\n"
+            "o3 call [4]\n"
+            "o[1 + 2] call [5]\n");
+        failed += Check(x_list == std::vector<double>{ 4, 5 }, "a sub of a dynamic o-word");
+    }
+
+    // the same sub o-word in a number index and in a constant expression
+    {
+        auto x_list = run_x_list(
+            "o[50 * 2] sub\n"
+            "    G01 X#1\n"
+            "o100 endsub\n"
+            "o100 call [6]\n");
+        failed += Check(x_list == std::vector<double>{ 6 }, "a constant expression o-word");
+    }
+
+    return failed;
+}
+
+int main() {
+    int failed = 0;
+
+    try {
+        for (auto&& c : s_case_list) {
+            failed += test_link_error(c);
+        }
+
+        failed += test_unparsed_statement("o1 while [1]\n    o1 break\no1 endwhile\n",
+            "break outside a loop", "oBreakStatement is not in a loop");
+        failed += test_unparsed_statement("o1 repeat [1]\n    o1 continue\no1 endrepeat\n",
+            "continue outside a loop", "oContinueStatement is not in a loop");
+        failed += test_unparsed_statement("o<a> sub\n    o<a> return\no<a> endsub\n",
+            "return outside a sub", "oReturnStatement is not in a sub");
+
+        failed += test_valid();
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        failed += 1;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <string>
+
+#include "rs274letter/Serializer.h"
+#include "check.h"
+
+using rs274letter::test::Check;
+
+// The bytes held by each component of a Serializer, the AST nodes per type,
+// and the peak bytes counted by a CountingMemoryResource.
+
+static const std::string s_code = R"(#<i> = 0
+o<hole> sub
+    G00 X#1 Y#2
+    G01 Z-1
+o<hole> endsub
+o1 while [#<i> LT 100]
+    #<i> = [#<i> + 1]
+    o<hole> call [#<i>] [0]
+o1 endwhile
+M30
+)";
+
+int main() {
+    int failed = 0;
+
+    try {
+        auto ast = rs274letter::Parser::parse(s_code);
+        auto ast_footprint = rs274letter::AstFootprint::Measure(ast);
+        auto&& type_count_map = ast_footprint.node_type_count_map;
+        failed += Check(type_count_map["program"] == 1, "1 program node");
+        failed += Check(type_count_map["commandStatement"] == 3, "3 commandStatement nodes");
+        failed += Check(type_count_map["oCallStatement"] == 1 && type_count_map["oWhileStatement"] == 1
+            && type_count_map["oSubStatement"] == 1, "1 call, while and sub node");
+        failed += Check(ast_footprint.bytes > ast_footprint.node_count * sizeof(rs274letter::AstObject),
+            "ast bytes");
+
+        auto program = rs274letter::Program::compile(std::move(ast));
+
+        rs274letter::CountingMemoryResource counting_resource;
+        rs274letter::Serializer s(&counting_resource);
+        s.reset(program);
+        s.setCheckpointInterval(50);
+
+        auto start_footprint = s.getMemoryFootprint();
+        failed += Check(start_footprint.program_bytes >= ast_footprint.bytes, "program bytes, with the link result");
+        failed += Check(start_footprint.ast.node_count == ast_footprint.node_count, "ast node count");
+        failed += Check(start_footprint.command_output_bytes == 0 && start_footprint.checkpoint_bytes == 0,
+            "nothing executed");
+
+        // stopped inside a call
+        s.step(51);
+        auto step_footprint = s.getMemoryFootprint();
+        failed += Check(step_footprint.frame_stack_bytes > 0, "frame stack bytes");
+        failed += Check(step_footprint.checkpoint_bytes > 0, "checkpoint bytes");
+        failed += Check(step_footprint.variable_bytes > 0, "variable bytes");
+
+        s.processProgram();
+        auto end_footprint = s.getMemoryFootprint();
+        std::cout << end_footprint.toString() << std::endl;
+        failed += Check(end_footprint.command_output_bytes
+            == 201 * (sizeof(rs274letter::CommandStatement) + 2 * sizeof(void*)), "command output bytes, 201 commands");
+        failed += Check(end_footprint.getTotalBytes() > end_footprint.program_bytes + end_footprint.command_output_bytes,
+            "total bytes");
+
+        // the command list and the runtime state are allocated from the counting resource
+        failed += Check(counting_resource.getPeakBytes() >= end_footprint.command_output_bytes
+            && counting_resource.getPeakBytes() >= counting_resource.getBytes(), "peak bytes");
+
+        auto peak_bytes = counting_resource.getPeakBytes();
+        s.reset(program);
+        failed += Check(counting_resource.getBytes() < peak_bytes, "bytes given back by reset()");
+        failed += Check(s.getMemoryFootprint().command_output_bytes == 0, "command output cleared by reset()");
+
+        counting_resource.resetPeak();
+        s.setCheckpointInterval(0);
+        s.processProgram();
+        failed += Check(counting_resource.getPeakBytes() < peak_bytes, "lower peak without checkpoints");
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
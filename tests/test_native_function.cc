@@ -0,0 +1,151 @@
+#include <iostream>
+#include <string>
+
+#include "rs274letter/AstValidator.h"
+#include "rs274letter/InsideFunction.h"
+#include "rs274letter/Program.h"
+#include "rs274letter/Serializer.h"
+#include "check.h"
+
+using rs274letter::test::Check;
+
+// RegisterNativeFunction: the rejected registrations leave the registry
+// unchanged, a call with the wrong number of params is rejected by the
+// Parser and by the AstValidator, and a Program keeps the native functions
+// registered when it was compiled.
+
+static double first_param(const double* params) {
+    return params[0];
+}
+
+// the message of the Exception thrown by f, or "" if none is thrown
+template <typename F>
+static std::string error_of(F&& f) {
+    try {
+        f();
+    } catch (rs274letter::Exception& e) {
+        return e.what();
+    }
+    return "";
+}
+
+static int test_rejected(const std::string& name, std::size_t arity, rs274letter::NativeFunctionCallback callback,
+    const std::string& message, const std::string& case_name) {
+    auto count = rs274letter::GetNativeFunctionList().size();
+    auto error = error_of([&]() { rs274letter::RegisterNativeFunction(name, arity, std::move(callback)); });
+
+    bool passed = error.find(message) != std::string::npos && rs274letter::GetNativeFunctionList().size() == count;
+    if (!passed) std::cout << error << std::endl;
+    return Check(passed, case_name);
+}
+
+// the X of the command produced by the program
+static double run_x(const rs274letter::Program::ptr& program) {
+    rs274letter::Serializer s(program);
+    s.processProgram();
+    return s.getCommandList().front().getNumbersOfLetter('x')->front();
+}
+
+static int test_registration() {
+    int failed = 0;
+
+    for (auto&& name : { "", "x", "2x", "my-f", "my f", "orbit", "nearest", "andy", "gt", "xor" }) {
+        failed += test_rejected(name, 1, first_param, "Invalid native function name: ",
+            "invalid name '" + std::string(name) + "'");
+    }
+
+    failed += test_rejected("sin", 1, first_param, "Inside function already exists: sin", "a built-in name");
+    failed += test_rejected("ATAN", 2, first_param, "Inside function already exists: ATAN", "a built-in name in upper case");
+    failed += test_rejected("exists", 1, first_param, "Inside function already exists: exists", "exists");
+
+    failed += test_rejected("zero", 0, first_param, "Invalid native function arity: 0", "arity 0");
+    failed += test_rejected("many", rs274letter::NativeFunction::kMaxArity + 1, first_param,
+        "Invalid native function arity: " + std::to_string(rs274letter::NativeFunction::kMaxArity + 1),
+        "arity over kMaxArity");
+    failed += test_rejected("empty", 1, nullptr, "Empty native function callback", "an empty callback");
+
+    // the first registration is kept
+    auto id = rs274letter::RegisterNativeFunction("Twice", 1, first_param);
+    failed += test_rejected("twice", 2, [](const double*) { return -1.0; },
+        "Inside function already exists: twice", "a duplicate");
+    auto twice = rs274letter::GetNativeFunction(id);
+    failed += Check(twice && twice->name == "twice" && twice->arity == 1
+        && rs274letter::GetInsideFunctionId("twice") == id
+        && run_x(rs274letter::Program::compile(rs274letter::Parser::parse("G01 X[twice[7]]\n"))) == 7,
+        "the duplicate leaves the first one");
+
+    auto max_id = rs274letter::RegisterNativeFunction("sum8", rs274letter::NativeFunction::kMaxArity,
+        [](const double* params) {
+            double sum = 0;
+            for (std::size_t i = 0; i < rs274letter::NativeFunction::kMaxArity; ++i) sum += params[i];
+            return sum;
+        });
+    failed += Check(rs274letter::IsNativeFunctionId(max_id)
+        && run_x(rs274letter::Program::compile(rs274letter::Parser::parse("G01 X[sum8[1][2][3][4][5][6][7][8]]\n"))) == 36,
+        "arity kMaxArity");
+
+    return failed;
+}
+
+static int test_call_arity() {
+    int failed = 0;
+
+    rs274letter::RegisterNativeFunction("blend", 3, [](const double* p) { return p[0] + (p[1] - p[0]) * p[2]; });
+
+    auto error = error_of([]() { rs274letter::Parser::parse("G01 X[blend[1][3]]\n"); });
+    failed += Check(error.find("SyntaxError") != std::string::npos
+        && error.find("Native function blend should have 3 params") != std::string::npos,
+        "the Parser rejects a call with too few params");
+
+    // an AST not built by the Parser
+    auto ast = rs274letter::Parser::parse("#1 = blend[1][3][0.5]\n");
+    auto&& call = ast["body"].as_array()[0].as_object()["expression"].as_object()["right"].as_object();
+    auto&& param_list = call["param"].as_array();
+    call["param"] = rs274letter::AstArray{ param_list[0], param_list[1] };
+
+    error = error_of([&]() { rs274letter::Program::compile(ast); });
+    failed += Check(error.find("AstValidateError") != std::string::npos
+        && error.find("The param of native function blend should be an array of 3 expressions") != std::string::npos,
+        "the AstValidator rejects a call with too few params");
+
+    call["functionId"] = rs274letter::INSIDE_FUNCTION_COUNT + static_cast<int>(rs274letter::GetNativeFunctionList().size());
+    error = error_of([&]() { rs274letter::Program::compile(ast); });
+    failed += Check(error.find("Unknown functionId of insideFunctionExpression") != std::string::npos,
+        "the AstValidator rejects an id not registered");
+
+    return failed;
+}
+
+static int test_compiled_before() {
+    int failed = 0;
+
+    auto error = error_of([]() { rs274letter::Parser::parse("G01 X[later[1]]\n"); });
+    failed += Check(error.find("SyntaxError") != std::string::npos, "a call parsed before the registration");
+
+    auto program = rs274letter::Program::compile(rs274letter::Parser::parse("G01 X[blend[1][3][0.5]]\n"));
+    auto count = program->getNativeFunctionList().size();
+
+    rs274letter::RegisterNativeFunction("later", 1, [](const double* p) { return p[0] * 10; });
+
+    failed += Check(program->getNativeFunctionList().size() == count && run_x(program) == 2,
+        "a Program compiled before a registration keeps its native functions");
+    failed += Check(run_x(rs274letter::Program::compile(rs274letter::Parser::parse("G01 X[later[blend[1][3][0.5]]]\n"))) == 20,
+        "a Program compiled after it calls both");
+
+    return failed;
+}
+
+int main() {
+    int failed = 0;
+
+    try {
+        failed += test_registration();
+        failed += test_call_arity();
+        failed += test_compiled_before();
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        failed += 1;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rs274letter/Serializer.h"
+#include "check.h"
+
+using rs274letter::test::Check;
+
+// An o-return inside the loops and the ifs of a sub leaves all of them.
+// The expected commands of the while and if programs are the output of
+// the serializer before the frame stack. That serializer had no o-repeat
+// and no o-elseif, so those variants expect the output of their while and
+// if-else equivalents. It could not call a sub from a sub either, so that
+// case expects commands worked out by hand.
+
+// P1, a return inside a while
+static const char* s_return_in_while = R"(
+o<f> sub
+    #1 = 0
+    o1 while [#1 lt 10]
+        #1 = [#1 + 1]
+        G01 X#1
+        o2 if [#1 eq 3]
+            o<f> return [#1 * 10]
+        o2 endif
+    o1 endwhile
+    G01 Y99
+o<f> endsub [-1]
+o<f> call
+G01 Z#<_value>
+)";
+
+// P2, the return is taken or not, the caller loops around the call
+static const char* s_return_in_called_loop = R"(
+o<g> sub
+    #2 = 0
+    o1 while [#2 lt 5]
+        #2 = [#2 + 1]
+        G01 X#2
+        o2 if [#2 ge #1]
+            o<g> return [#2 * 100]
+        o2 endif
+    o1 endwhile
+    G01 Y#2
+o<g> endsub [#2 * -1]
+#<_n> = 0
+#<_i> = 0
+o10 while [#<_i> lt 4]
+    #<_i> = [#<_i> + 1]
+    #<_n> = [#<_n> + 2]
+    o<g> call [#<_n>]
+    G01 A#<_value> B#<_value_returned>
+o10 endwhile
+G01 C#<_n>
+)";
+
+// P2 with repeat loops
+static const char* s_return_in_called_repeat = R"(
+o<g> sub
+    #2 = 0
+    o1 repeat [5]
+        #2 = [#2 + 1]
+        G01 X#2
+        o2 if [#2 ge #1]
+            o<g> return [#2 * 100]
+        o2 endif
+    o1 endrepeat
+    G01 Y#2
+o<g> endsub [#2 * -1]
+#<_n> = 0
+#<_i> = 0
+o10 repeat [4]
+    #<_i> = [#<_i> + 1]
+    #<_n> = [#<_n> + 2]
+    o<g> call [#<_n>]
+    G01 A#<_value> B#<_value_returned>
+o10 endrepeat
+G01 C#<_n>
+)";
+
+// P3, returns with and without a value inside nested ifs inside a while
+static const char* s_return_in_nested_if = R"(
+o<inner> sub
+    #3 = 0
+    o1 while [1]
+        #3 = [#3 + 1]
+        o3 if [#3 gt 100]
+            G01 X-1
+        o3 else
+            o5 if [#3 eq #1]
+                o4 if [#2 gt 0]
+                    G01 X#3 Y#2
+                    o<inner> return [#3 + #2]
+                o4 else
+                    G01 X#3 Y0
+                    o<inner> return
+                o4 endif
+            o5 else
+                G01 Z#3
+            o5 endif
+        o3 endif
+    o1 endwhile
+o<inner> endsub
+#<_i> = 0
+o10 while [#<_i> lt 3]
+    #<_i> = [#<_i> + 1]
+    o<inner> call [#<_i> + 1] [#<_i> - 2]
+    G01 A#<_i> B#<_value_returned>
+o10 endwhile
+)";
+
+// P3 with an elseif and a repeat loop
+static const char* s_return_in_elseif = R"(
+o<inner> sub
+    #3 = 0
+    o1 repeat [1000]
+        #3 = [#3 + 1]
+        o3 if [#3 gt 100]
+            G01 X-1
+        o3 elseif [#3 eq #1]
+            o4 if [#2 gt 0]
+                G01 X#3 Y#2
+                o<inner> return [#3 + #2]
+            o4 else
+                G01 X#3 Y0
+                o<inner> return
+            o4 endif
+        o3 else
+            G01 Z#3
+        o3 endif
+    o1 endrepeat
+o<inner> endsub
+#<_i> = 0
+o10 while [#<_i> lt 3]
+    #<_i> = [#<_i> + 1]
+    o<inner> call [#<_i> + 1] [#<_i> - 2]
+    G01 A#<_i> B#<_value_returned>
+o10 endwhile
+)";
+
+// a return from the callee's loop keeps the loop of the caller sub
+static const char* s_return_from_sub_in_sub = R"(
+o<inner> sub
+    #1 = 0
+    o1 repeat [10]
+        #1 = [#1 + 1]
+        #<_k> = [#<_k> + 1]
+        o2 if [#1 eq 3]
+            o<inner> return [#<_k>]
+        o2 endif
+    o1 endrepeat
+o<inner> endsub
+o<outer> sub
+    #1 = 0
+    o3 while [1]
+        #1 = [#1 + 1]
+        o<inner> call
+        G01 X#<_value> Y#1
+        o4 if [#1 ge 2]
+            o<outer> return [#1 * 10]
+        o4 endif
+    o3 endwhile
+o<outer> endsub
+#<_k> = 0
+o<outer> call
+G01 Z#<_value>
+o<outer> call
+G01 Z#<_value>
+)";
+
+// each command as its letters and numbers, e.g. "G1X3"
+static std::vector<std::string> run(const std::string& code) {
+    rs274letter::Serializer s(rs274letter::Parser::parse(code));
+    s.processProgram();
+
+    std::vector<std::string> command_list;
+    for (auto&& command : s.getCommandList()) {
+        std::stringstream ss;
+        for (char letter = 'A'; letter <= 'Z'; ++letter) {
+            if (auto&& number_list = command.getNumbersOfLetter(letter)) {
+                for (auto&& number : *number_list) ss << letter << number;
+            }
+        }
+        command_list.push_back(ss.str());
+    }
+    return command_list;
+}
+
+static int test_program(const char* code, const std::vector<std::string>& expected, const std::string& name) {
+    std::vector<std::string> command_list;
+    try {
+        command_list = run(code);
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        return Check(false, name);
+    }
+
+    bool passed = command_list == expected;
+    if (!passed) {
+        for (auto&& command : command_list) std::cout << command << " ";
+        std::cout << std::endl;
+    }
+    return Check(passed, name);
+}
+
+int main() {
+    int failed = 0;
+
+    failed += test_program(s_return_in_while,
+        { "G1X1", "G1X2", "G1X3", "G1Z30" }, "a return inside a while");
+
+    const std::vector<std::string> called_loop_expected = {
+        "G1X1", "G1X2", "A200B1G1",
+        "G1X1", "G1X2", "G1X3", "G1X4", "A400B1G1",
+        "G1X1", "G1X2", "G1X3", "G1X4", "G1X5", "G1Y5", "A-5B1G1",
+        "G1X1", "G1X2", "G1X3", "G1X4", "G1X5", "G1Y5", "A-5B1G1",
+        "C8G1" };
+    failed += test_program(s_return_in_called_loop, called_loop_expected, "a return inside a while, called in a while");
+    failed += test_program(s_return_in_called_repeat, called_loop_expected, "a return inside a repeat, called in a repeat");
+
+    const std::vector<std::string> nested_if_expected = {
+        "G1Z1", "G1X2Y0", "A1B0G1",
+        "G1Z1", "G1Z2", "G1X3Y0", "A2B0G1",
+        "G1Z1", "G1Z2", "G1Z3", "G1X4Y1", "A3B1G1" };
+    failed += test_program(s_return_in_nested_if, nested_if_expected, "a return inside nested ifs");
+    failed += test_program(s_return_in_elseif, nested_if_expected, "a return inside an elseif inside a repeat");
+
+    failed += test_program(s_return_from_sub_in_sub,
+        { "G1X3Y1", "G1X6Y2", "G1Z20", "G1X9Y1", "G1X12Y2", "G1Z20" }, "a return from a sub called in a loop of a sub");
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <string>
+
+#include "rs274letter/Program.h"
+#include "rs274letter/Serializer.h"
+#include "check.h"
+
+using rs274letter::test::Check;
+
+// The limits of the Parser and the Tokenizer: the o-blocks nest up to
+// kMaxNestingDepth, a long chain of `elseif` is not a nesting, and a token
+// of kMaxTokenLength chars is accepted, a longer one is rejected.
+
+// the message of the Exception thrown by running the code, or "" if none is thrown
+static std::string run_error(const std::string& code, std::size_t* command_count = nullptr) {
+    try {
+        rs274letter::Serializer s(rs274letter::Program::compile(rs274letter::Parser::parse(code)));
+        s.processProgram();
+        if (command_count) *command_count = s.getCommandCount();
+    } catch (rs274letter::Exception& e) {
+        return e.what();
+    }
+    return "";
+}
+
+// `depth` nested o-ifs with a command in the innermost one
+static std::string nested_if_code(std::size_t depth) {
+    std::string code;
+    for (std::size_t i = 1; i <= depth; ++i) code += "o" + std::to_string(i) + " if [1]\n";
+    code += "G01 X1\n";
+    for (std::size_t i = depth; i >= 1; --i) code += "o" + std::to_string(i) + " endif\n";
+    return code;
+}
+
+// an o-if of `count` branches, the one taken is the `taken`th
+static std::string elseif_code(std::size_t count, std::size_t taken) {
+    std::string code = "#1 = " + std::to_string(taken) + "\no1 if [#1 eq 1]\nG01 X1\n";
+    for (std::size_t i = 2; i <= count; ++i) {
+        code += "o1 elseif [#1 eq " + std::to_string(i) + "]\nG01 X" + std::to_string(i) + "\n";
+    }
+    code += "o1 else\nG01 X-1\no1 endif\n";
+    return code;
+}
+
+static int test_nesting() {
+    int failed = 0;
+
+    // the program body and the bracket of the innermost test count one level each
+    const auto max_depth = rs274letter::Parser::kMaxNestingDepth;
+    std::size_t command_count = 0;
+    auto error = run_error(nested_if_code(max_depth - 2), &command_count);
+    failed += Check(error.empty() && command_count == 1, "o-ifs nested kMaxNestingDepth - 2 deep");
+    if (!error.empty()) std::cout << error << std::endl;
+
+    error = run_error(nested_if_code(max_depth));
+    failed += Check(error.find("Nesting deeper than " + std::to_string(max_depth) + " levels") != std::string::npos,
+        "o-ifs nested kMaxNestingDepth deep");
+
+    for (std::size_t taken : { 1, 2, 1000, 2000, 2001 }) {
+        rs274letter::Serializer s(rs274letter::Program::compile(rs274letter::Parser::parse(elseif_code(2000, taken))));
+        s.processProgram();
+        auto x = s.getCommandList().front().getNumbersOfLetter('x')->front();
+        auto count = s.getCommandCount();
+        failed += Check(count == 1 && x == (taken > 2000 ? -1.0 : static_cast<double>(taken)),
+            "an o-if of 2000 branches, taking " + std::to_string(taken));
+    }
+
+    return failed;
+}
+
+static int test_token_length() {
+    int failed = 0;
+
+    const auto max_length = rs274letter::Tokenizer::kMaxTokenLength;
+
+    // a name token of `length` chars, `<` and `>` included
+    auto var_code = [](std::size_t length) {
+        auto name = "<" + std::string(length - 2, 'a') + ">";
+        return "#" + name + " = 1\nG01 X#" + name + "\n";
+    };
+
+    auto error = run_error(var_code(max_length));
+    failed += Check(error.empty(), "a token of kMaxTokenLength chars");
+    if (!error.empty()) std::cout << error << std::endl;
+
+    error = run_error(var_code(max_length + 1));
+    failed += Check(error.find("Token longer than " + std::to_string(max_length) + " chars") != std::string::npos,
+        "a token of kMaxTokenLength + 1 chars");
+
+    return failed;
+}
+
+int main() {
+    int failed = 0;
+
+    try {
+        failed += test_nesting();
+        failed += test_token_length();
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        failed += 1;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "rs274letter/Serializer.h"
+#include "check.h"
+
+using rs274letter::test::Check;
+
+// The executions counted by the ExecutionProfiler for each line and sub,
+// and the reports of a run.
+
+static const std::string s_code = R"(#<i> = 0
+o<hole> sub
+    G00 X#1 Y#2
+    G01 Z-1
+o<hole> endsub
+o1 while [#<i> LT 10]
+    #<i> = [#<i> + 1]
+    o2 if [#<i> GT 5]
+        o<hole> call [#<i>] [0]
+    o2 endif
+o1 endwhile
+M30
+)";
+
+int main() {
+    int failed = 0;
+
+    try {
+        auto program = rs274letter::Program::compile(rs274letter::Parser::parse(s_code));
+        auto profiler = std::make_shared<rs274letter::ExecutionProfiler>(1);
+
+        rs274letter::Serializer s(program);
+        s.setProfiler(profiler);
+        s.processProgram();
+
+        std::map<int, std::uint64_t> count_map;
+        for (auto&& line_stat : profiler->getLineStatList()) {
+            count_map[line_stat.line] = line_stat.count;
+        }
+
+        failed += Check(count_map[1] == 1, "line 1, executed once");
+        failed += Check(count_map[2] == 1, "line 2, the sub definition once");
+        failed += Check(count_map[3] == 5 && count_map[4] == 5, "line 3, 4, the sub body 5 times");
+        // entered once, then 11 tests
+        failed += Check(count_map[6] == 12, "line 6, the while statement and its tests");
+        failed += Check(count_map[7] == 10 && count_map[8] == 10, "line 7, 8, the loop body 10 times");
+        failed += Check(count_map[9] == 5, "line 9, the call 5 times");
+        failed += Check(count_map[12] == 1, "line 12, M30 once");
+        failed += Check(count_map.count(5) == 0 && count_map.count(10) == 0, "no endsub, endif line");
+
+        auto sub_stat_list = profiler->getSubStatList();
+        failed += Check(sub_stat_list.size() == 1 && sub_stat_list[0].name == "o<hole>"
+            && sub_stat_list[0].line == 2 && sub_stat_list[0].calls == 5 && sub_stat_list[0].count == 10,
+            "o<hole>, 5 calls, 10 statements");
+
+        failed += Check(profiler->getTotalTimeNs() > 0, "timed with sample interval 1");
+
+        // the counters add up over the runs of the same program
+        s.reset(program);
+        s.processProgram();
+        failed += Check(profiler->getSubStatList()[0].calls == 10, "two runs, 10 calls");
+
+        // the same commands without the profiler
+        rs274letter::Serializer plain(program);
+        plain.processProgram();
+        failed += Check(plain.getCommandList().size() == s.getCommandList().size(), "the same commands");
+
+        // another program clears the counters
+        s.reset(rs274letter::Program::compile(rs274letter::Parser::parse("G01 X1\nG01 X2\n")));
+        s.processProgram();
+        failed += Check(profiler->getTotalCount() == 2 && profiler->getSubStatList().empty(), "another program");
+
+        // set after a checkpoint, the execution restarts from it
+        rs274letter::Serializer restarted(program);
+        restarted.setCheckpointInterval(2);
+        restarted.processProgram();
+        auto late_profiler = std::make_shared<rs274letter::ExecutionProfiler>(4);
+        restarted.setProfiler(late_profiler);
+        restarted.restartFromCommand(6);
+        restarted.processProgram();
+        failed += Check(late_profiler->getTotalCount() > 0 && late_profiler->getSubStatList()[0].calls < 5,
+            "restarted from a checkpoint");
+
+        s.reset(program);
+        s.processProgram();
+        std::cout << profiler->toHotLineReport(s_code) << std::endl;
+        auto listing = profiler->toAnnotatedListing(s_code);
+        std::cout << listing << std::endl;
+        failed += Check(std::count(listing.begin(), listing.end(), '\n') == 12, "12 lines in the listing");
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "rs274letter/Serializer.h"
+#include "rs274letter/util.h"
+#include "check.h"
+
+// Restart-from-command latency, with and without checkpoints.
+// With checkpoints the latency should stay flat as the command index grows:
+// the commands executed by a restart are bounded by the interval, checked
+// with an ExecutionBudget of that many commands. bench/bench_restart times it.
+// The output resumed from a checkpoint inside a loop, and inside a sub
+// called from a sub, is the same as the output of a full run.
+
+using rs274letter::test::Check;
+
+static rs274letter::AstObject make_program() {
+    std::string code = R"(
+        #<row> = 0
+        o1 while [#<row> LT 200]
+            #<row> = [#<row> + 1]
+            #<col> = 0
+            #<odd> = 0
+            o2 while [#<col> LT 500]
+                #<col> = [#<col> + 1]
+                #<odd> = [1 - #<odd>]
+                o3 if [#<odd> EQ 0]
+                    G01 X[#<col> * 0.1] Y[#<row> * 0.1] F[1000 + sin[#<col>]]
+                o3 else
+                    G01 X[#<col> * 0.1] Y[#<row> * 0.1 + 0.05]
+                o3 endif
+            o2 endwhile
+        o1 endwhile
+    )";
+
+    return rs274letter::Parser::parse(code);
+}
+
+// the commands are produced in a repeat loop of a sub, which is called in
+// a while loop of another sub, each checkpoint is inside both calls
+static rs274letter::AstObject make_sub_program() {
+    std::string code = R"(
+        o<row> sub
+            #3 = 0
+            o1 repeat [#1]
+                #3 = [#3 + 1]
+                #<_total> = [#<_total> + #3]
+                G01 X[#3 * 0.1] Y#<_total> F[#1 + #2]
+            o1 endrepeat
+        o<row> endsub [#3]
+        o<layer> sub
+            #3 = 0
+            o2 while [#3 lt 20]
+                #3 = [#3 + 1]
+                o<row> call [30 + #3] [#1]
+                G00 Z[#<_value> + #1]
+            o2 endwhile
+        o<layer> endsub
+        #<_total> = 0
+        #<_layer> = 0
+        o3 while [#<_layer> lt 5]
+            #<_layer> = [#<_layer> + 1]
+            o<layer> call [#<_layer>]
+        o3 endwhile
+    )";
+
+    return rs274letter::Parser::parse(code);
+}
+
+static std::size_t restart_latency(rs274letter::Serializer& s, std::size_t command_index) {
+    rs274letter::util::ElapsedTimer timer("", false);
+    s.restartFromCommand(command_index);
+    return timer.elapsed();
+}
+
+// resumed at each command index, the rest of the output equals the full run
+static int test_resumed_output(const rs274letter::AstObject& program, std::size_t checkpoint_interval,
+    const std::vector<std::size_t>& command_index_list, const std::string& name) {
+    rs274letter::Serializer full(program);
+    full.processProgram();
+    auto&& full_list = full.getCommandList();
+
+    std::vector<std::string> resumed_list;
+    rs274letter::Serializer checkpointed(program);
+    checkpointed.setCommandSink(std::make_shared<rs274letter::CallbackCommandSink>(
+        [&resumed_list](const rs274letter::CommandStatement& cs) { resumed_list.push_back(cs.toString()); }));
+    checkpointed.setCheckpointInterval(checkpoint_interval);
+    checkpointed.processProgram();
+    if (checkpointed.getCheckpointCount() < 2) return Check(false, name + ", no checkpoint recorded");
+
+    int failed = 0;
+    for (auto command_index : command_index_list) {
+        resumed_list.clear();
+        checkpointed.restartFromCommand(command_index);
+        checkpointed.processProgram();
+
+        bool is_same = resumed_list.size() == full_list.size() - command_index;
+        auto full_it = std::next(full_list.begin(), command_index);
+        for (auto it = resumed_list.begin(); is_same && it != resumed_list.end(); ++it, ++full_it) {
+            is_same = *it == full_it->toString();
+        }
+        failed += Check(is_same, name + ", from command " + std::to_string(command_index));
+    }
+    return failed;
+}
+
+// with a checkpoint every `interval` commands, a restart from any index executes
+// fewer than `interval` commands, without checkpoints the far ones execute more
+static int test_restart_work(const rs274letter::AstObject& program, std::size_t interval,
+    const std::vector<std::size_t>& command_index_list) {
+    rs274letter::ExecutionBudget budget;
+    budget.max_commands = interval;
+    budget.max_single_loop_iterations = 0;
+
+    rs274letter::Serializer plain(program);
+    plain.setExecutionBudget(budget);
+    rs274letter::Serializer checkpointed(program);
+    checkpointed.setCommandSink(std::make_shared<rs274letter::CallbackCommandSink>(
+        [](const rs274letter::CommandStatement&) {}));
+    checkpointed.setCheckpointInterval(interval);
+    checkpointed.processProgram();
+    checkpointed.setExecutionBudget(budget);
+
+    auto restart_error = [](rs274letter::Serializer& s, std::size_t command_index) -> std::string {
+        try {
+            s.restartFromCommand(command_index);
+        } catch (rs274letter::SerializerError& e) {
+            return e.what();
+        }
+        return "";
+    };
+
+    int failed = 0;
+    for (auto command_index : command_index_list) {
+        auto error = restart_error(checkpointed, command_index);
+        if (!error.empty()) std::cout << error << std::endl;
+        failed += Check(error.empty(), "the restart from command " + std::to_string(command_index)
+            + " executes fewer than " + std::to_string(interval) + " commands");
+    }
+
+    auto error = restart_error(plain, command_index_list.back());
+    failed += Check(error.find("Execution budget exhausted: commands") != std::string::npos,
+        "the restart without checkpoints executes more");
+    return failed;
+}
+
+int main(int argc, char** argv) {
+    int failed = 0;
+
+    try {
+        auto program = make_program();
+
+        rs274letter::Serializer plain(program);
+        rs274letter::Serializer checkpointed(program);
+        checkpointed.setCheckpointInterval(1000);
+
+        std::size_t command_count = 0;
+        {
+            rs274letter::util::ElapsedTimer timer("first run with checkpoints");
+            auto sink = std::make_shared<rs274letter::CallbackCommandSink>(
+                [&command_count](const rs274letter::CommandStatement&) { ++command_count; });
+            checkpointed.setCommandSink(sink);
+            checkpointed.processProgram();
+            checkpointed.setCommandSink(nullptr);
+        }
+        std::cout << "commands: " << command_count 
+                  << ", checkpoints: " << checkpointed.getCheckpointCount() << std::endl;
+
+        // half of the interval after a checkpoint, the worst case
+        std::cout << "command_index\tno checkpoint(us)\tcheckpoint(us)" << std::endl;
+        for (std::size_t command_index : {1500ul, 10500ul, 25500ul, 50500ul, 75500ul, 99500ul}) {
+            auto plain_us = restart_latency(plain, command_index);
+            auto checkpoint_us = restart_latency(checkpointed, command_index);
+            std::cout << command_index << "\t" << plain_us << "\t" << checkpoint_us << std::endl;
+        }
+
+        // the resumed output is the same as the output of a full run
+        rs274letter::Serializer full(program);
+        full.processProgram();
+        auto&& full_list = full.getCommandList();
+        auto full_it = std::next(full_list.begin(), 12345);
+
+        checkpointed.restartFromCommand(12345);
+        checkpointed.step(1000);
+        bool is_same = checkpointed.getCommandList().size() == 1000;
+        for (const auto& cs : checkpointed.getCommandList()) {
+            is_same = is_same && cs.toString() == (full_it++)->toString();
+        }
+        failed += Check(is_same, "1000 commands resumed from command 12345 same as a full run");
+
+        failed += test_restart_work(program, 1000, { 999, 1500, 25500, 50999, 75500, 99999 });
+
+        // a checkpoint in the nested while loops and in the if inside them
+        failed += test_resumed_output(program, 1000, { 0, 999, 1000, 1001, 12345, 99999 }, "nested loops");
+
+        // a checkpoint inside the repeat loop of a sub called from a sub, and
+        // the commands right after the return of each (a row is 31 to 50
+        // commands and a G00, a layer 830 commands)
+        failed += test_resumed_output(make_sub_program(), 100, { 1, 31, 32, 150, 829, 830, 831, 3199, 4149 },
+            "a sub called from a sub");
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        failed += 1;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "rs274letter/Serializer.h"
+
+// One Program executed by many Serializers on many threads, each with its
+// own initial variables. The output of each thread is compared with the
+// same run on the main thread.
+// Build with -DRS274LETTER_SANITIZE_THREAD=ON to run it under ThreadSanitizer.
+
+// each Serializer has its own runtime state and its own default CommandListSink
+static_assert(!std::is_copy_constructible_v<rs274letter::Serializer>
+    && !std::is_copy_assignable_v<rs274letter::Serializer>, "a Serializer is not copyable");
+
+static const int s_thread_count = 16;
+static const int s_runs_per_thread = 20;
+
+static const char* s_code = R"(
+    o<corner> sub
+        G01 X[#1 + #<_offset>] Y[#2 + #<_offset>]
+    o<corner> endsub [#1 * #2]
+
+    #<i> = 0
+    #<area> = 0
+    o1 while [#<i> LT 20]
+        #<i> = [#<i> + 1]
+        o<corner> call [#1 * #<i>] [#<i>]
+        #<area> = [#<area> + #<_value>]
+        o2 if [#<i> GT 15]
+            G00 Z[blend[0][#<area>][0.5]]
+        o2 endif
+    o1 endwhile
+)";
+
+// run the program with the initial variables of the seed, the step size
+// changes how the execution is paused and resumed
+static std::string run(rs274letter::Serializer& s, const rs274letter::Program::ptr& program,
+    int seed, std::size_t step_size) {
+    s.reset(program, rs274letter::Serializer::ResetMode::KEEP_CAPACITY);
+    s.setInitialVariable(1, seed);
+    s.setInitialVariable("_offset", seed * 0.5);
+
+    while (s.step(step_size)) {}
+
+    std::stringstream ss;
+    ss << std::setprecision(10);
+    for (auto&& command : s.getCommandList()) {
+        ss << command.toString() << "\n";
+    }
+    return ss.str();
+}
+
+int main() {
+    rs274letter::Program::ptr program;
+    std::vector<std::string> expected_list(s_thread_count);
+    try {
+        // called from all the threads, so it should be thread-safe itself
+        rs274letter::RegisterNativeFunction("blend", 3, [](const double* p) {
+            return p[0] + (p[1] - p[0]) * p[2];
+        });
+
+        program = rs274letter::Program::compile(rs274letter::Parser::parse(s_code));
+
+        rs274letter::Serializer s;
+        for (int t = 0; t < s_thread_count; ++t) {
+            expected_list[t] = run(s, program, t + 1, std::numeric_limits<std::size_t>::max());
+        }
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<int> mismatch_list(s_thread_count, 0);
+    std::vector<std::thread> thread_list;
+    for (int t = 0; t < s_thread_count; ++t) {
+        thread_list.emplace_back([&, t]() {
+            try {
+                rs274letter::Serializer s;
+                for (int r = 0; r < s_runs_per_thread; ++r) {
+                    if (run(s, program, t + 1, 1 + (t + r) % 7) != expected_list[t]) {
+                        ++mismatch_list[t];
+                    }
+                }
+            } catch (rs274letter::Exception& e) {
+                std::cout << e.what() << std::endl;
+                mismatch_list[t] = s_runs_per_thread;
+            }
+        });
+    }
+    for (auto& thread : thread_list) {
+        thread.join();
+    }
+
+    int mismatch_count = 0;
+    for (int t = 0; t < s_thread_count; ++t) {
+        mismatch_count += mismatch_list[t];
+    }
+
+    std::cout << "threads: " << s_thread_count << ", runs: " << s_thread_count * s_runs_per_thread
+              << ", mismatches: " << mismatch_count << std::endl;
+    return mismatch_count == 0 ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <cstdio>
+
+#include "rs274letter/Serializer.h"
+#include "check.h"
+
+using rs274letter::test::Check;
+
+// The counters of the Tokenizer, Parser and Serializer, the GlobalStats
+// and the Prometheus text file written by the StatsFileExporter.
+
+static const std::string s_code = R"(#<i> = 0
+o<hole> sub
+    G00 X#1 Y#2
+    G01 Z-1
+o<hole> endsub
+o1 while [#<i> LT 10]
+    #<i> = [#<i> + 1]
+    o2 if [#<i> GT 5]
+        o<hole> call [#<i>] [0]
+    o2 endif
+o1 endwhile
+M30)";
+
+static std::string read_file(const std::string& path) {
+    std::ifstream ifs(path);
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    return ss.str();
+}
+
+int main() {
+    int failed = 0;
+
+    try {
+        rs274letter::GlobalStats::Reset();
+
+        std::string tokenizer_code = "G01 X1 (move)\nG01 X2";
+        rs274letter::Tokenizer tokenizer(tokenizer_code.cbegin(), tokenizer_code.cend());
+        while (!tokenizer.getNextToken().empty()) {}
+        auto tokenizer_stats = tokenizer.getStats();
+        // G 01 X 1 RTN G 01 X 2, without the spaces and the comment
+        failed += Check(tokenizer_stats.tokens == 9, "tokenizer tokens");
+        failed += Check(tokenizer_stats.lines == 2, "tokenizer lines, the last one without a newline");
+        failed += Check(tokenizer_stats.bytes == tokenizer_code.size(), "tokenizer bytes");
+
+        rs274letter::ParserStats parser_stats;
+        auto program = rs274letter::Program::compile(rs274letter::Parser::parse(s_code, parser_stats));
+        failed += Check(parser_stats.programs == 1, "parser programs");
+        // 4 in the program body, 2 in the sub, 2 in the while, 1 in the if
+        failed += Check(parser_stats.statements == 9, "parser statements");
+        failed += Check(parser_stats.lines == 12, "parser lines");
+        failed += Check(parser_stats.bytes == s_code.size(), "parser bytes");
+        failed += Check(parser_stats.tokens > 50, "parser tokens");
+
+        rs274letter::Serializer s(program);
+        s.processProgram();
+        auto&& stats = s.getStats();
+        failed += Check(stats.programs == 1, "serializer programs");
+        failed += Check(stats.o_calls == 5, "serializer o-calls");
+        failed += Check(stats.loop_iterations == 10, "serializer loop iterations");
+        // 2 commands in each call, and M30
+        failed += Check(stats.commands == 11, "serializer commands");
+        // `#<i> = 0` and the 10 increments
+        failed += Check(stats.variable_writes == 11, "serializer variable writes");
+        // 11 tests, 10 increments, 10 if tests, 5 call params, 10 in the sub body
+        failed += Check(stats.variable_reads == 46, "serializer variable reads");
+        failed += Check(stats.statements > 30 && stats.expressions > stats.variable_reads, "serializer statements and expressions");
+
+        // kept by reset(), added up over the runs
+        auto first_stats = stats;
+        s.reset(program);
+        s.processProgram();
+        failed += Check(s.getStats().commands == 2 * first_stats.commands
+            && s.getStats().expressions == 2 * first_stats.expressions, "serializer stats kept by reset()");
+
+        auto global_stats = rs274letter::GlobalStats::Get();
+        failed += Check(global_stats.parser.programs == 1 && global_stats.parser.bytes == s_code.size(),
+            "global parser stats, without the tokenizer used alone");
+        failed += Check(global_stats.serializer.commands == 22 && global_stats.serializer.programs == 2,
+            "global serializer stats, published by each step");
+
+        // a step stopped by max_commands publishes what it has done
+        s.resetStats();
+        s.reset(program);
+        s.step(3);
+        failed += Check(s.getStats().commands == 3
+            && rs274letter::GlobalStats::Get().serializer.commands == 25, "global stats after a partial step");
+
+        auto text = rs274letter::GlobalStats::ToPrometheusText();
+        failed += Check(text.find("# TYPE rs274letter_commands_total counter\nrs274letter_commands_total 25\n")
+            != std::string::npos, "prometheus text");
+
+        std::string path = "test_stats.prom";
+        {
+            rs274letter::StatsFileExporter exporter(path, std::chrono::milliseconds(10));
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            s.processProgram(); // 8 more commands, written at the stop
+            exporter.stop();
+            failed += Check(exporter.getWriteCount() >= 2 && exporter.getFailureCount() == 0, "exporter writes");
+        }
+        auto file_text = read_file(path);
+        failed += Check(file_text.find("rs274letter_commands_total 33\n") != std::string::npos,
+            "exporter file, written at the stop");
+        failed += Check(!std::ifstream(path + ".tmp").is_open(), "no temporary file left");
+        std::remove(path.c_str());
+
+        {
+            rs274letter::StatsFileExporter exporter("no_such_dir/test_stats.prom", std::chrono::milliseconds(10));
+            exporter.stop();
+            failed += Check(exporter.getFailureCount() == 1, "exporter failure counted");
+        }
+
+        std::cout << text << std::endl;
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+#include <iostream>
+#include <memory_resource>
+#include <string>
+
+#include "rs274letter/Serializer.h"
+
+#include "allocation_counter.h"
+
+// The execute loop allocates nothing once it is warm. Each program runs a
+// loop producing one command per iteration into a streaming sink: after
+// s_warm_iterations the next s_measured_iterations must not allocate.
+// The sub calls too, on the global heap and on a pool resource: the local
+// variables of a call are recycled by the pool of the Serializer.
+// Returns 1 if any loop allocates more than its case allows.
+
+static const std::size_t s_warm_iterations = 1000;
+static const std::size_t s_measured_iterations = 50000;
+
+struct Case {
+    const char* name;
+    const char* code;
+    bool pool_resource; // run on a pool resource instead of the global heap
+    std::size_t max_allocations_per_iteration;
+};
+
+static const char* s_sub_call_code = R"(o<move> sub
+    #<local> = [#1 * 0.5]
+    G01 X#<local> Y[#2 + 1]
+    o<move> return [#<local>]
+o<move> endsub
+#<i> = 0
+o1 while [#<i> lt 100000]
+    #<i> = [#<i> + 1]
+    o<move> call [#<i>] [#<_value>]
+o1 endwhile
+)";
+
+// a sub calling a sub, the local variables of both are alive together
+static const char* s_nested_sub_call_code = R"(o<inner> sub
+    #<scaled> = [#1 * #2]
+    G01 X#<scaled>
+o<inner> endsub [#<scaled>]
+o<outer> sub
+    #<half> = [#1 * 0.5]
+    o<inner> call [#<half>] [2]
+o<outer> endsub [#<_value>]
+#<i> = 0
+o1 while [#<i> lt 100000]
+    #<i> = [#<i> + 1]
+    o<outer> call [#<i>]
+o1 endwhile
+)";
+
+static const Case s_case_list[] = {
+    {"number-indexed counter", R"(#1 = 0
+o1 while [#1 lt 100000]
+    #1 = [#1 + 1]
+    G01 X#1
+o1 endwhile
+)", false, 0},
+
+    {"name-indexed variables and built-in functions", R"(#<i> = 0
+#<sum> = 0
+o1 while [#<i> lt 100000]
+    #<i> = [#<i> + 1]
+    #<sum> = [#<sum> + sin[#<i>] * cos[#<i>]]
+    G01 X[#<i> * 0.1] Y[abs[#<sum>]] F[1000 + #<i> / 7]
+o1 endwhile
+)", false, 0},
+
+    {"native functions", R"(#<i> = 0
+o1 while [#<i> lt 100000]
+    #<i> = [#<i> + 1]
+    G01 X[blend[0][#<i>][0.25]] Y[blend[#<i>][0][blend[0][1][0.5]]]
+o1 endwhile
+)", false, 0},
+
+    {"nested repeat, if and else", R"(#<n> = 0
+o1 repeat [1000]
+    o2 repeat [100]
+        #<n> = [#<n> + 1]
+        o3 if [#<n> GT 50000]
+            G00 Z[#<n> / 10]
+        o3 else
+            G01 X[#<n>]
+        o3 endif
+    o2 endrepeat
+o1 endrepeat
+)", false, 0},
+
+    {"sub call on a pool resource", s_sub_call_code, true, 0},
+    {"sub call on the global heap", s_sub_call_code, false, 0},
+    {"nested sub calls on the global heap", s_nested_sub_call_code, false, 0},
+};
+
+static int run_case(const Case& c) {
+    std::size_t command_count = 0;
+    auto sink = std::make_shared<rs274letter::CallbackCommandSink>(
+        [&command_count](const rs274letter::CommandStatement&) { ++command_count; });
+
+    rs274letter::ExecutionBudget budget;
+    budget.max_single_loop_iterations = 0;
+
+    std::pmr::unsynchronized_pool_resource pool_resource;
+    rs274letter::Serializer s(c.pool_resource ? &pool_resource : std::pmr::get_default_resource());
+    s.reset(rs274letter::Program::compile(rs274letter::Parser::parse(c.code)));
+    s.setCommandSink(sink);
+    s.setExecutionBudget(budget);
+
+    // one command for each iteration
+    s.step(s_warm_iterations);
+
+    rs274letter::test::AllocationScope scope;
+    s.step(s_measured_iterations);
+    auto allocations = scope.getCount();
+
+    auto iterations = command_count - s_warm_iterations;
+    double per_iteration = static_cast<double>(allocations) / iterations;
+
+    bool passed = iterations == s_measured_iterations
+        && allocations <= c.max_allocations_per_iteration * iterations;
+    std::cout << (passed ? "passed" : "FAILED") << ": " << c.name
+              << ", iterations: " << iterations
+              << ", allocations: " << allocations
+              << ", per iteration: " << per_iteration << std::endl;
+    return passed ? 0 : 1;
+}
+
+int main() {
+    int failed = 0;
+
+    try {
+        rs274letter::RegisterNativeFunction("blend", 3, [](const double* p) {
+            return p[0] + (p[1] - p[0]) * p[2];
+        });
+
+        for (auto&& c : s_case_list) {
+            failed += run_case(c);
+        }
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rs274letter/Serializer.h"
+#include "check.h"
+
+using rs274letter::test::Check;
+
+// The spans recorded by util::Trace on the main thread and on worker threads,
+// written as Chrome trace-event JSON.
+// usage: test_trace [trace.json], open the file in ui.perfetto.dev
+
+static const char* s_code = R"(
+    o<hole> sub
+        G00 X#1 Y#2
+        G01 Z-1
+    o<hole> endsub
+    o1 repeat [3]
+        o<hole> call [1] [2]
+    o1 endrepeat
+)";
+
+static std::size_t run() {
+    rs274letter::Serializer s(rs274letter::Parser::parse(s_code));
+    s.processProgram();
+    return s.getCommandList().size();
+}
+
+static std::size_t count_of(const std::string& str, const std::string& sub) {
+    std::size_t count = 0;
+    for (auto pos = str.find(sub); pos != std::string::npos; pos = str.find(sub, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+int main(int argc, char** argv) {
+    using rs274letter::util::Trace;
+    int failed = 0;
+
+    try {
+        // nothing is recorded before Enable()
+        run();
+        failed += Check(Trace::GetEventCount() == 0, "disabled, no event");
+
+        Trace::Enable(Trace::ALL_CATEGORIES);
+        Trace::SetThreadName("main");
+        run();
+
+        std::vector<std::thread> thread_list;
+        for (int t = 0; t < 2; ++t) {
+            thread_list.emplace_back([t]() {
+                Trace::SetThreadName("worker " + std::to_string(t));
+                run();
+            });
+        }
+        for (auto& thread : thread_list) {
+            thread.join();
+        }
+        Trace::Disable();
+
+        auto trace = Trace::ToChromeTrace();
+        if (argc > 1) {
+            std::ofstream(argv[1]) << trace;
+        }
+
+        for (auto&& name : { "parse", "compile", "validate", "link", "execute", "flush" }) {
+            failed += Check(count_of(trace, std::string("\"name\":\"") + name + "\"") == 3,
+                std::string(name) + " on 3 threads");
+        }
+        // a span for each token
+        failed += Check(count_of(trace, "\"name\":\"tokenize\"") > 3 * 20, "tokenize on 3 threads");
+        failed += Check(count_of(trace, "\"detail\":\"o<hole>\"") == 9, "3 o-calls on 3 threads");
+        failed += Check(count_of(trace, "\"thread_name\"") == 3
+            && trace.find("\"worker 1\"") != std::string::npos, "thread names");
+        failed += Check(Trace::GetDroppedCount() == 0, "nothing dropped");
+
+        // disabled again
+        auto event_count = Trace::GetEventCount();
+        run();
+        failed += Check(Trace::GetEventCount() == event_count, "disabled again, no event");
+
+        // a small ring buffer keeps the latest events
+        Trace::Clear();
+        Trace::SetBufferCapacity(8);
+        Trace::Enable(Trace::ALL_CATEGORIES);
+        std::thread([]() { run(); }).join();
+        Trace::Disable();
+        failed += Check(Trace::GetDroppedCount() > 0 && Trace::GetEventCount() <= 8, "ring buffer overwritten");
+        failed += Check(Trace::ToChromeTrace().find("\"name\":\"flush\"") != std::string::npos,
+            "the latest event is kept");
+    } catch (rs274letter::Exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
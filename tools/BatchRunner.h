@@ -0,0 +1,486 @@
+// BatchRunner.h
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rs274letter/Parser.h"
+#include "rs274letter/Program.h"
+#include "rs274letter/Serializer.h"
+
+#include "tools/WorkStealingPool.h"
+
+namespace rs274letter { namespace tools
+{
+
+/**
+ * BatchRunner
+ * Checks many program files on a WorkStealingPool: each file is read,
+ * parsed and compiled (validated and linked), and optionally executed
+ * under the ExecutionBudget with its commands discarded.
+ * The files with the same content are checked once. The 64-bit FNV-1a hash
+ * and the size only find the candidates, a file is a duplicate only if
+ * its bytes equal those of a candidate, which is read again for the
+ * comparison, no content is kept. Whichever of them is checked, the first
+ * of them in the list gets the result, the later ones get it with
+ * `duplicate_of` set to the first.
+ * An exception of any type fails the file with the status of the phase
+ * throwing it (a std::bad_alloc in the parser is a PARSE_ERROR), the
+ * other files are still checked.
+ * The results are given in the order of the file list, as soon as all the
+ * results before are ready, and one at a time.
+ * Call `Tokenizer::SetPrintComments(false)` before, the comments of all
+ * the threads would go to std::cout.
+*/
+class BatchRunner {
+public:
+    enum Status { OK, READ_ERROR, PARSE_ERROR, COMPILE_ERROR, EXECUTION_ERROR };
+
+    struct Options {
+        std::size_t thread_count = 0; // 0 for std::thread::hardware_concurrency()
+        bool execute = false;
+        bool lenient = false; // LenientDialect instead of StrictDialect
+        bool deduplicate = true;
+        ExecutionBudget execution_budget;
+    };
+
+    struct FileResult {
+        std::string file;
+        Status status = OK;
+        std::string error;
+        std::uint64_t hash = 0;
+        std::uint64_t bytes = 0;
+        std::string duplicate_of; // the first file with the same content, empty for the first
+        bool executed = false;
+
+        // 0 for a duplicate
+        std::uint64_t parse_ns = 0;
+        std::uint64_t compile_ns = 0;
+        std::uint64_t execute_ns = 0;
+
+        ParserStats parser_stats;
+        SerializerStats serializer_stats;
+    };
+
+    struct Summary {
+        std::size_t files = 0;
+        std::size_t duplicates = 0;
+        std::size_t failed = 0;
+        std::uint64_t steals = 0;
+        std::uint64_t wall_ns = 0;
+    };
+
+    using ResultCallback = std::function<void(const FileResult&)>;
+
+    static const char* StatusName(Status status) {
+        static const char* s_name_list[] = { "ok", "read_error", "parse_error", "compile_error", "execution_error" };
+        return s_name_list[status];
+    }
+
+    static std::uint64_t ContentHash(const std::string& content) {
+        std::uint64_t hash = 14695981039346656037ull;
+        for (unsigned char c : content) {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    /**
+     * CollectFiles()
+     * the files given, and the files under the directories given whose
+     * extension is in `extension_list` (all if empty), ordered by path
+     * in each directory
+     * @throw std::invalid_argument if a path does not exist
+    */
+    static std::vector<std::string> CollectFiles(const std::vector<std::string>& path_list,
+        const std::vector<std::string>& extension_list) {
+        std::vector<std::string> file_list;
+
+        for (auto&& path : path_list) {
+            if (!std::filesystem::is_directory(path)) {
+                if (!std::filesystem::exists(path)) {
+                    throw std::invalid_argument("no such file or directory: " + path);
+                }
+                file_list.push_back(path);
+                continue;
+            }
+
+            std::vector<std::string> dir_file_list;
+            for (auto&& entry : std::filesystem::recursive_directory_iterator(path)) {
+                if (!entry.is_regular_file()) continue;
+                auto extension = entry.path().extension().string();
+                if (!extension_list.empty()
+                    && std::find(extension_list.begin(), extension_list.end(), extension) == extension_list.end()) {
+                    continue;
+                }
+                dir_file_list.push_back(entry.path().string());
+            }
+            std::sort(dir_file_list.begin(), dir_file_list.end());
+            file_list.insert(file_list.end(), dir_file_list.begin(), dir_file_list.end());
+        }
+
+        return file_list;
+    }
+
+    /**
+     * ToJsonLine()
+     * one line of JSON, without the '\n'
+    */
+    static std::string ToJsonLine(const FileResult& result) {
+        std::stringstream ss;
+        char hash[17];
+        std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(result.hash));
+
+        ss << "{\"file\": " << JsonString(result.file)
+           << ", \"status\": \"" << StatusName(result.status) << "\"";
+        if (!result.error.empty()) ss << ", \"error\": " << JsonString(result.error);
+        ss << ", \"hash\": \"" << hash << "\""
+           << ", \"bytes\": " << result.bytes;
+        if (!result.duplicate_of.empty()) ss << ", \"duplicate_of\": " << JsonString(result.duplicate_of);
+        ss << ", \"parse_ns\": " << result.parse_ns
+           << ", \"compile_ns\": " << result.compile_ns
+           << ", \"execute_ns\": " << result.execute_ns;
+
+        auto&& p = result.parser_stats;
+        ss << ", \"parser\": {\"statements\": " << p.statements
+           << ", \"tokens\": " << p.tokens
+           << ", \"lines\": " << p.lines << "}";
+
+        if (result.executed) {
+            auto&& s = result.serializer_stats;
+            ss << ", \"serializer\": {\"statements\": " << s.statements
+               << ", \"expressions\": " << s.expressions
+               << ", \"o_calls\": " << s.o_calls
+               << ", \"loop_iterations\": " << s.loop_iterations
+               << ", \"commands\": " << s.commands << "}";
+        }
+        ss << "}";
+        return ss.str();
+    }
+
+    /**
+     * CheckFile()
+     * check one program on this thread
+    */
+    static FileResult CheckFile(const std::string& file, const std::string& content, const Options& options) {
+        FileResult result;
+        result.file = file;
+        result.bytes = content.size();
+        result.hash = ContentHash(content);
+        Check(content, options, result);
+        return result;
+    }
+
+    explicit BatchRunner(const Options& options) : _options(options) {}
+
+    /**
+     * run()
+     * check each file of `file_list`, `on_result` is called for each of them
+     * in the order of the list, from the worker threads but never at once
+    */
+    Summary run(const std::vector<std::string>& file_list, const ResultCallback& on_result) {
+        auto start = std::chrono::steady_clock::now();
+
+        this->_file_list = &file_list;
+        this->_on_result = &on_result;
+        this->_result_list.assign(file_list.size(), FileResult());
+        this->_ready_list.assign(file_list.size(), false);
+        this->_group_list.assign(file_list.size(), kNoGroup);
+        this->_waiter_map.clear();
+        this->_content_map.clear();
+        this->_first_of_group_map.clear();
+        this->_next_result = 0;
+        this->_summary = Summary();
+        this->_summary.files = file_list.size();
+
+        {
+            WorkStealingPool pool(this->_options.thread_count);
+            for (std::size_t i = 0; i < file_list.size(); ++i) {
+                pool.submit([this, i]() { this->checkOne(i); });
+            }
+            pool.wait();
+            this->_summary.steals = pool.getStealCount();
+        }
+
+        this->_summary.wall_ns = ElapsedNs(start);
+        return this->_summary;
+    }
+
+private:
+    static constexpr std::size_t kNoGroup = static_cast<std::size_t>(-1);
+
+    static std::uint64_t ElapsedNs(std::chrono::steady_clock::time_point start) {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+
+    static void Check(const std::string& content, const Options& options, FileResult& result) {
+        if (options.lenient) {
+            Check<LenientParser, LenientSerializer>(content, options, result);
+        } else {
+            Check<Parser, Serializer>(content, options, result);
+        }
+    }
+
+    /**
+     * RunPhase()
+     * run `f`, if it throws anything set the `error_status` and the message,
+     * a task of the WorkStealingPool must not throw
+     * @return false if it throws
+    */
+    template <typename F>
+    static bool RunPhase(Status error_status, FileResult& result, F&& f) {
+        try {
+            f();
+            return true;
+        } catch (Exception& e) {
+            result.error = e.what();
+        } catch (std::exception& e) {
+            result.error = e.what();
+        } catch (...) {
+            result.error = "unknown exception";
+        }
+        result.status = error_status;
+        return false;
+    }
+
+    template <typename ParserType, typename SerializerType>
+    static void Check(const std::string& content, const Options& options, FileResult& result) {
+        auto start = std::chrono::steady_clock::now();
+        AstObject ast;
+        bool parsed = RunPhase(PARSE_ERROR, result, [&]() {
+            ast = ParserType::parse(content, result.parser_stats);
+        });
+        result.parse_ns = ElapsedNs(start);
+        if (!parsed) return;
+
+        start = std::chrono::steady_clock::now();
+        Program::ptr program;
+        bool compiled = RunPhase(COMPILE_ERROR, result, [&]() {
+            program = Program::compile(std::move(ast));
+        });
+        result.compile_ns = ElapsedNs(start);
+        if (!compiled) return;
+
+        if (!options.execute) return;
+
+        start = std::chrono::steady_clock::now();
+        result.executed = true;
+        SerializerType s;
+        RunPhase(EXECUTION_ERROR, result, [&]() {
+            s.reset(program);
+            s.setCommandSink(std::make_shared<CallbackCommandSink>([](const CommandStatement&) {}));
+            s.setExecutionBudget(options.execution_budget);
+            s.processProgram();
+        });
+        result.serializer_stats = s.getStats();
+        result.execute_ns = ElapsedNs(start);
+    }
+
+    // the error message, empty if read
+    static std::string ReadFile(const std::string& file, std::string& content) {
+        std::ifstream ifs(file, std::ios::binary);
+        if (!ifs.is_open()) {
+            return "cannot open: " + file;
+        }
+        try {
+            std::stringstream ss;
+            ss << ifs.rdbuf();
+            if (ifs.bad()) {
+                return "cannot read: " + file;
+            }
+            content = ss.str();
+        } catch (std::exception& e) {
+            return "cannot read: " + file + ": " + e.what();
+        }
+        return {};
+    }
+
+    // if the file, read again, has the bytes of `content`
+    static bool HasContent(const std::string& file, const std::string& content) {
+        std::ifstream ifs(file, std::ios::binary);
+        if (!ifs.is_open()) return false;
+
+        char buffer[4096];
+        std::size_t offset = 0;
+        while (ifs) {
+            ifs.read(buffer, sizeof(buffer));
+            auto count = static_cast<std::size_t>(ifs.gcount());
+            if (count > content.size() - offset || content.compare(offset, count, buffer, count) != 0) {
+                return false;
+            }
+            offset += count;
+        }
+        return !ifs.bad() && offset == content.size();
+    }
+
+    static std::string JsonString(const std::string& str) {
+        std::string out = "\"";
+        for (char c : str) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (c == '\n') {
+                out += "\\n";
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char buffer[8];
+                std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned>(c));
+                out += buffer;
+            } else {
+                out += c;
+            }
+        }
+        return out + "\"";
+    }
+
+    void checkOne(std::size_t index) {
+        auto&& file = (*this->_file_list)[index];
+
+        std::string content;
+        auto read_error = ReadFile(file, content);
+        if (!read_error.empty()) {
+            FileResult result;
+            result.file = file;
+            result.status = READ_ERROR;
+            result.error = std::move(read_error);
+            this->complete(index, std::move(result));
+            return;
+        }
+
+        FileResult result;
+        result.file = file;
+        result.bytes = content.size();
+        result.hash = ContentHash(content);
+
+        if (this->_options.deduplicate && this->joinOwner(index, content, result)) {
+            // completed with its owner
+            return;
+        }
+
+        Check(content, this->_options, result);
+        this->complete(index, std::move(result));
+    }
+
+    /**
+     * joinOwner()
+     * wait for the result of a file with the same content, or become the owner
+     * of that content. The candidates, with the same hash and size, are read
+     * again outside the lock, the same hash and size with other bytes is a
+     * collision, it is checked itself.
+     * @return true if it waits for an owner
+    */
+    bool joinOwner(std::size_t index, const std::string& content, const FileResult& result) {
+        std::size_t compared_count = 0;
+        std::vector<std::size_t> candidate_list;
+        while (true) {
+            std::size_t owner = kNoGroup;
+            for (auto candidate : candidate_list) {
+                if (HasContent((*this->_file_list)[candidate], content)) {
+                    owner = candidate;
+                    break;
+                }
+            }
+            compared_count += candidate_list.size();
+
+            std::lock_guard<std::mutex> lock(this->_mutex);
+            if (owner != kNoGroup) {
+                this->_group_list[index] = owner;
+                this->_waiter_map[owner].push_back(index);
+                if (this->_ready_list[owner]) {
+                    this->completeWaiters(owner);
+                    this->flush();
+                }
+                return true;
+            }
+
+            // the owners added while comparing are compared next
+            auto&& owner_list = this->_content_map[{result.hash, result.bytes}];
+            if (compared_count == owner_list.size()) {
+                owner_list.push_back(index);
+                this->_group_list[index] = index;
+                return false;
+            }
+            candidate_list.assign(owner_list.begin() + static_cast<std::ptrdiff_t>(compared_count), owner_list.end());
+        }
+    }
+
+    void complete(std::size_t index, FileResult result) {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        if (result.status != OK) ++this->_summary.failed;
+        this->_result_list[index] = std::move(result);
+        this->_ready_list[index] = true;
+        this->completeWaiters(index);
+        this->flush();
+    }
+
+    // with _mutex locked
+    void completeWaiters(std::size_t owner) {
+        auto it = this->_waiter_map.find(owner);
+        if (it == this->_waiter_map.end()) return;
+
+        auto&& owner_result = this->_result_list[owner];
+        for (auto waiter : it->second) {
+            auto result = owner_result;
+            result.file = (*this->_file_list)[waiter];
+
+            if (result.status != OK) ++this->_summary.failed;
+            this->_result_list[waiter] = std::move(result);
+            this->_ready_list[waiter] = true;
+        }
+        this->_waiter_map.erase(it);
+    }
+
+    // with _mutex locked, give the results ready in order, the first of
+    // each group in the order is given as checked, the others as its duplicates
+    void flush() {
+        while (this->_next_result < this->_result_list.size() && this->_ready_list[this->_next_result]) {
+            auto&& result = this->_result_list[this->_next_result];
+            auto group = this->_group_list[this->_next_result];
+            if (group != kNoGroup) {
+                auto [it, inserted] = this->_first_of_group_map.try_emplace(group, this->_next_result);
+                if (!inserted) {
+                    result.duplicate_of = (*this->_file_list)[it->second];
+                    result.parse_ns = result.compile_ns = result.execute_ns = 0;
+                    ++this->_summary.duplicates;
+                }
+            }
+
+            (*this->_on_result)(result);
+            ++this->_next_result;
+        }
+    }
+
+private:
+    Options _options;
+
+    const std::vector<std::string>* _file_list = nullptr;
+    const ResultCallback* _on_result = nullptr;
+
+    std::mutex _mutex; // guards all below
+    std::vector<FileResult> _result_list;
+    std::vector<bool> _ready_list;
+    std::vector<std::size_t> _group_list; // the index of the owner of the content, kNoGroup if not deduplicated
+    // (hash, size) -> the indexes of the files checked, the files with the same content wait for their result
+    std::map<std::pair<std::uint64_t, std::size_t>, std::vector<std::size_t>> _content_map;
+    std::map<std::size_t, std::vector<std::size_t>> _waiter_map; // the owner index -> the duplicate indexes
+    std::map<std::size_t, std::size_t> _first_of_group_map; // the owner index -> the first index given
+    std::size_t _next_result = 0;
+    Summary _summary;
+};
+
+} // namespace tools
+} // namespace rs274letter
@@ -0,0 +1,196 @@
+// BenchCompare.h
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+namespace rs274letter { namespace tools
+{
+
+/**
+ * BenchCompare
+ * Compares the JSON results of the benchmarks (see bench/bench_harness.h)
+ * with a baseline, for each benchmark, input and metric:
+ *  - lines_per_second: higher is better
+ *  - allocations_per_line: lower is better
+ *  - peak_bytes: lower is better
+ *  - checkpoint_bytes: lower is better, only bench_restart reports it
+ * A metric regresses if it is worse than the baseline by more than its
+ * threshold, a ratio of the baseline, and by more than its absolute noise
+ * floor, so a baseline of 0 allocations does not fail on a single one.
+ * A metric missing in the baseline is not compared, an input of the
+ * baseline missing in the current results fails.
+*/
+class BenchCompare {
+public:
+    struct Options {
+        double time_threshold = 0.15; // lines_per_second
+        double allocation_threshold = 0.05; // allocations_per_line
+        double memory_threshold = 0.10; // peak_bytes
+    };
+
+    enum Status { OK, IMPROVED, REGRESSED, MISSING };
+
+    struct Row {
+        std::string benchmark;
+        std::string input;
+        std::string metric;
+        double baseline = 0;
+        double current = 0;
+        Status status = OK;
+    };
+
+    // "benchmark" -> "input" -> "metric" -> value
+    using ResultMap = std::map<std::string, std::map<std::string, std::map<std::string, double>>>;
+
+    static const char* StatusName(Status status) {
+        static const char* s_name_list[] = { "ok", "improved", "REGRESSED", "MISSING" };
+        return s_name_list[status];
+    }
+
+    /**
+     * LoadResults()
+     * add the results of one JSON document printed by a benchmark
+     * @throw std::invalid_argument if it is not such a document
+    */
+    static void LoadResults(const std::string& json_text, ResultMap& result_map) {
+        auto parsed = json::parse(json_text);
+        if (!parsed || !parsed->is_object() || !parsed->contains("benchmark") || !parsed->contains("results")) {
+            throw std::invalid_argument("not a benchmark result document");
+        }
+
+        auto&& document = parsed->as_object();
+        auto&& input_map = result_map[document.at("benchmark").as_string()];
+        for (auto&& result : document.at("results").as_array()) {
+            auto&& result_object = result.as_object();
+            auto&& metric_map = input_map[result_object.at("input").as_string()];
+            for (auto&& metric : s_metric_list) {
+                if (result_object.contains(metric.name)) {
+                    metric_map[metric.name] = result_object.at(metric.name).as_double();
+                }
+            }
+        }
+    }
+
+    static std::vector<Row> Compare(const ResultMap& baseline, const ResultMap& current, const Options& options) {
+        std::vector<Row> row_list;
+
+        for (auto&& [benchmark, baseline_input_map] : baseline) {
+            auto current_benchmark_it = current.find(benchmark);
+            for (auto&& [input, baseline_metric_map] : baseline_input_map) {
+                const std::map<std::string, double>* current_metric_map = nullptr;
+                if (current_benchmark_it != current.end()) {
+                    auto it = current_benchmark_it->second.find(input);
+                    if (it != current_benchmark_it->second.end()) current_metric_map = &it->second;
+                }
+
+                for (auto&& metric : s_metric_list) {
+                    auto baseline_it = baseline_metric_map.find(metric.name);
+                    if (baseline_it == baseline_metric_map.end()) continue;
+
+                    Row row;
+                    row.benchmark = benchmark;
+                    row.input = input;
+                    row.metric = metric.name;
+                    row.baseline = baseline_it->second;
+
+                    const double* current_value = nullptr;
+                    if (current_metric_map) {
+                        auto current_it = current_metric_map->find(metric.name);
+                        if (current_it != current_metric_map->end()) current_value = &current_it->second;
+                    }
+
+                    if (!current_value) {
+                        row.status = MISSING;
+                    } else {
+                        row.current = *current_value;
+                        row.status = Judge(metric, row.baseline, row.current, options);
+                    }
+                    row_list.push_back(row);
+                }
+            }
+        }
+
+        return row_list;
+    }
+
+    static bool HasFailure(const std::vector<Row>& row_list) {
+        for (auto&& row : row_list) {
+            if (row.status == REGRESSED || row.status == MISSING) return true;
+        }
+        return false;
+    }
+
+    /**
+     * PrintTable()
+     * one line for each compared metric, and the count of the failures
+    */
+    static void PrintTable(std::ostream& out, const std::vector<Row>& row_list) {
+        out << std::left << std::setw(20) << "benchmark" << std::setw(20) << "input"
+            << std::setw(22) << "metric" << std::right << std::setw(16) << "baseline"
+            << std::setw(16) << "current" << std::setw(10) << "change" << "  status\n";
+
+        std::size_t failure_count = 0;
+        for (auto&& row : row_list) {
+            out << std::left << std::setw(20) << row.benchmark << std::setw(20) << row.input
+                << std::setw(22) << row.metric << std::right << std::fixed << std::setprecision(3)
+                << std::setw(16) << row.baseline;
+            if (row.status == MISSING) {
+                out << std::setw(16) << "-" << std::setw(10) << "-";
+            } else {
+                out << std::setw(16) << row.current << std::setw(10) << ChangeString(row.baseline, row.current);
+            }
+            out << "  " << StatusName(row.status) << "\n";
+
+            if (row.status == REGRESSED || row.status == MISSING) ++failure_count;
+        }
+
+        out << row_list.size() << " metrics compared, " << failure_count << " failed" << std::endl;
+    }
+
+private:
+    struct Metric {
+        const char* name;
+        bool higher_is_better;
+        double Options::* threshold;
+        double noise_floor; // the absolute change always accepted
+    };
+
+    inline static const Metric s_metric_list[] = {
+        { "lines_per_second", true, &Options::time_threshold, 0.0 },
+        { "allocations_per_line", false, &Options::allocation_threshold, 0.01 },
+        { "peak_bytes", false, &Options::memory_threshold, 4096.0 },
+        { "checkpoint_bytes", false, &Options::memory_threshold, 4096.0 },
+    };
+
+    static Status Judge(const Metric& metric, double baseline, double current, const Options& options) {
+        auto threshold = options.*metric.threshold;
+        // positive if current is worse than the baseline
+        auto worse = metric.higher_is_better ? baseline - current : current - baseline;
+        auto allowed = std::max(std::fabs(baseline) * threshold, metric.noise_floor);
+
+        if (worse > allowed) return REGRESSED;
+        if (-worse > allowed) return IMPROVED;
+        return OK;
+    }
+
+    static std::string ChangeString(double baseline, double current) {
+        if (baseline == 0) return current == 0 ? "0.0%" : "new";
+
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%+.1f%%", (current - baseline) / std::fabs(baseline) * 100.0);
+        return buffer;
+    }
+};
+
+} // namespace tools
+} // namespace rs274letter
@@ -0,0 +1,360 @@
+// CorpusGenerator.h
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace rs274letter { namespace tools
+{
+
+/**
+ * CorpusGenerator
+ * Writes a synthetic RS274 program of about `target_bytes` bytes, which
+ * parses and executes with the StrictDialect Parser and Serializer.
+ * The program is a sequence of blocks, each block is one of the `BlockKind`s
+ * chosen by the weights of the `Mix`:
+ *  - LINEAR:  a long 3-axis toolpath of G00/G01 moves
+ *  - CAM:     CAM-like output, moves with `( )` and `;` comments and tool changes
+ *  - NESTING: nested while/if/else up to `max_nesting_depth` levels
+ *  - SUBS:    a library of subs, some calling each other, and many o-calls
+ *  - MACROS:  parametric code, assignments of long expressions with inside functions
+ *
+ * The output only depends on the Options: the random numbers come from an
+ * own splitmix64, not from the std distributions whose results differ between
+ * the standard libraries, and the numbers are formatted with a fixed precision.
+ * The program is written block by block, so the size is not limited by the memory.
+*/
+class CorpusGenerator {
+public:
+    enum BlockKind { LINEAR, CAM, NESTING, SUBS, MACROS, kBlockKindCount };
+
+    struct Mix {
+        unsigned weight[kBlockKindCount] = { 4, 2, 1, 1, 2 };
+    };
+
+    struct Options {
+        std::uint64_t seed = 1;
+        std::uint64_t target_bytes = 64 * 1024;
+        Mix mix;
+        unsigned max_nesting_depth = 6;
+    };
+
+    static const char* BlockKindName(BlockKind kind) {
+        static const char* s_name_list[kBlockKindCount] = { "linear", "cam", "nesting", "subs", "macros" };
+        return s_name_list[kind];
+    }
+
+    /**
+     * ParseMix()
+     * "linear=4,cam=2,nesting=1,subs=1,macros=2", a missing kind has weight 0
+     * @throw std::invalid_argument
+    */
+    static Mix ParseMix(const std::string& mix_str) {
+        Mix mix;
+        for (auto& w : mix.weight) w = 0;
+
+        std::size_t pos = 0;
+        while (pos < mix_str.size()) {
+            auto end = mix_str.find(',', pos);
+            if (end == std::string::npos) end = mix_str.size();
+            auto item = mix_str.substr(pos, end - pos);
+            pos = end + 1;
+
+            auto eq = item.find('=');
+            auto name = item.substr(0, eq);
+            int kind = 0;
+            while (kind < kBlockKindCount && name != BlockKindName(static_cast<BlockKind>(kind))) ++kind;
+            if (kind == kBlockKindCount || eq == std::string::npos) {
+                throw std::invalid_argument("invalid mix item: " + item);
+            }
+            mix.weight[kind] = static_cast<unsigned>(std::stoul(item.substr(eq + 1)));
+        }
+
+        unsigned total = 0;
+        for (auto w : mix.weight) total += w;
+        if (total == 0) {
+            throw std::invalid_argument("the mix has no block kind: " + mix_str);
+        }
+        return mix;
+    }
+
+    /**
+     * ParseSize()
+     * "4096", "64K", "10M", "10G", the suffixes are powers of 1024
+     * @throw std::invalid_argument
+    */
+    static std::uint64_t ParseSize(const std::string& size_str) {
+        std::size_t idx = 0;
+        auto value = std::stoull(size_str, &idx);
+        auto suffix = size_str.substr(idx);
+        if (suffix.empty() || suffix == "B") return value;
+        if (suffix == "K" || suffix == "KB") return value << 10;
+        if (suffix == "M" || suffix == "MB") return value << 20;
+        if (suffix == "G" || suffix == "GB") return value << 30;
+        throw std::invalid_argument("invalid size: " + size_str);
+    }
+
+    explicit CorpusGenerator(const Options& options) : _options(options) {
+        this->_state = options.seed;
+    }
+
+    /**
+     * generate()
+     * write the whole program, ends with M30
+     * @return the bytes written
+    */
+    std::uint64_t generate(std::ostream& out) {
+        this->_out = &out;
+        this->_written = 0;
+
+        this->line("; rs274letter synthetic corpus, seed %llu, %llu bytes",
+            static_cast<unsigned long long>(this->_options.seed),
+            static_cast<unsigned long long>(this->_options.target_bytes));
+        this->line("G90 G21 G17");
+        this->line("G00 Z5");
+
+        unsigned total_weight = 0;
+        for (auto w : this->_options.mix.weight) total_weight += w;
+
+        while (this->_written < this->_options.target_bytes) {
+            auto r = static_cast<unsigned>(this->uniform(0, total_weight - 1));
+            int kind = 0;
+            while (r >= this->_options.mix.weight[kind]) {
+                r -= this->_options.mix.weight[kind];
+                ++kind;
+            }
+
+            switch (static_cast<BlockKind>(kind)) {
+            case LINEAR: this->linearBlock(); break;
+            case CAM: this->camBlock(); break;
+            case NESTING: this->nestingBlock(); break;
+            case SUBS: this->subsBlock(); break;
+            case MACROS: this->macrosBlock(); break;
+            default: break;
+            }
+        }
+
+        this->line("G00 Z5");
+        this->line("M30");
+        out.flush();
+        return this->_written;
+    }
+
+private:
+    // splitmix64, the same sequence on every platform
+    std::uint64_t next() {
+        std::uint64_t z = (this->_state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // [lo, hi]
+    std::int64_t uniform(std::int64_t lo, std::int64_t hi) {
+        return lo + static_cast<std::int64_t>(this->next() % static_cast<std::uint64_t>(hi - lo + 1));
+    }
+
+    // [lo, hi), in steps of 0.001, exactly printed by "%.3f"
+    double real(double lo, double hi) {
+        auto steps = static_cast<std::int64_t>((hi - lo) * 1000);
+        return lo + static_cast<double>(this->uniform(0, steps - 1)) / 1000;
+    }
+
+    // the lines to write for about `bytes` bytes, at least 1
+    std::int64_t lineCount(std::int64_t lo, std::int64_t hi, std::int64_t bytes_per_line) {
+        auto left = (static_cast<std::int64_t>(this->_options.target_bytes)
+            - static_cast<std::int64_t>(this->_written)) / bytes_per_line + 1;
+        if (left < 1) left = 1;
+        auto count = this->uniform(lo, hi);
+        return count < left ? count : left;
+    }
+
+    template <typename... Args>
+    void line(const char* fmt, Args... args) {
+        char buffer[256];
+        int n = std::snprintf(buffer, sizeof(buffer), fmt, args...);
+        if (n < 0) return;
+
+        if (static_cast<std::size_t>(n) < sizeof(buffer)) {
+            this->_out->write(buffer, n);
+        } else {
+            // a long expression of a macro
+            std::string long_buffer(static_cast<std::size_t>(n) + 1, '\0');
+            std::snprintf(&long_buffer[0], long_buffer.size(), fmt, args...);
+            this->_out->write(long_buffer.data(), n);
+        }
+        this->_out->put('\n');
+        this->_written += static_cast<std::uint64_t>(n) + 1;
+    }
+
+    void indentLine(int depth, const std::string& str) {
+        std::string s(static_cast<std::size_t>(depth) * 4, ' ');
+        s += str;
+        this->line("%s", s.c_str());
+    }
+
+    void move() {
+        this->_x = this->real(0, 300);
+        this->_y = this->real(0, 200);
+        this->line("G01 X%.3f Y%.3f Z%.3f", this->_x, this->_y, this->real(-5, 0));
+    }
+
+    void linearBlock() {
+        auto count = this->lineCount(100, 1000, 32);
+        this->line("G00 X%.3f Y%.3f", this->real(0, 300), this->real(0, 200));
+        this->line("G01 Z%.3f F%d", this->real(-5, 0), static_cast<int>(this->uniform(2, 30)) * 100);
+        for (std::int64_t i = 0; i < count; ++i) {
+            // small steps, like a sampled curve
+            this->_x += this->real(-1, 1);
+            this->_y += this->real(-1, 1);
+            this->line("G01 X%.3f Y%.3f Z%.3f", this->_x, this->_y, this->real(-5, 0));
+        }
+        this->line("G00 Z5");
+    }
+
+    void camBlock() {
+        auto count = this->lineCount(50, 500, 45);
+        auto tool = this->uniform(1, 20);
+        this->line("( TOOL %d : FLAT END MILL D%.3f )", static_cast<int>(tool), this->real(1, 20));
+        this->line("; operation %d, stock to leave %.3f", static_cast<int>(++this->_operation), this->real(0, 1));
+        this->line("T%d M06", static_cast<int>(tool));
+        this->line("S%d M03", static_cast<int>(this->uniform(10, 240)) * 100);
+        for (std::int64_t i = 0; i < count; ++i) {
+            auto r = this->uniform(0, 9);
+            if (r == 0) {
+                this->line("( segment %d, arc fitted tolerance %.3f )", static_cast<int>(i), this->real(0, 0.1));
+            } else if (r == 1) {
+                this->line("; retract and plunge");
+                this->line("G00 Z%.3f", this->real(1, 10));
+            } else {
+                this->move();
+            }
+        }
+        this->line("M05");
+    }
+
+    // while loops of 2 iterations, with an if/else or a break inside
+    void nestingLevel(int depth, int max_depth) {
+        auto o = ++this->_o_number;
+        auto var = "#<n" + std::to_string(o) + ">";
+        auto iterations = this->uniform(1, 2);
+
+        this->indentLine(depth, var + " = 0");
+        this->indentLine(depth, "o" + std::to_string(o) + " while [" + var + " LT " + std::to_string(iterations) + "]");
+        this->indentLine(depth + 1, var + " = [" + var + " + 1]");
+
+        auto o_if = ++this->_o_number;
+        this->indentLine(depth + 1, "o" + std::to_string(o_if) + " if [" + var + " EQ 1]");
+        if (depth + 1 < max_depth) {
+            this->nestingLevel(depth + 2, max_depth);
+        } else {
+            char buffer[64];
+            std::snprintf(buffer, sizeof(buffer), "G01 X[%s * %.3f] Y%.3f", var.c_str(), this->real(1, 10), this->real(0, 200));
+            this->indentLine(depth + 2, buffer);
+        }
+        this->indentLine(depth + 1, "o" + std::to_string(o_if) + " else");
+        {
+            char buffer[64];
+            std::snprintf(buffer, sizeof(buffer), "G00 X%.3f Y[%s * 2]", this->real(0, 300), var.c_str());
+            this->indentLine(depth + 2, buffer);
+        }
+        this->indentLine(depth + 1, "o" + std::to_string(o_if) + " endif");
+        this->indentLine(depth, "o" + std::to_string(o) + " endwhile");
+    }
+
+    void nestingBlock() {
+        auto max_depth = static_cast<int>(this->uniform(1, this->_options.max_nesting_depth ? this->_options.max_nesting_depth : 1));
+        this->nestingLevel(0, max_depth);
+    }
+
+    void subsBlock() {
+        auto lib = ++this->_sub_library;
+        auto sub_count = this->uniform(2, 8);
+
+        for (std::int64_t s = 0; s < sub_count; ++s) {
+            auto name = "o<lib" + std::to_string(lib) + "_" + std::to_string(s) + ">";
+            this->line("%s sub", name.c_str());
+            this->line("    ; #1: x, #2: y, #3: depth");
+            this->line("    G00 X#1 Y#2");
+            this->line("    G01 Z[0 - #3] F%d", static_cast<int>(this->uniform(1, 10)) * 100);
+            auto o_if = ++this->_o_number;
+            this->line("    o%d if [#3 GT %.3f]", static_cast<int>(o_if), this->real(0, 5));
+            this->line("        G01 X[#1 + %.3f] Y[#2 + %.3f]", this->real(0, 10), this->real(0, 10));
+            if (s > 0) {
+                // a sub of the library calls the one defined before it
+                this->line("        o<lib%d_%d> call [#1] [#2] [#3 / 2]", static_cast<int>(lib), static_cast<int>(s - 1));
+            }
+            this->line("    o%d endif", static_cast<int>(o_if));
+            this->line("    G00 Z5");
+            this->line("%s endsub [#1 + #2]", name.c_str());
+        }
+
+        auto call_count = this->lineCount(20, 200, 40);
+        for (std::int64_t c = 0; c < call_count; ++c) {
+            this->line("o<lib%d_%d> call [%.3f] [%.3f] [%.3f]", static_cast<int>(lib),
+                static_cast<int>(this->uniform(0, sub_count - 1)),
+                this->real(0, 300), this->real(0, 200), this->real(0, 5));
+        }
+    }
+
+    std::string expression(int depth) {
+        static const char* s_function_list[] = { "sin", "cos", "abs", "round", "fix", "fup" };
+        static const char* s_operator_list[] = { "+", "-", "*" };
+
+        char buffer[32];
+        if (depth == 0 || this->uniform(0, 3) == 0) {
+            if (this->uniform(0, 1) == 0) {
+                std::snprintf(buffer, sizeof(buffer), "%.3f", this->real(0, 100));
+                return buffer;
+            }
+            return "#<p" + std::to_string(this->uniform(0, 7)) + ">";
+        }
+
+        switch (this->uniform(0, 3)) {
+        case 0:
+            return std::string(s_function_list[this->uniform(0, 5)]) + "[" + this->expression(depth - 1) + "]";
+        case 1:
+            return "sqrt[abs[" + this->expression(depth - 1) + "]]";
+        case 2:
+            std::snprintf(buffer, sizeof(buffer), " / %.3f]", this->real(1, 10));
+            return "[" + this->expression(depth - 1) + buffer;
+        default:
+            return "[" + this->expression(depth - 1) + " " + s_operator_list[this->uniform(0, 2)] + " "
+                + this->expression(depth - 1) + "]";
+        }
+    }
+
+    void macrosBlock() {
+        for (int p = 0; p < 8; ++p) {
+            this->line("#<p%d> = %.3f", p, this->real(0, 100));
+        }
+        auto count = this->lineCount(20, 200, 120);
+        for (std::int64_t i = 0; i < count; ++i) {
+            auto p = static_cast<int>(this->uniform(0, 7));
+            auto value = this->expression(4);
+            // sin[] keeps the parameters in [-100, 100] however long the block is
+            this->line("#<p%d> = [sin[%s] * 100]", p, value.c_str());
+            if (this->uniform(0, 2) == 0) {
+                this->line("G01 X[#<p%d> * 10 + 150] Y[#<p%d> * 10 + 100]", p, static_cast<int>(this->uniform(0, 7)));
+            }
+        }
+    }
+
+    Options _options;
+    std::uint64_t _state = 0;
+
+    std::ostream* _out = nullptr;
+    std::uint64_t _written = 0;
+
+    double _x = 0;
+    double _y = 0;
+    std::uint64_t _o_number = 0;
+    std::uint64_t _sub_library = 0;
+    std::uint64_t _operation = 0;
+};
+
+} // namespace tools
+} // namespace rs274letter
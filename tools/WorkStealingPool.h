@@ -0,0 +1,175 @@
+// WorkStealingPool.h
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rs274letter { namespace tools
+{
+
+/**
+ * WorkStealingPool
+ * A fixed number of worker threads, each with its own task queue.
+ * A worker takes the newest task of its own queue, and when it is empty
+ * steals the oldest task of another queue, so a worker which got a few
+ * long tasks does not hold back the tasks queued behind them.
+ * The tasks submitted from outside are spread over the queues in turn, a
+ * task submitted from a worker goes to the queue of that worker.
+ * A task must not throw.
+*/
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @param thread_count 0 for std::thread::hardware_concurrency()
+    */
+    explicit WorkStealingPool(std::size_t thread_count = 0) {
+        if (thread_count == 0) {
+            thread_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            this->_queue_list.push_back(std::make_unique<Queue>());
+        }
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            this->_thread_list.emplace_back([this, i]() { this->work(i); });
+        }
+    }
+
+    /**
+     * the queued tasks are still run before the workers stop
+    */
+    ~WorkStealingPool() noexcept {
+        this->wait();
+        {
+            std::lock_guard<std::mutex> lock(this->_mutex);
+            this->_stop = true;
+        }
+        this->_work_cv.notify_all();
+        for (auto&& thread : this->_thread_list) {
+            thread.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(Task task) {
+        std::size_t index = (s_current_pool == this)
+            ? s_current_index
+            : this->_next_queue.fetch_add(1, std::memory_order_relaxed) % this->_queue_list.size();
+
+        this->_unfinished.fetch_add(1, std::memory_order_relaxed);
+        {
+            auto&& queue = *this->_queue_list[index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        {
+            // under the lock, so a worker can not miss it between its check and its wait
+            std::lock_guard<std::mutex> lock(this->_mutex);
+            ++this->_queued;
+        }
+        this->_work_cv.notify_one();
+    }
+
+    /**
+     * wait()
+     * until all the submitted tasks have finished
+    */
+    void wait() {
+        std::unique_lock<std::mutex> lock(this->_mutex);
+        this->_done_cv.wait(lock, [this]() { return this->_unfinished.load() == 0; });
+    }
+
+    inline std::size_t getThreadCount() const { return this->_thread_list.size(); }
+
+    // tasks taken from the queue of another worker
+    inline std::uint64_t getStealCount() const { return this->_steal_count.load(std::memory_order_relaxed); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool take(std::size_t index, Task& task) {
+        {
+            auto&& own = *this->_queue_list[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+
+        for (std::size_t i = 1; i < this->_queue_list.size(); ++i) {
+            auto&& victim = *this->_queue_list[(index + i) % this->_queue_list.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                this->_steal_count.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work(std::size_t index) {
+        s_current_pool = this;
+        s_current_index = index;
+
+        Task task;
+        while (true) {
+            if (this->take(index, task)) {
+                {
+                    std::lock_guard<std::mutex> lock(this->_mutex);
+                    --this->_queued;
+                }
+                task();
+                task = nullptr;
+
+                if (this->_unfinished.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> lock(this->_mutex);
+                    this->_done_cv.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(this->_mutex);
+            this->_work_cv.wait(lock, [this]() { return this->_stop || this->_queued > 0; });
+            if (this->_stop && this->_queued == 0) return;
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<Queue>> _queue_list;
+    std::vector<std::thread> _thread_list;
+    std::atomic<std::size_t> _next_queue{0};
+
+    std::mutex _mutex;
+    std::condition_variable _work_cv;
+    std::condition_variable _done_cv;
+    std::size_t _queued = 0; // in all the queues, guarded by _mutex
+    bool _stop = false;
+
+    std::atomic<std::size_t> _unfinished{0}; // submitted and not finished
+    std::atomic<std::uint64_t> _steal_count{0};
+
+    inline static thread_local WorkStealingPool* s_current_pool = nullptr;
+    inline static thread_local std::size_t s_current_index = 0;
+};
+
+} // namespace tools
+} // namespace rs274letter
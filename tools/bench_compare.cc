@@ -0,0 +1,114 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "tools/BenchCompare.h"
+
+// Compares the JSON results of the benchmarks with a baseline, prints a
+// table of the metrics and fails if any regresses, see BenchCompare.h.
+// A directory compares each bench_*.json of the baseline with the file of
+// the same name in the current directory.
+// usage: bench_compare --baseline FILE|DIR --current FILE|DIR [--time-threshold 0.15]
+//                      [--allocation-threshold 0.05] [--memory-threshold 0.10]
+// returns 0 if nothing regresses, 1 if any metric regresses or is missing, 2 on errors
+
+static void print_usage(const char* name) {
+    std::cerr << "usage: " << name << " --baseline FILE|DIR --current FILE|DIR [--time-threshold 0.15]"
+              << " [--allocation-threshold 0.05] [--memory-threshold 0.10]" << std::endl;
+}
+
+static std::string read_file(const std::filesystem::path& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) {
+        throw std::invalid_argument("cannot open: " + path.string());
+    }
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    return ss.str();
+}
+
+static void load(const std::filesystem::path& path, rs274letter::tools::BenchCompare::ResultMap& result_map) {
+    try {
+        rs274letter::tools::BenchCompare::LoadResults(read_file(path), result_map);
+    } catch (std::exception& e) {
+        throw std::invalid_argument(path.string() + ": " + e.what());
+    }
+}
+
+int main(int argc, char** argv) {
+    using rs274letter::tools::BenchCompare;
+
+    BenchCompare::Options options;
+    std::filesystem::path baseline_path;
+    std::filesystem::path current_path;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 2;
+            }
+            std::string value = argv[++i];
+
+            if (arg == "--baseline") {
+                baseline_path = value;
+            } else if (arg == "--current") {
+                current_path = value;
+            } else if (arg == "--time-threshold") {
+                options.time_threshold = std::stod(value);
+            } else if (arg == "--allocation-threshold") {
+                options.allocation_threshold = std::stod(value);
+            } else if (arg == "--memory-threshold") {
+                options.memory_threshold = std::stod(value);
+            } else {
+                print_usage(argv[0]);
+                return 2;
+            }
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    if (baseline_path.empty() || current_path.empty()) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    BenchCompare::ResultMap baseline;
+    BenchCompare::ResultMap current;
+    try {
+        if (std::filesystem::is_directory(baseline_path)) {
+            for (auto&& entry : std::filesystem::directory_iterator(baseline_path)) {
+                auto file_name = entry.path().filename().string();
+                if (entry.path().extension() != ".json" || file_name.rfind("bench_", 0) != 0) continue;
+
+                load(entry.path(), baseline);
+                // a missing current file leaves its inputs missing
+                auto current_file = current_path / file_name;
+                if (std::filesystem::exists(current_file)) {
+                    load(current_file, current);
+                }
+            }
+        } else {
+            load(baseline_path, baseline);
+            load(current_path, current);
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+
+    if (baseline.empty()) {
+        std::cerr << "no benchmark result in the baseline: " << baseline_path.string() << std::endl;
+        return 2;
+    }
+
+    auto row_list = BenchCompare::Compare(baseline, current, options);
+    BenchCompare::PrintTable(std::cout, row_list);
+    return BenchCompare::HasFailure(row_list) ? 1 : 0;
+}
@@ -0,0 +1,67 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "tools/CorpusGenerator.h"
+
+// Writes a reproducible synthetic RS274 program for the benchmarks and the
+// stress tests, see CorpusGenerator.h for the block kinds.
+// usage: corpus_gen [--seed N] [--size 64K|10M|10G] [--mix linear=4,cam=2,nesting=1,subs=1,macros=2]
+//                   [--max-depth N] [--output FILE]
+
+static void print_usage(const char* name) {
+    std::cerr << "usage: " << name << " [--seed N] [--size BYTES[K|M|G]]"
+              << " [--mix linear=4,cam=2,nesting=1,subs=1,macros=2] [--max-depth N] [--output FILE]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    using rs274letter::tools::CorpusGenerator;
+
+    CorpusGenerator::Options options;
+    std::string output_file;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 2;
+            }
+            std::string value = argv[++i];
+
+            if (arg == "--seed") {
+                options.seed = std::stoull(value);
+            } else if (arg == "--size") {
+                options.target_bytes = CorpusGenerator::ParseSize(value);
+            } else if (arg == "--mix") {
+                options.mix = CorpusGenerator::ParseMix(value);
+            } else if (arg == "--max-depth") {
+                options.max_nesting_depth = static_cast<unsigned>(std::stoul(value));
+            } else if (arg == "--output") {
+                output_file = value;
+            } else {
+                print_usage(argv[0]);
+                return 2;
+            }
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    CorpusGenerator generator(options);
+    if (output_file.empty()) {
+        std::ios::sync_with_stdio(false);
+        generator.generate(std::cout);
+        return std::cout ? 0 : 1;
+    }
+
+    std::ofstream ofs(output_file, std::ios::binary);
+    if (!ofs.is_open()) {
+        std::cerr << "cannot open output file: " << output_file << std::endl;
+        return 1;
+    }
+    generator.generate(ofs);
+    return ofs ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "rs274letter/util.h"
+#include "tools/BatchRunner.h"
+
+// Checks many programs on all the cores, one JSON line for each file, see
+// BatchRunner.h. The paths are files or directories (searched recursively
+// for the extensions), and the lines of the --list files ("-" for stdin).
+// usage: rs274letter-batch [--list FILE] [--threads N] [--execute] [--lenient] [--no-dedup]
+//                          [--extensions .ngc,.nc] [--max-statements N] [--max-duration-ms N]
+//                          [--output FILE] [PATH]...
+// returns 0 if all the files pass, 1 if any fails, 2 on errors
+
+static void print_usage(const char* name) {
+    std::cerr << "usage: " << name << " [--list FILE] [--threads N] [--execute] [--lenient] [--no-dedup]"
+              << " [--extensions .ngc,.nc] [--max-statements N] [--max-duration-ms N]"
+              << " [--output FILE] [PATH]..." << std::endl;
+}
+
+static std::vector<std::string> split(const std::string& str, char delimiter) {
+    std::vector<std::string> part_list;
+    std::size_t pos = 0;
+    while (pos <= str.size()) {
+        auto end = str.find(delimiter, pos);
+        if (end == std::string::npos) end = str.size();
+        if (end > pos) part_list.push_back(str.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    return part_list;
+}
+
+static bool read_list(const std::string& list_file, std::vector<std::string>& path_list) {
+    std::ifstream ifs;
+    if (list_file != "-") {
+        ifs.open(list_file);
+        if (!ifs.is_open()) return false;
+    }
+    std::istream& is = list_file == "-" ? std::cin : ifs;
+
+    std::string line;
+    while (std::getline(is, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) path_list.push_back(line);
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    using rs274letter::tools::BatchRunner;
+
+    BatchRunner::Options options;
+    // a program without an end should not hold a worker forever
+    options.execution_budget.max_statements = 10'000'000;
+    options.execution_budget.max_duration = std::chrono::milliseconds(10'000);
+
+    std::vector<std::string> path_list;
+    std::vector<std::string> extension_list = { ".ngc", ".nc" };
+    std::string output_file;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing the value of " + arg);
+                return argv[++i];
+            };
+
+            if (arg == "--execute") {
+                options.execute = true;
+            } else if (arg == "--lenient") {
+                options.lenient = true;
+            } else if (arg == "--no-dedup") {
+                options.deduplicate = false;
+            } else if (arg == "--threads") {
+                options.thread_count = std::stoul(value());
+            } else if (arg == "--list") {
+                auto list_file = value();
+                if (!read_list(list_file, path_list)) {
+                    std::cerr << "cannot open: " << list_file << std::endl;
+                    return 2;
+                }
+            } else if (arg == "--extensions") {
+                extension_list = split(value(), ',');
+            } else if (arg == "--max-statements") {
+                options.execution_budget.max_statements = std::stoull(value());
+            } else if (arg == "--max-duration-ms") {
+                options.execution_budget.max_duration = std::chrono::milliseconds(std::stoull(value()));
+            } else if (arg == "--output") {
+                output_file = value();
+            } else if (!arg.empty() && arg[0] == '-') {
+                print_usage(argv[0]);
+                return 2;
+            } else {
+                path_list.push_back(arg);
+            }
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    if (path_list.empty()) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<std::string> file_list;
+    try {
+        file_list = BatchRunner::CollectFiles(path_list, extension_list);
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+
+    std::ofstream ofs;
+    if (!output_file.empty()) {
+        ofs.open(output_file);
+        if (!ofs.is_open()) {
+            std::cerr << "cannot open output file: " << output_file << std::endl;
+            return 2;
+        }
+    }
+    // the results go to their own stream, std::cout is discarded: the
+    // Parser prints the backtrace of a syntax error to it
+    std::ostream out(output_file.empty() ? std::cout.rdbuf() : ofs.rdbuf());
+    rs274letter::util::NullBuffer null_buffer;
+    auto* cout_buffer = std::cout.rdbuf(&null_buffer);
+    rs274letter::Tokenizer::SetPrintComments(false);
+
+    BatchRunner runner(options);
+    auto summary = runner.run(file_list, [&out](const BatchRunner::FileResult& result) {
+        out << BatchRunner::ToJsonLine(result) << '\n';
+    });
+    out.flush();
+    std::cout.rdbuf(cout_buffer);
+
+    auto seconds = summary.wall_ns / 1e9;
+    std::cerr << "files: " << summary.files
+              << ", duplicates: " << summary.duplicates
+              << ", failed: " << summary.failed
+              << ", steals: " << summary.steals
+              << ", time: " << seconds << " s"
+              << ", files/s: " << (seconds > 0 ? summary.files / seconds : 0.0) << std::endl;
+
+    if (!out) return 2;
+    return summary.failed == 0 ? 0 : 1;
+}